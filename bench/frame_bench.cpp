@@ -0,0 +1,135 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <SDL.h>
+#include "gl_backend.h"
+#include "movement_kernel.h"
+#include "thread_pool.h"
+#include "system_scheduler.h"
+#include "input_source.h"
+#include "sim_config.h"
+#include "level.h"
+
+/*
+ * Input source for benchmarks, nobody's pressing anything
+ */
+class IdleInput : public InputSource {
+public:
+	bool poll(uint64_t, SDL_Event&) override {
+		return false;
+	}
+};
+
+//Frames run before measuring so the pools and buffers have grown to size
+static const int WARMUP = 10;
+//The default level has 29 asteroids in a 10x10 field, bigger scenes grow the field
+//to keep the asteroids as spread out so the collision load scales with the count
+static const double DEFAULT_ASTEROIDS = 29;
+static const float DEFAULT_FIELD = 5.f;
+
+static double percentile(const std::vector<double> &sorted, double p){
+	const size_t i = static_cast<size_t>(std::ceil(p * sorted.size()));
+	return sorted[std::min(std::max(i, size_t{1}), sorted.size()) - 1];
+}
+/*
+ * Run a scene with some number of asteroids for a number of frames and
+ * write its results as a JSON object
+ */
+static void run_scene(size_t asteroids, int frames, uint64_t seed, bool last){
+	SimConfig config = SimConfig::fixed(seed, 1.0 / 60.0, true);
+	config.asteroids = asteroids;
+	config.field = DEFAULT_FIELD * static_cast<float>(std::sqrt(asteroids / DEFAULT_ASTEROIDS));
+
+	gl::MockBackend backend;
+	gl::set_backend(&backend);
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		Level level{config, std::make_shared<IdleInput>()};
+		level.start();
+		auto end = std::chrono::high_resolution_clock::now();
+		const double setup = std::chrono::duration<double>(end - start).count();
+		for (int i = 0; i < WARMUP; ++i){
+			level.step(config.tick);
+		}
+		backend.reset_stats();
+
+		const SystemScheduler &systems = level.systems();
+		std::vector<double> frame_times, system_times(systems.size(), 0);
+		for (int i = 0; i < frames; ++i){
+			start = std::chrono::high_resolution_clock::now();
+			level.step(config.tick);
+			end = std::chrono::high_resolution_clock::now();
+			frame_times.push_back(std::chrono::duration<double>(end - start).count());
+			for (size_t s = 0; s < systems.size(); ++s){
+				system_times[s] += systems.time(s);
+			}
+		}
+		double total = 0;
+		for (double t : frame_times){
+			total += t;
+		}
+		std::sort(frame_times.begin(), frame_times.end());
+		const double entities = static_cast<double>(level.entities());
+		const gl::Stats &stats = backend.stats();
+
+		std::cout << "\t\t{\n\t\t\t\"asteroids\": " << asteroids
+			<< ",\n\t\t\t\"entities\": " << level.entities()
+			<< ",\n\t\t\t\"field\": " << config.field
+			<< ",\n\t\t\t\"setup_ms\": " << setup * 1e3
+			<< ",\n\t\t\t\"frame_ms\": {\"mean\": " << total / frames * 1e3
+			<< ", \"p50\": " << percentile(frame_times, 0.5) * 1e3
+			<< ", \"p90\": " << percentile(frame_times, 0.9) * 1e3
+			<< ", \"p99\": " << percentile(frame_times, 0.99) * 1e3
+			<< ", \"max\": " << frame_times.back() * 1e3 << "},\n"
+			<< "\t\t\t\"systems\": [\n";
+		for (size_t s = 0; s < systems.size(); ++s){
+			const double mean = system_times[s] / frames;
+			std::cout << "\t\t\t\t{\"name\": \"" << systems.name(s) << "\", \"mean_ms\": " << mean * 1e3
+				<< ", \"ns_per_entity\": " << mean * 1e9 / entities << "}"
+				<< (s + 1 < systems.size() ? ",\n" : "\n");
+		}
+		std::cout << "\t\t\t],\n"
+			<< "\t\t\t\"bytes_uploaded_per_frame\": " << stats.bytes_uploaded / frames
+			<< ",\n\t\t\t\"draw_calls_per_frame\": " << stats.draw_calls / frames
+			<< ",\n\t\t\t\"state_hash\": \"" << std::hex << level.last_tick_hash() << std::dec << "\"\n"
+			<< "\t\t}" << (last ? "\n" : ",\n");
+	}
+	gl::set_backend(nullptr);
+}
+
+/*
+ * Run the full system pipeline headless on scenes of increasing size and
+ * report the per system cost, frame time percentiles and bytes uploaded to
+ * the (mock) GPU as JSON on stdout
+ * Usage: frame_bench [frames] [seed] [asteroids...]
+ */
+int main(int argc, char **argv){
+	const int frames = argc > 1 ? std::max(std::atoi(argv[1]), 1) : 120;
+	const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+	std::vector<size_t> scenes;
+	for (int i = 3; i < argc; ++i){
+		scenes.push_back(std::strtoul(argv[i], nullptr, 10));
+	}
+	if (scenes.empty()){
+		scenes = {1000, 10000, 100000, 1000000};
+	}
+	std::cout << std::fixed << std::setprecision(4)
+		<< "{\n\t\"frames\": " << frames
+		<< ",\n\t\"seed\": " << seed
+		<< ",\n\t\"isa\": \"" << kernel::isa_name(kernel::best_isa())
+		<< "\",\n\t\"workers\": " << ThreadPool::default_workers()
+		<< ",\n\t\"scenes\": [\n";
+	for (size_t i = 0; i < scenes.size(); ++i){
+		run_scene(scenes[i], frames, seed, i + 1 == scenes.size());
+	}
+	std::cout << "\t]\n}\n";
+	return 0;
+}
+
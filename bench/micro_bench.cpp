@@ -0,0 +1,335 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <string>
+#include <tuple>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <glm/glm.hpp>
+#include "gl_backend.h"
+#include "interleavedbuffer.h"
+#include "std140_array.h"
+#include "atlas_descriptor.h"
+#include "atlas_cache.h"
+#include "obj_parser.h"
+#include "util.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+ * Timing results for one benchmark, samples are the seconds taken by each
+ * repetition and items is the amount of work done per repetition, eg. the
+ * number of blocks written or faces parsed
+ */
+struct Result {
+	std::string name, unit;
+	double items, bytes;
+	std::vector<double> samples;
+};
+
+/*
+ * Run fn warmup times untimed then reps times timed, fn is called with the
+ * repetition number. Each repetition should do the same amount of work
+ */
+static Result measure(const std::string &name, const std::string &unit, double items, double bytes,
+	int warmup, int reps, const std::function<void(int)> &fn)
+{
+	Result r{name, unit, items, bytes, {}};
+	for (int i = 0; i < warmup; ++i){
+		fn(i);
+	}
+	for (int i = 0; i < reps; ++i){
+		auto start = std::chrono::high_resolution_clock::now();
+		fn(i);
+		auto end = std::chrono::high_resolution_clock::now();
+		r.samples.push_back(std::chrono::duration<double>(end - start).count());
+	}
+	return r;
+}
+/*
+ * Keep the compiler from dropping the work that produced v when the
+ * result isn't otherwise used
+ */
+template<typename T>
+static void do_not_optimize(const T &v){
+#ifdef _MSC_VER
+	//MSVC has no inline asm on x64, publishing the address through a volatile
+	//and fencing the compiler does the same job
+	static const void* volatile sink;
+	sink = &v;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "g"(&v) : "memory");
+#endif
+}
+static void write_json(const Result &r, bool last){
+	std::vector<double> s = r.samples;
+	std::sort(s.begin(), s.end());
+	double mean = 0;
+	for (double x : s){
+		mean += x;
+	}
+	mean /= s.size();
+	double var = 0;
+	for (double x : s){
+		var += (x - mean) * (x - mean);
+	}
+	const double stddev = s.size() > 1 ? std::sqrt(var / (s.size() - 1)) : 0;
+	const double median = s.size() % 2 ? s[s.size() / 2] : 0.5 * (s[s.size() / 2 - 1] + s[s.size() / 2]);
+	std::cout << "\t\t{\"name\": \"" << r.name << "\", \"reps\": " << s.size()
+		<< ", \"min_ms\": " << s.front() * 1e3 << ", \"median_ms\": " << median * 1e3
+		<< ", \"mean_ms\": " << mean * 1e3 << ", \"stddev_ms\": " << stddev * 1e3
+		<< ", \"" << r.unit << "_per_sec\": " << r.items / median;
+	if (r.bytes > 0){
+		std::cout << ", \"mb_per_sec\": " << r.bytes / median / 1e6;
+	}
+	std::cout << "}" << (last ? "\n" : ",\n");
+}
+
+//Blocks written by the buffer benchmarks, the same layout RenderBatch uses for instances
+static const size_t BLOCKS = 1 << 18;
+using InstanceBuffer = InterleavedBuffer<Layout::PACKED, glm::mat4, int>;
+
+static void bench_buffer_writes(std::vector<Result> &results){
+	InstanceBuffer buf(BLOCKS, GL_ARRAY_BUFFER, GL_STREAM_DRAW);
+	std::vector<std::tuple<glm::mat4, int>> src(BLOCKS);
+	for (size_t i = 0; i < BLOCKS; ++i){
+		src[i] = std::make_tuple(glm::mat4{static_cast<float>(i)}, static_cast<int>(i % 3));
+	}
+	//The same data already packed in the buffer's layout, for the memcpy baseline
+	std::vector<char> packed(BLOCKS * buf.stride());
+	for (size_t i = 0; i < BLOCKS; ++i){
+		std::memcpy(&packed[i * buf.stride()], &std::get<0>(src[i]), sizeof(glm::mat4));
+		std::memcpy(&packed[i * buf.stride() + buf.offset(1)], &std::get<1>(src[i]), sizeof(int));
+	}
+	const double bytes = static_cast<double>(packed.size());
+	results.push_back(measure("buffer_write_tuple", "blocks", BLOCKS, bytes, 3, 20, [&](int){
+		buf.map(GL_WRITE_ONLY);
+		for (size_t i = 0; i < BLOCKS; ++i){
+			buf.write(i, src[i]);
+		}
+		buf.unmap();
+	}));
+	results.push_back(measure("buffer_write_field", "blocks", BLOCKS, bytes, 3, 20, [&](int){
+		buf.map(GL_WRITE_ONLY);
+		for (size_t i = 0; i < BLOCKS; ++i){
+			buf.write<0>(i) = std::get<0>(src[i]);
+			buf.write<1>(i) = std::get<1>(src[i]);
+		}
+		buf.unmap();
+	}));
+	results.push_back(measure("buffer_write_memcpy", "blocks", BLOCKS, bytes, 3, 20, [&](int){
+		buf.bind();
+		void *dst = gl::backend().map_buffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
+		std::memcpy(dst, packed.data(), packed.size());
+		gl::backend().unmap_buffer(GL_ARRAY_BUFFER);
+	}));
+	//The other ways of getting the data into the buffer, compare with buffer_write_tuple
+	//for glMapBuffer. On the mock backend this is only the CPU side cost of each path
+	results.push_back(measure("buffer_upload_map_range", "blocks", BLOCKS, bytes, 3, 20, [&](int){
+		buf.map_range(0, BLOCKS, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		for (size_t i = 0; i < BLOCKS; ++i){
+			buf.write(i, src[i]);
+		}
+		buf.unmap();
+	}));
+	results.push_back(measure("buffer_upload_subdata", "blocks", BLOCKS, bytes, 3, 20, [&](int){
+		buf.bind();
+		gl::backend().buffer_sub_data(GL_ARRAY_BUFFER, 0, packed.size(), packed.data());
+	}));
+}
+
+//Elements converted by the std140 benchmarks
+static const size_t STD140_ELEMS = 4096;
+
+template<typename T>
+static void bench_std140(std::vector<Result> &results, const std::string &name){
+	std::unique_ptr<STD140Array<T, STD140_ELEMS>> arr{new STD140Array<T, STD140_ELEMS>};
+	std::vector<T> src(STD140_ELEMS, T{1.f}), dst(STD140_ELEMS);
+	results.push_back(measure("std140_write_" + name, "elems", STD140_ELEMS, 0, 10, 200, [&](int){
+		for (size_t i = 0; i < STD140_ELEMS; ++i){
+			arr->write(i, src[i]);
+		}
+		do_not_optimize(*arr);
+	}));
+	results.push_back(measure("std140_read_" + name, "elems", STD140_ELEMS, 0, 10, 200, [&](int){
+		for (size_t i = 0; i < STD140_ELEMS; ++i){
+			dst[i] = arr->read(i);
+		}
+		do_not_optimize(dst[0]);
+	}));
+}
+
+/*
+ * Write out an obj file of a grid of quads with positions, uvs and normals
+ * with at least faces faces, returns the number of faces written
+ */
+static size_t generate_obj(const std::string &file, size_t faces){
+	const size_t side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(faces))));
+	std::ofstream out(file);
+	for (size_t y = 0; y <= side; ++y){
+		for (size_t x = 0; x <= side; ++x){
+			out << "v " << x << " " << y << " 0\n"
+				<< "vt " << static_cast<float>(x) / side << " " << static_cast<float>(y) / side << "\n";
+		}
+	}
+	out << "vn 0 0 1\n";
+	const size_t row = side + 1;
+	for (size_t y = 0; y < side; ++y){
+		for (size_t x = 0; x < side; ++x){
+			const size_t a = y * row + x + 1, b = a + 1, c = a + row + 1, d = a + row;
+			out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+				<< c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+		}
+	}
+	return side * side;
+}
+static void bench_obj(std::vector<Result> &results, size_t max_faces){
+	for (size_t faces = 10000; faces <= max_faces; faces *= 10){
+		const std::string file = "micro_bench_" + std::to_string(faces) + ".obj";
+		const size_t written = generate_obj(file, faces);
+		std::ifstream in(file, std::ios::binary);
+		const std::string text{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+		const double bytes = static_cast<double>(text.size());
+		const int reps = faces >= 1000000 ? 5 : 10;
+		//Parsing from memory, then reading the file and uploading the mesh
+		MeshData mesh;
+		results.push_back(measure("obj_parse_" + std::to_string(faces), "faces", written, bytes,
+			1, reps, [&](int){
+				util::parse_obj(text.data(), text.size(), mesh);
+			}));
+		results.push_back(measure("obj_load_" + std::to_string(faces), "faces", written, bytes,
+			1, reps, [&](int){
+				InterleavedBuffer<Layout::PACKED, glm::vec3, glm::vec3, glm::vec3> vbo(0,
+					GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+				InterleavedBuffer<Layout::PACKED, GLuint> ebo(0, GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
+				size_t elems = 0;
+				util::load_obj(file, vbo, ebo, elems);
+			}));
+		std::remove(file.c_str());
+	}
+}
+
+/*
+ * Build an atlas document with n sprites in either the Kenney.nl or
+ * TexturePacker attribute format
+ */
+static std::string generate_atlas(size_t n, bool texture_packer){
+	std::ostringstream xml;
+	xml << "<TextureAtlas imagePath=\"sheet.png\">\n";
+	for (size_t i = 0; i < n; ++i){
+		const size_t x = (i % 64) * 32, y = (i / 64) * 32;
+		if (texture_packer){
+			xml << "\t<sprite n=\"sprite_" << i << "\" x=\"" << x << "\" y=\"" << y
+				<< "\" w=\"32\" h=\"32\"/>\n";
+		}
+		else {
+			xml << "\t<SubTexture name=\"sprite_" << i << "\" x=\"" << x << "\" y=\"" << y
+				<< "\" width=\"32\" height=\"32\"/>\n";
+		}
+	}
+	xml << "</TextureAtlas>\n";
+	return xml.str();
+}
+static void bench_atlas(std::vector<Result> &results, const std::string &cache_dir){
+	for (size_t n = 100; n <= 100000; n *= 10){
+		for (int tp = 0; tp < 2; ++tp){
+			const std::string xml = generate_atlas(n, tp == 1);
+			const std::string name = std::string{"atlas_parse_"} + (tp ? "texturepacker_" : "kenney_")
+				+ std::to_string(n);
+			AtlasDescriptor desc;
+			results.push_back(measure(name, "sprites", n, xml.size(), 3, n >= 100000 ? 5 : 20, [&](int){
+				desc.parse(xml.data(), xml.size());
+				do_not_optimize(desc.sprites);
+			}));
+		}
+	}
+	//The atlases shipped with the game, read from disk each time
+	for (const std::string f : {"alienBlue.xml", "tiles_spritesheet.xml"}){
+		const std::string file = util::get_resource_path() + f;
+		AtlasDescriptor desc;
+		if (!desc.load(file)){
+			continue;
+		}
+		std::ifstream in(file, std::ios::binary | std::ios::ate);
+		results.push_back(measure("atlas_load_" + f, "sprites", desc.sprites.size(),
+			static_cast<double>(in.tellg()), 3, 50, [&](int){
+				desc.load(file);
+			}));
+		//Loading through the cache, the first load cooks it if it's missing or stale
+		atlas_cache::load(file, cache_dir);
+		std::ifstream cached(atlas_cache::cache_path(file, cache_dir), std::ios::binary | std::ios::ate);
+		results.push_back(measure("atlas_cached_load_" + f, "sprites", desc.sprites.size(),
+			static_cast<double>(cached.tellg()), 3, 50, [&](int){
+				const atlas_cache::CachedAtlas atlas = atlas_cache::load(file, cache_dir);
+				do_not_optimize(atlas.size());
+			}));
+	}
+}
+
+/*
+ * Time the hot paths in buffer writes, std140 conversion and asset parsing,
+ * each benchmark is warmed up then repeated and the results are written as
+ * JSON to stdout. GL calls go to the MockBackend so only CPU costs are measured
+ * Usage: micro_bench [--max-faces n] [filter]
+ * Only benchmarks whose group name contains the filter are run, the groups
+ * are buffer, std140, obj and atlas. OBJ meshes go from 10k faces up to
+ * max-faces (default 1M) by powers of 10
+ */
+int main(int argc, char **argv){
+	size_t max_faces = 1000000;
+	std::string filter;
+	for (int i = 1; i < argc; ++i){
+		std::string arg = argv[i];
+		if (arg == "--max-faces" && i + 1 < argc){
+			max_faces = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else {
+			filter = arg;
+		}
+	}
+	auto run = [&](const std::string &group){
+		return filter.empty() || group.find(filter) != std::string::npos;
+	};
+	gl::MockBackend backend;
+	gl::set_backend(&backend);
+	std::vector<Result> results;
+	if (run("buffer")){
+		bench_buffer_writes(results);
+	}
+	if (run("std140")){
+		bench_std140<float>(results, "float");
+		bench_std140<glm::vec3>(results, "vec3");
+		bench_std140<glm::mat3>(results, "mat3");
+	}
+	if (run("obj")){
+		bench_obj(results, max_faces);
+	}
+	if (run("atlas")){
+		//Atlas caches are cooked next to the benchmark instead of into res/
+		const std::string exe = argv[0];
+		const size_t slash = exe.find_last_of("/\\");
+		bench_atlas(results, slash == std::string::npos ? "." : exe.substr(0, slash));
+	}
+	gl::set_backend(nullptr);
+
+	std::cout << std::fixed << std::setprecision(4) << "{\n\t\"backend\": \"mock\",\n\t\"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i){
+		write_json(results[i], i + 1 == results.size());
+	}
+	std::cout << "\t]\n}\n";
+	return 0;
+}
+
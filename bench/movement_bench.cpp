@@ -0,0 +1,69 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+#include <cstring>
+#include "cpu_features.h"
+#include "movement_kernel.h"
+
+/*
+ * Measure the throughput of each variant of the movement kernel supported
+ * by this CPU, in entity updates per second
+ * Usage: movement_bench [entities] [iterations]
+ */
+int main(int argc, char **argv){
+	const size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1 << 20;
+	const int iterations = argc > 2 ? std::atoi(argv[2]) : 200;
+	std::vector<float> init_pos(2 * n), vel(2 * n);
+	std::mt19937 gen{42};
+	std::uniform_real_distribution<float> pos_dist{-5, 5};
+	std::uniform_real_distribution<float> vel_dist{-0.5, 0.5};
+	for (size_t i = 0; i < 2 * n; ++i){
+		init_pos[i] = pos_dist(gen);
+		vel[i] = vel_dist(gen);
+	}
+	const kernel::Bounds bounds{glm::vec2{-5, -5}, glm::vec2{5, 5}};
+	const kernel::Isa isas[] = { kernel::Isa::SCALAR, kernel::Isa::SSE2,
+		kernel::Isa::AVX2, kernel::Isa::AVX512 };
+	std::cout << "Movement kernel, " << n << " entities, " << iterations << " iterations\n"
+		<< "Dispatch selects: " << kernel::isa_name(kernel::best_isa()) << "\n";
+
+	//The reference results from the scalar kernel, every variant should match it exactly
+	std::vector<float> reference[2];
+	for (int w = 0; w < 2; ++w){
+		const kernel::Bounds *wrap = w ? &bounds : nullptr;
+		for (kernel::Isa isa : isas){
+			if (!kernel::supported(isa)){
+				continue;
+			}
+			std::vector<float> pos = init_pos;
+			//Warm up the caches and page in the arrays
+			kernel::integrate(isa, pos.data(), vel.data(), n, 0.016f, wrap);
+			pos = init_pos;
+			auto start = std::chrono::high_resolution_clock::now();
+			for (int i = 0; i < iterations; ++i){
+				kernel::integrate(isa, pos.data(), vel.data(), n, 0.016f, wrap);
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			double sec = std::chrono::duration<double>(end - start).count();
+			double rate = n * static_cast<double>(iterations) / sec;
+
+			bool match = true;
+			if (isa == kernel::Isa::SCALAR){
+				reference[w] = pos;
+			}
+			else {
+				match = std::memcmp(pos.data(), reference[w].data(), pos.size() * sizeof(float)) == 0;
+			}
+			std::cout << std::setw(8) << kernel::isa_name(isa) << (wrap ? " wrap" : "     ")
+				<< ": " << std::fixed << std::setprecision(3) << rate / 1e9 << " G updates/s, "
+				<< std::setprecision(2) << sec / iterations * 1e3 << " ms/update"
+				<< (match ? "" : " MISMATCH vs scalar") << "\n";
+		}
+	}
+	return 0;
+}
+
@@ -0,0 +1,121 @@
+#ifndef ATLAS_CACHE_H
+#define ATLAS_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mapped_file.h"
+#include "atlas_descriptor.h"
+
+/*
+ * A binary cache of an atlas descriptor so atlases can be loaded without
+ * parsing XML. The file is a header followed by a flat array of sprite records,
+ * the uvs of each sprite for the atlas image's size, a perfect hash of the
+ * sprite names and a string table holding the image path and sprite names.
+ * Sprites are kept in document order and their index is the sprite's SpriteId.
+ * The header stores a hash of the XML document the cache was built from so stale
+ * caches are rebuilt when it changes. Like mesh caches these use the native byte
+ * order and aren't meant to be moved between machines
+ */
+namespace atlas_cache {
+	const uint32_t MAGIC = 0x534c5441;
+	const uint32_t VERSION = 2;
+	//Caches are named after their document with this extension, see util::cache_path
+	const char EXTENSION[] = ".atlas";
+
+	struct Header {
+		uint32_t magic, version;
+		uint64_t source_hash;
+		uint32_t sprite_count, image_width, image_height;
+		//Offset and length of the image path in the string table
+		uint32_t image, image_length;
+		//Sizes of the seeds and slots tables of the name hash, see perfect_hash
+		uint32_t hash_seeds, hash_slots, reserved;
+		uint64_t sprites_offset, uvs_offset, hash_offset, strings_offset, strings_size;
+	};
+	/*
+	 * A sprite's rect in pixels like AtlasSprite, with its name as an offset
+	 * and length in the string table
+	 */
+	struct Sprite {
+		uint32_t name, name_length;
+		int32_t x, y, w, h;
+		uint32_t rotated, reserved;
+	};
+
+	/*
+	 * A cooked atlas descriptor, either mapped from a cache file or built in memory
+	 */
+	class CachedAtlas {
+		std::unique_ptr<MappedFile> mapped;
+		std::vector<char> owned;
+		const char *data;
+		Header header;
+		bool valid;
+
+	public:
+		/*
+		 * Map a cache file and check that it's well formed
+		 */
+		CachedAtlas(const std::string &file);
+		/*
+		 * Take some cooked data that's already in memory
+		 */
+		CachedAtlas(std::vector<char> cooked);
+		bool good() const;
+		const Header& info() const;
+		size_t size() const;
+		/*
+		 * Get the path of the atlas image, relative to the XML document's folder
+		 */
+		std::string image() const;
+		const Sprite& sprite(size_t i) const;
+		std::string name(size_t i) const;
+		/*
+		 * Find the index of the sprite with some name through the name hash,
+		 * returns size() if there's no such sprite. If the document had
+		 * multiple sprites with the name the last one is found
+		 */
+		size_t find(const std::string &name) const;
+		/*
+		 * Get the uvs of a sprite for an image of image_width x image_height, in
+		 * the order { bottom left, bottom right, top left, top right }
+		 */
+		const glm::vec2* uvs(size_t i) const;
+		/*
+		 * Get a sprite as an AtlasSprite, without its name
+		 */
+		AtlasSprite atlas_sprite(size_t i) const;
+
+	private:
+		const uint32_t* hash_table() const;
+		void validate(size_t len);
+	};
+
+	/*
+	 * Get the path of the cache for an atlas document, the document's extension
+	 * is replaced with .atlas. The cache is put in cache_dir if one's given,
+	 * otherwise it goes next to the document
+	 */
+	std::string cache_path(const std::string &xml, const std::string &cache_dir = "");
+	/*
+	 * Cook an atlas descriptor, image is the image path relative to the document's
+	 * folder and width x height the image's size the uvs are computed for
+	 */
+	std::vector<char> cook(const AtlasDescriptor &desc, const std::string &image, uint64_t source_hash,
+		size_t width, size_t height);
+	/*
+	 * Load an atlas document through its cache. If the cache is missing or was
+	 * built from a different version of the document it's rebuilt from the XML,
+	 * if the document is missing the cache is used as is. The cache is kept in
+	 * cache_dir, or next to the document if it's empty. Check good() on the
+	 * result to see if loading worked
+	 */
+	CachedAtlas load(const std::string &xml, const std::string &cache_dir = "");
+}
+
+#endif
+
@@ -0,0 +1,59 @@
+#ifndef ATLAS_DESCRIPTOR_H
+#define ATLAS_DESCRIPTOR_H
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <tinyxml2.h>
+
+/*
+ * The sprites in a texture atlas as described by the xml document produced
+ * by the packing tool used by Kenny.nl or TexturePacker's generic XML format,
+ * see TextureAtlas for the document formats. Sprite rects are in pixels with
+ * [0, 0] at the top-left of the image, it's up to the atlas using them to
+ * convert to uvs once the image size is known. Rotated sprites are stored
+ * turned 90 degrees clockwise in the image, as TexturePacker does, w and h
+ * are always the size of the sprite upright
+ */
+struct AtlasSprite {
+	std::string name;
+	int x, y, w, h;
+	bool rotated;
+
+	/*
+	 * Get the corners of the sprite in the image in pixels, in the order
+	 * { bottom left, bottom right, top left, top right } of the sprite upright
+	 */
+	std::array<glm::vec2, 4> corners() const;
+	/*
+	 * Get the uvs of the sprite's corners in an image of size dim, in
+	 * the same order as corners
+	 */
+	std::array<glm::vec2, 4> uvs(const glm::vec2 &dim) const;
+};
+struct AtlasDescriptor {
+	//Path of the atlas image, the imagePath in the document is taken
+	//relative to the folder the document is in
+	std::string image;
+	std::vector<AtlasSprite> sprites;
+
+	/*
+	 * Read the descriptor from an xml file, returns false if the file
+	 * couldn't be read or isn't an atlas document
+	 */
+	bool load(const std::string &file);
+	/*
+	 * Parse the descriptor from an xml document in memory, the image path is
+	 * taken relative to dir. Only the first TextureAtlas element is read
+	 */
+	bool parse(const char *xml, size_t len, const std::string &dir = "");
+};
+/*
+ * Map tinyxml errors to printable strings
+ */
+std::string get_xml_error(const tinyxml2::XMLError &error);
+
+#endif
+
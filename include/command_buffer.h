@@ -0,0 +1,101 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <vector>
+#include "gl_core_3_3.h"
+#include "gl_backend.h"
+
+namespace gl {
+/*
+ * A backend that records the calls made through it so they can be replayed
+ * later to some other backend, eg. the real context or a MockBackend
+ * Data passed to buffer_data/buffer_sub_data is copied into the command
+ * buffer so the caller's memory doesn't need to outlive the recording
+ *
+ * Calls that need a result immediately (gen/map/unmap) can't be deferred,
+ * so the pending commands are submitted to the target backend before
+ * forwarding the call to it directly
+ */
+class CommandBuffer : public Backend {
+	enum class Op {
+		DELETE_BUFFER, BIND_BUFFER, BIND_BUFFER_BASE, BUFFER_DATA, BUFFER_SUB_DATA,
+		COPY_BUFFER_SUB_DATA, FLUSH_MAPPED_BUFFER_RANGE, DELETE_VERTEX_ARRAY, BIND_VERTEX_ARRAY,
+		ENABLE_VERTEX_ATTRIB_ARRAY, VERTEX_ATTRIB_POINTER, VERTEX_ATTRIB_IPOINTER,
+		VERTEX_ATTRIB_DIVISOR, DRAW_ELEMENTS_INSTANCED
+	};
+	/*
+	 * A recorded call, the meaning of the arguments depends on the op
+	 * if the call has data its located at payload offset in the payload
+	 * buffer, otherwise the offset is -1
+	 */
+	struct Command {
+		Op op;
+		GLenum e0, e1;
+		GLint64 a0, a1, a2, a3;
+		size_t payload;
+	};
+	Backend &target;
+	std::vector<Command> commands;
+	std::vector<char> payloads;
+
+public:
+	/*
+	 * Create a command buffer that will submit its commands to the target backend
+	 */
+	CommandBuffer(Backend &target);
+	/*
+	 * Replay all recorded commands to the target and clear the recording
+	 */
+	void submit();
+	/*
+	 * Replay all recorded commands to some backend, the recording is kept
+	 * so it can be replayed again
+	 */
+	void replay(Backend &b) const;
+	/*
+	 * Drop all recorded commands without replaying them
+	 */
+	void clear();
+	/*
+	 * Get the number of commands waiting to be submitted
+	 */
+	size_t size() const;
+	void gen_buffers(GLsizei n, GLuint *buffers) override;
+	void delete_buffers(GLsizei n, const GLuint *buffers) override;
+	void bind_buffer(GLenum target, GLuint buffer) override;
+	void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) override;
+	void buffer_data(GLenum target, GLsizeiptr size, const void *data, GLenum usage) override;
+	void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) override;
+	void copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+		GLintptr write_offset, GLsizeiptr size) override;
+	void* map_buffer(GLenum target, GLenum access) override;
+	void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+	void flush_mapped_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length) override;
+	GLboolean unmap_buffer(GLenum target) override;
+	void gen_vertex_arrays(GLsizei n, GLuint *arrays) override;
+	void delete_vertex_arrays(GLsizei n, const GLuint *arrays) override;
+	void bind_vertex_array(GLuint array) override;
+	void enable_vertex_attrib_array(GLuint index) override;
+	void vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+		GLsizei stride, const void *offset) override;
+	void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+		const void *offset) override;
+	void vertex_attrib_divisor(GLuint index, GLuint divisor) override;
+	void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+		GLsizei instances) override;
+
+private:
+	/*
+	 * Record a command, copying size bytes of data into the payload buffer if data isn't null
+	 */
+	void record(Op op, GLenum e0, GLenum e1, GLint64 a0, GLint64 a1, GLint64 a2, GLint64 a3,
+		const void *data = nullptr, size_t size = 0);
+	/*
+	 * Replay a single command to the backend
+	 */
+	void execute(const Command &c, Backend &b) const;
+};
+}
+
+#endif
+
@@ -0,0 +1,255 @@
+#ifndef COMPONENT_POOL_H
+#define COMPONENT_POOL_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <entityx/entityx.h>
+#include "sequence.h"
+#include "type_index.h"
+
+/*
+ * Dense storage for a group of components that are always present together
+ * on an entity. Each component type is stored in its own packed array and the
+ * arrays share a single sparse set mapping entity index -> packed index, so
+ * element i of every array belongs to the same entity, id(i). Systems can
+ * iterate the packed arrays directly instead of looking up each component
+ * through the entity's component pointers
+ *
+ * Removing an entity moves the last element into its slot, so the packed
+ * order is only stable while no entities are removed. The pool should be
+ * subscribed to EntityDestroyedEvent so destroyed entities are dropped from it
+ */
+template<typename... Components>
+class ComponentPool : public entityx::Receiver<ComponentPool<Components...>> {
+	static const uint32_t npos = std::numeric_limits<uint32_t>::max();
+	//Maps an entity index to its index in the packed arrays, npos if not in the pool
+	std::vector<uint32_t> sparse;
+	std::vector<entityx::Entity::Id> ids;
+	std::tuple<std::vector<Components>...> components;
+
+public:
+	/*
+	 * Reserve room for n entities in the packed arrays, entity indices are
+	 * recycled so this also covers the sparse set for n live entities
+	 */
+	void reserve(size_t n){
+		sparse.reserve(n);
+		ids.reserve(n);
+		apply(Reserve{n}, typename detail::GenSequence<sizeof...(Components)>::seq{});
+	}
+	/*
+	 * Add an entity to the pool with some initial component values
+	 * if the entity is already in the pool its components are replaced
+	 */
+	void assign(entityx::Entity::Id id, const Components&... c){
+		if (has(id)){
+			set(sparse[id.index()], std::make_tuple(c...),
+				typename detail::GenSequence<sizeof...(Components)>::seq{});
+			return;
+		}
+		if (id.index() >= sparse.size()){
+			sparse.resize(id.index() + 1, npos);
+		}
+		sparse[id.index()] = ids.size();
+		ids.push_back(id);
+		push(std::make_tuple(c...), typename detail::GenSequence<sizeof...(Components)>::seq{});
+	}
+	/*
+	 * Remove an entity from the pool, does nothing if the entity isn't in the pool
+	 */
+	void remove(entityx::Entity::Id id){
+		if (!has(id)){
+			return;
+		}
+		size_t i = sparse[id.index()];
+		size_t last = ids.size() - 1;
+		if (i != last){
+			ids[i] = ids[last];
+			sparse[ids[i].index()] = i;
+		}
+		ids.pop_back();
+		sparse[id.index()] = npos;
+		apply(SwapRemove{i}, typename detail::GenSequence<sizeof...(Components)>::seq{});
+	}
+	/*
+	 * Swap the entities at packed indices i and j, used to reorder the pool
+	 */
+	void swap(size_t i, size_t j){
+		assert(i < ids.size() && j < ids.size());
+		if (i == j){
+			return;
+		}
+		std::swap(ids[i], ids[j]);
+		sparse[ids[i].index()] = i;
+		sparse[ids[j].index()] = j;
+		apply(Swap{i, j}, typename detail::GenSequence<sizeof...(Components)>::seq{});
+	}
+	/*
+	 * Remove all entities from the pool, the capacity of the packed arrays is kept
+	 */
+	void clear(){
+		sparse.clear();
+		ids.clear();
+		apply(Clear{}, typename detail::GenSequence<sizeof...(Components)>::seq{});
+	}
+	/*
+	 * Check if some entity is in the pool
+	 */
+	bool has(entityx::Entity::Id id) const {
+		return id.index() < sparse.size() && sparse[id.index()] != npos
+			&& ids[sparse[id.index()]] == id;
+	}
+	/*
+	 * Get the packed index of some entity in the pool, the entity must be in the pool
+	 */
+	size_t index(entityx::Entity::Id id) const {
+		assert(has(id));
+		return sparse[id.index()];
+	}
+	/*
+	 * Get the id of the entity at packed index i
+	 */
+	entityx::Entity::Id id(size_t i) const {
+		assert(i < ids.size());
+		return ids[i];
+	}
+	/*
+	 * Get the packed array of entity ids, the array has size() elements
+	 */
+	const entityx::Entity::Id* id_data() const {
+		return ids.data();
+	}
+	/*
+	 * Replace the contents of the pool with n entities, the packed component arrays
+	 * are resized to n and left for the caller to fill in through data<T>(). Used
+	 * to restore a pool in bulk, eg. from a snapshot
+	 */
+	void assign_ids(const entityx::Entity::Id *new_ids, size_t n){
+		ids.assign(new_ids, new_ids + n);
+		uint32_t max_index = 0;
+		for (const auto &id : ids){
+			max_index = std::max(max_index, id.index());
+		}
+		sparse.assign(n > 0 ? max_index + 1 : 0, npos);
+		for (size_t i = 0; i < n; ++i){
+			sparse[ids[i].index()] = i;
+		}
+		apply(Resize{n}, typename detail::GenSequence<sizeof...(Components)>::seq{});
+	}
+	/*
+	 * Get component T of some entity, the entity must be in the pool
+	 */
+	template<typename T>
+	T& get(entityx::Entity::Id id){
+		return std::get<detail::IndexOf<T, Components...>::value>(components)[index(id)];
+	}
+	template<typename T>
+	const T& get(entityx::Entity::Id id) const {
+		return std::get<detail::IndexOf<T, Components...>::value>(components)[index(id)];
+	}
+	/*
+	 * Get the packed array of component T, the array has size() elements
+	 */
+	template<typename T>
+	T* data(){
+		return std::get<detail::IndexOf<T, Components...>::value>(components).data();
+	}
+	template<typename T>
+	const T* data() const {
+		return std::get<detail::IndexOf<T, Components...>::value>(components).data();
+	}
+	/*
+	 * Get the number of entities in the pool
+	 */
+	size_t size() const {
+		return ids.size();
+	}
+	/*
+	 * Drop destroyed entities from the pool
+	 */
+	void receive(const entityx::EntityDestroyedEvent &e){
+		remove(e.entity.id());
+	}
+
+private:
+	struct Reserve {
+		size_t n;
+
+		template<typename V>
+		void operator()(V &v) const {
+			v.reserve(n);
+		}
+	};
+	struct Resize {
+		size_t n;
+
+		template<typename V>
+		void operator()(V &v) const {
+			v.resize(n);
+		}
+	};
+	//Move the last element into i and drop the last element
+	struct SwapRemove {
+		size_t i;
+
+		template<typename V>
+		void operator()(V &v) const {
+			if (i != v.size() - 1){
+				v[i] = std::move(v.back());
+			}
+			v.pop_back();
+		}
+	};
+	struct Swap {
+		size_t i, j;
+
+		template<typename V>
+		void operator()(V &v) const {
+			std::swap(v[i], v[j]);
+		}
+	};
+	struct Clear {
+		template<typename V>
+		void operator()(V &v) const {
+			v.clear();
+		}
+	};
+	/*
+	 * Apply some function to each of the packed component arrays
+	 */
+	template<typename F, int N, int... S>
+	void apply(const F &f, detail::Sequence<N, S...>){
+		f(std::get<N>(components));
+		apply(f, detail::Sequence<S...>{});
+	}
+	template<typename F>
+	void apply(const F&, detail::Sequence<>){}
+	/*
+	 * Recursively push the tuple values onto the back of each packed array
+	 */
+	template<int N, int... S>
+	void push(const std::tuple<Components...> &c, detail::Sequence<N, S...>){
+		std::get<N>(components).push_back(std::get<N>(c));
+		push(c, detail::Sequence<S...>{});
+	}
+	void push(const std::tuple<Components...>&, detail::Sequence<>){}
+	/*
+	 * Recursively set the components at packed index i to the tuple values
+	 */
+	template<int N, int... S>
+	void set(size_t i, const std::tuple<Components...> &c, detail::Sequence<N, S...>){
+		std::get<N>(components)[i] = std::get<N>(c);
+		set(i, c, detail::Sequence<S...>{});
+	}
+	void set(size_t, const std::tuple<Components...>&, detail::Sequence<>){}
+};
+template<typename... Components>
+const uint32_t ComponentPool<Components...>::npos;
+
+#endif
+
@@ -0,0 +1,23 @@
+#ifndef COLLIDABLE_H
+#define COLLIDABLE_H
+
+#include <entityx/entityx.h>
+#include "component_pool.h"
+
+/*
+ * Marks an entity as taking part in collision detection, entities are
+ * treated as circles around their position
+ */
+struct Collidable : entityx::Component<Collidable> {
+	float radius;
+
+	Collidable(float radius = 0.5f) : radius(radius) {}
+};
+
+/*
+ * Pooled storage for the collision shapes of entities
+ */
+using Colliders = ComponentPool<Collidable>;
+
+#endif
+
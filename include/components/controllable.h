@@ -3,13 +3,16 @@
 
 #include <SDL.h>
 #include <entityx/entityx.h>
+#include "components/velocity.h"
 
 //TODO: Configurable acceleration for the component?
 struct Controllable : entityx::Component<Controllable> {
 	bool enabled;
+	//If the entity is holding down the fire button
+	bool firing;
 
 	Controllable(bool enabled = true);
-	void control(entityx::Entity &entity, const SDL_Event &event);
+	void control(Velocity &vel, const SDL_Event &event);
 };
 
 #endif
@@ -0,0 +1,16 @@
+#ifndef KINEMATICS_H
+#define KINEMATICS_H
+
+#include "component_pool.h"
+#include "components/position.h"
+#include "components/velocity.h"
+
+/*
+ * Pooled storage for the position and velocity of moving entities
+ * these are stored densely so the movement integration can run straight
+ * over the packed arrays
+ */
+using Kinematics = ComponentPool<Position, Velocity>;
+
+#endif
+
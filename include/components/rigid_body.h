@@ -0,0 +1,41 @@
+#ifndef RIGID_BODY_H
+#define RIGID_BODY_H
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <glm/glm.hpp>
+#include <entityx/entityx.h>
+#include "component_pool.h"
+
+/*
+ * Makes a collidable entity respond to collisions. Bodies only move linearly,
+ * there's no rotation. A body's shape is either a circle using its Collidable
+ * radius or a convex polygon given in counter clockwise order around its
+ * position, the Collidable radius should then bound the polygon
+ */
+struct RigidBody : entityx::Component<RigidBody> {
+	static const uint32_t MAX_VERTICES = 8;
+	//Static bodies have an inverse mass of 0
+	float inv_mass, restitution;
+	uint32_t vertex_count;
+	glm::vec2 vertices[MAX_VERTICES];
+
+	RigidBody(float inv_mass = 1.f, float restitution = 0.5f)
+		: inv_mass(inv_mass), restitution(restitution), vertex_count(0)
+	{}
+	RigidBody(float inv_mass, float restitution, std::initializer_list<glm::vec2> polygon)
+		: inv_mass(inv_mass), restitution(restitution),
+		vertex_count(std::min<uint32_t>(polygon.size(), MAX_VERTICES))
+	{
+		std::copy(polygon.begin(), polygon.begin() + vertex_count, vertices);
+	}
+};
+
+/*
+ * Pooled storage for rigid bodies
+ */
+using Bodies = ComponentPool<RigidBody>;
+
+#endif
+
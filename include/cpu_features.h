@@ -0,0 +1,19 @@
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+/*
+ * The instruction set extensions we have optimized kernels for
+ * A feature is only reported if both the CPU and the OS support it,
+ * eg. AVX needs the OS to save the ymm registers on context switch
+ */
+struct CpuFeatures {
+	bool sse2, avx2, avx512f;
+};
+/*
+ * Query the features of the CPU we're running on, this is only
+ * done once and the result is cached
+ */
+const CpuFeatures& cpu_features();
+
+#endif
+
@@ -0,0 +1,61 @@
+#ifndef ENTITY_POOL_H
+#define ENTITY_POOL_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <entityx/entityx.h>
+
+/*
+ * Batches creation and destruction of entities that are spawned and despawned
+ * frequently, eg. bullets and debris. entityx recycles the indices of destroyed
+ * entities so reserving up front lets the entity manager's storage grow once
+ * instead of during play, and the pooled components should be reserved to
+ * match so assigning them doesn't allocate either
+ *
+ * Despawns are queued and applied together by flush at the end of the frame so
+ * systems can despawn entities while others may still be looking at them.
+ * Queueing a despawn is thread safe
+ */
+class EntityPool {
+	entityx::ptr<entityx::EntityManager> entities;
+	std::mutex despawn_mutex;
+	std::vector<entityx::Entity::Id> despawns;
+
+public:
+	EntityPool(entityx::ptr<entityx::EntityManager> entities);
+	/*
+	 * Make sure the entity manager has room for n live entities
+	 */
+	void reserve(size_t n);
+	/*
+	 * Create n entities, appending them to out
+	 */
+	void create(size_t n, std::vector<entityx::Entity> &out);
+	/*
+	 * Queue an entity to be destroyed at the next flush, despawning an entity
+	 * multiple times or one that's already been destroyed is fine
+	 */
+	void despawn(entityx::Entity::Id id);
+	void despawn(const std::vector<entityx::Entity::Id> &ids);
+	/*
+	 * Destroy all the queued entities, returns the number destroyed
+	 */
+	size_t flush();
+	/*
+	 * Get the number of despawns waiting for the next flush
+	 */
+	size_t pending();
+	/*
+	 * Assign a tag component that has no data, every entity shares one instance
+	 * of the tag so tagging doesn't allocate
+	 */
+	template<typename C>
+	static void tag(entityx::Entity &e){
+		static const entityx::ptr<C> shared = std::make_shared<C>();
+		e.assign<C>(shared);
+	}
+};
+
+#endif
+
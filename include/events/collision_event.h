@@ -0,0 +1,16 @@
+#ifndef COLLISION_EVENT_H
+#define COLLISION_EVENT_H
+
+#include <entityx/entityx.h>
+
+/*
+ * Emitted when the collision shapes of two entities overlap
+ */
+struct CollisionEvent : public entityx::Event<CollisionEvent> {
+	entityx::Entity::Id a, b;
+
+	CollisionEvent(entityx::Entity::Id a, entityx::Entity::Id b) : a(a), b(b) {}
+};
+
+#endif
+
@@ -0,0 +1,167 @@
+#ifndef GL_BACKEND_H
+#define GL_BACKEND_H
+
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include "gl_core_3_3.h"
+
+namespace gl {
+/*
+ * Counters for the work submitted to a backend
+ * calls: total number of calls made through the backend
+ * bytes_uploaded: bytes sent from the host to buffer storage, either through
+ * buffer_data/buffer_sub_data or by writing into a mapped range
+ * bytes_copied: bytes moved between buffers on the device
+ * state_changes: binds that actually changed what was bound and vertex
+ * attribute setup calls
+ * draw_calls/instances: number of draws issued and instances drawn by them
+ */
+struct Stats {
+	size_t calls, bytes_uploaded, bytes_copied, state_changes, draw_calls, instances;
+
+	Stats();
+	void reset();
+};
+/*
+ * Interface for the subset of OpenGL used by InterleavedBuffer, RenderBatch
+ * and Model. Sending these calls through a backend lets us replay them to the
+ * real context, record them for later or just count them without any context at all
+ */
+class Backend {
+public:
+	virtual ~Backend(){}
+	virtual void gen_buffers(GLsizei n, GLuint *buffers) = 0;
+	virtual void delete_buffers(GLsizei n, const GLuint *buffers) = 0;
+	virtual void bind_buffer(GLenum target, GLuint buffer) = 0;
+	virtual void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) = 0;
+	virtual void buffer_data(GLenum target, GLsizeiptr size, const void *data, GLenum usage) = 0;
+	virtual void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) = 0;
+	virtual void copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+		GLintptr write_offset, GLsizeiptr size) = 0;
+	virtual void* map_buffer(GLenum target, GLenum access) = 0;
+	virtual void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) = 0;
+	virtual void flush_mapped_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length) = 0;
+	virtual GLboolean unmap_buffer(GLenum target) = 0;
+	virtual void gen_vertex_arrays(GLsizei n, GLuint *arrays) = 0;
+	virtual void delete_vertex_arrays(GLsizei n, const GLuint *arrays) = 0;
+	virtual void bind_vertex_array(GLuint array) = 0;
+	virtual void enable_vertex_attrib_array(GLuint index) = 0;
+	virtual void vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+		GLsizei stride, const void *offset) = 0;
+	virtual void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+		const void *offset) = 0;
+	virtual void vertex_attrib_divisor(GLuint index, GLuint divisor) = 0;
+	virtual void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+		GLsizei instances) = 0;
+};
+/*
+ * Backend that forwards everything straight to the current OpenGL context
+ */
+class GLBackend : public Backend {
+public:
+	void gen_buffers(GLsizei n, GLuint *buffers) override;
+	void delete_buffers(GLsizei n, const GLuint *buffers) override;
+	void bind_buffer(GLenum target, GLuint buffer) override;
+	void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) override;
+	void buffer_data(GLenum target, GLsizeiptr size, const void *data, GLenum usage) override;
+	void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) override;
+	void copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+		GLintptr write_offset, GLsizeiptr size) override;
+	void* map_buffer(GLenum target, GLenum access) override;
+	void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+	void flush_mapped_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length) override;
+	GLboolean unmap_buffer(GLenum target) override;
+	void gen_vertex_arrays(GLsizei n, GLuint *arrays) override;
+	void delete_vertex_arrays(GLsizei n, const GLuint *arrays) override;
+	void bind_vertex_array(GLuint array) override;
+	void enable_vertex_attrib_array(GLuint index) override;
+	void vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+		GLsizei stride, const void *offset) override;
+	void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+		const void *offset) override;
+	void vertex_attrib_divisor(GLuint index, GLuint divisor) override;
+	void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+		GLsizei instances) override;
+};
+/*
+ * Backend that doesn't need a context, it only keeps host side storage for
+ * buffers so they can be mapped and written to and counts the calls made,
+ * bytes uploaded and state changes. Meant for CPU only tests and benchmarks
+ * of the render path
+ */
+class MockBackend : public Backend {
+	struct Buffer {
+		std::vector<char> data;
+		//Mapped range of the buffer, if it's not mapped map_length is 0
+		size_t map_offset, map_length;
+		GLbitfield map_access;
+
+		Buffer();
+	};
+	GLuint next_name;
+	std::unordered_map<GLuint, Buffer> buffers;
+	//The buffer currently bound to each target
+	std::unordered_map<GLenum, GLuint> bound;
+	//The buffer bound to each indexed binding point, keyed by target << 32 | index
+	std::unordered_map<uint64_t, GLuint> bound_indexed;
+	GLuint bound_vao;
+	Stats stats_;
+
+public:
+	MockBackend();
+	void gen_buffers(GLsizei n, GLuint *buffers) override;
+	void delete_buffers(GLsizei n, const GLuint *buffers) override;
+	void bind_buffer(GLenum target, GLuint buffer) override;
+	void bind_buffer_base(GLenum target, GLuint index, GLuint buffer) override;
+	void buffer_data(GLenum target, GLsizeiptr size, const void *data, GLenum usage) override;
+	void buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) override;
+	void copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+		GLintptr write_offset, GLsizeiptr size) override;
+	void* map_buffer(GLenum target, GLenum access) override;
+	void* map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) override;
+	void flush_mapped_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length) override;
+	GLboolean unmap_buffer(GLenum target) override;
+	void gen_vertex_arrays(GLsizei n, GLuint *arrays) override;
+	void delete_vertex_arrays(GLsizei n, const GLuint *arrays) override;
+	void bind_vertex_array(GLuint array) override;
+	void enable_vertex_attrib_array(GLuint index) override;
+	void vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+		GLsizei stride, const void *offset) override;
+	void vertex_attrib_ipointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+		const void *offset) override;
+	void vertex_attrib_divisor(GLuint index, GLuint divisor) override;
+	void draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+		GLsizei instances) override;
+	/*
+	 * Get the counters collected since creation or the last reset
+	 */
+	const Stats& stats() const;
+	void reset_stats();
+	/*
+	 * Get the host side contents of some buffer, returns nullptr if
+	 * the buffer doesn't exist
+	 */
+	const std::vector<char>* contents(GLuint buffer) const;
+
+private:
+	/*
+	 * Get the buffer bound to some target, asserts that one is bound
+	 */
+	Buffer& bound_buffer(GLenum target);
+};
+/*
+ * Get the backend used by InterleavedBuffer, RenderBatch and Model
+ * by default this is a GLBackend talking to the current context
+ */
+Backend& backend();
+/*
+ * Change the backend being used, passing nullptr will restore the default
+ * GLBackend. The caller keeps ownership of the backend and must keep it alive
+ * while it's in use
+ */
+void set_backend(Backend *b);
+}
+
+#endif
+
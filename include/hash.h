@@ -0,0 +1,17 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace util {
+	const uint64_t FNV_OFFSET = 0xcbf29ce484222325ull;
+	/*
+	 * Hash some bytes with 64 bit FNV-1a, pass the previous hash to continue
+	 * hashing across multiple calls
+	 */
+	uint64_t fnv1a(const void *data, size_t n, uint64_t hash = FNV_OFFSET);
+}
+
+#endif
+
@@ -0,0 +1,122 @@
+#ifndef INPUT_SOURCE_H
+#define INPUT_SOURCE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <SDL.h>
+
+/*
+ * Where the InputSystem gets its events from each tick
+ */
+class InputSource {
+public:
+	virtual ~InputSource(){}
+	/*
+	 * Get the next event for some tick, returns false once there are no
+	 * more events for the tick
+	 */
+	virtual bool poll(uint64_t tick, SDL_Event &e) = 0;
+	/*
+	 * Check if the source has run out of input, live sources never do
+	 */
+	virtual bool finished(uint64_t tick) const;
+};
+/*
+ * Reads events from SDL
+ */
+class SDLInputSource : public InputSource {
+public:
+	bool poll(uint64_t tick, SDL_Event &e) override;
+};
+
+/*
+ * The input log is a header followed by fixed size records, one per event.
+ * Only the event fields the game looks at are kept: the type and for key
+ * events the key and repeat flag. The seed and tick length of the recorded
+ * run are stored so a replay can recreate the same world and the log ends
+ * with an END record at the tick recording stopped on
+ */
+namespace input_log {
+	const uint32_t MAGIC = 0x31524941;
+	const uint32_t VERSION = 1;
+	const uint32_t END = 0xffffffff;
+
+	struct Header {
+		uint32_t magic, version;
+		uint64_t seed;
+		double tick;
+	};
+	struct Record {
+		uint64_t tick;
+		//SDL timestamp of the event in milliseconds
+		uint32_t timestamp;
+		uint32_t type;
+		int32_t key;
+		uint32_t repeat;
+	};
+}
+
+/*
+ * Records the events read from another source to an input log
+ */
+class InputRecorder : public InputSource {
+	std::shared_ptr<InputSource> source;
+	std::ofstream log;
+	uint64_t last_tick;
+
+public:
+	/*
+	 * Start recording to some file, the seed and tick length should be those
+	 * of the deterministic run being recorded
+	 */
+	InputRecorder(const std::shared_ptr<InputSource> &source, const std::string &file,
+		uint64_t seed, double tick);
+	/*
+	 * Write the END record and close the log
+	 */
+	~InputRecorder();
+	bool poll(uint64_t tick, SDL_Event &e) override;
+	bool finished(uint64_t tick) const override;
+	/*
+	 * Check if the log was opened successfully
+	 */
+	bool good() const;
+};
+
+/*
+ * Plays back an input log, the events are returned on the same ticks
+ * they were recorded on
+ */
+class InputReplay : public InputSource {
+	input_log::Header header;
+	std::ifstream log;
+	input_log::Record next;
+	bool loaded;
+
+public:
+	/*
+	 * Open an input log for replay, check good() to see if the log was
+	 * read successfully
+	 */
+	InputReplay(const std::string &file);
+	bool poll(uint64_t tick, SDL_Event &e) override;
+	/*
+	 * The replay is finished after the tick the recording ended on
+	 */
+	bool finished(uint64_t tick) const override;
+	bool good() const;
+	uint64_t seed() const;
+	double tick_length() const;
+
+private:
+	/*
+	 * Read the next record into next, if reading fails an END record
+	 * at the last tick read is substituted
+	 */
+	void read_next();
+};
+
+#endif
+
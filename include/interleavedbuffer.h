@@ -6,6 +6,8 @@
 #include <memory>
 #include <tuple>
 #include "gl_core_3_3.h"
+#include "gl_backend.h"
+#include "memory_tracker.h"
 #include "sequence.h"
 #include "type_at.h"
 #include "ptr_tuple.h"
@@ -56,19 +58,15 @@ public:
 		mode(0), type(type), access(access), data(nullptr), map_start(0), map_end(0),
 		offsets(Offset::offsets()), allow_name_change(allow_name_change)
 	{
-		glGenBuffers(1, &buffer);
-		glBindBuffer(type, buffer);
+		gl::backend().gen_buffers(1, &buffer);
+		gl::backend().bind_buffer(type, buffer);
 		if (capacity > 0){
-			glBufferData(type, capacity * stride_, NULL, access);
+			gl::backend().buffer_data(type, capacity * stride_, NULL, access);
+			memtrack::gpu_alloc(memtrack::Gpu::BUFFER, capacity * stride_);
 		}
 	}
 	~InterleavedBuffer(){
-		//If they forgot to unmap the buffer and we're the last one using it
-		if (data != nullptr){
-			bind(bound_target);
-			glUnmapBuffer(type);
-		}
-		glDeleteBuffers(1, &buffer);
+		release();
 	}
 	InterleavedBuffer(const InterleavedBuffer&) = delete;
 	InterleavedBuffer& operator=(const InterleavedBuffer&) = delete;
@@ -89,6 +87,8 @@ public:
 		if (this == &b){
 			return *this;
 		}
+		//Give up our own buffer and its accounting before taking over theirs
+		release();
 		capacity = b.capacity;
 		stride_ = b.stride_;
 		buffer = b.buffer;
@@ -116,7 +116,7 @@ public:
 	void bind(){
 		assert(buffer != 0);
 		bound_target = type;
-		glBindBuffer(bound_target, buffer);
+		gl::backend().bind_buffer(bound_target, buffer);
 	}
 	/*
 	 * Bind the buffer to some other type target. This will not change
@@ -125,13 +125,13 @@ public:
 	void bind(GLenum target){
 		assert(buffer != 0);
 		bound_target = target;
-		glBindBuffer(bound_target, buffer);
+		gl::backend().bind_buffer(bound_target, buffer);
 	}
 	/*
 	 * Reset the binding point the buffer is currently bound to
 	 */
 	void unbind(){
-		glBindBuffer(bound_target, 0);
+		gl::backend().bind_buffer(bound_target, 0);
 	}
 	/*
 	 * Bind the entire buffer to the desired indexed buffer target
@@ -139,7 +139,7 @@ public:
 	void bind_base(int index){
 		assert(buffer != 0);
 		bound_target = type;
-		glBindBufferBase(bound_target, index, buffer);
+		gl::backend().bind_buffer_base(bound_target, index, buffer);
 	}
 	/*
 	 * Map the entire buffer for access with the desired mode, m
@@ -150,7 +150,7 @@ public:
 		bind();
 		mode = m;
 		map_start = 0;
-		data = static_cast<char*>(glMapBuffer(bound_target, mode));
+		data = static_cast<char*>(gl::backend().map_buffer(bound_target, mode));
 	}
 	/*
 	 * Map a range of indices of the buffer for access with the desired mode, m
@@ -163,7 +163,7 @@ public:
 		mode = flags;
 		map_start = start;
 		map_end = start + length;
-		data = static_cast<char*>(glMapBufferRange(bound_target, map_start * stride_,
+		data = static_cast<char*>(gl::backend().map_buffer_range(bound_target, map_start * stride_,
 			length * stride_, flags));
 	}
 	/*
@@ -174,7 +174,7 @@ public:
 		assert(data != nullptr);
 		assert(map_end > 0 && map_start <= start && start + length <= map_end
 			&& (mode & GL_MAP_FLUSH_EXPLICIT_BIT));
-		glFlushMappedBufferRange(type, start * stride_, length * stride_);
+		gl::backend().flush_mapped_buffer_range(type, start * stride_, length * stride_);
 	}
 	/*
 	 * Unmap the buffer, it's assumed the buffer was mapped as the type set
@@ -185,7 +185,7 @@ public:
 		data = nullptr;
 		map_end = 0;
 		bind(bound_target);
-		glUnmapBuffer(type);
+		gl::backend().unmap_buffer(type);
 	}
 	/*
 	 * Get a read-only reference to block member I at index i in the array
@@ -278,41 +278,58 @@ public:
 		//If there's no old data we need to preserve we can just allocate
 		//the new capacity
 		if (capacity == 0){
-			glBindBuffer(type, buffer);
-			glBufferData(type, new_cap * stride_, NULL, access);
+			gl::backend().bind_buffer(type, buffer);
+			gl::backend().buffer_data(type, new_cap * stride_, NULL, access);
 		}
 		else {
 			GLuint tmp;
-			glGenBuffers(1, &tmp);
-			glBindBuffer(type, tmp);
+			gl::backend().gen_buffers(1, &tmp);
+			gl::backend().bind_buffer(type, tmp);
 			//If we're allowed to change the buffer name then we're moving over
 			//to this new name and should allocate enough room for the new capacity
 			if (allow_name_change){
-				glBufferData(type, new_cap * stride_, NULL, access);
+				gl::backend().buffer_data(type, new_cap * stride_, NULL, access);
 			}
 			//If we can't change names then just make enough room to save the old data
 			//while we re-alloc the old name
 			else {
-				glBufferData(type, capacity * stride_, NULL, access);
+				gl::backend().buffer_data(type, capacity * stride_, NULL, access);
 			}
-			glBindBuffer(GL_COPY_WRITE_BUFFER, tmp);
-			glBindBuffer(GL_COPY_READ_BUFFER, buffer);
-			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * stride_);
+			gl::backend().bind_buffer(GL_COPY_WRITE_BUFFER, tmp);
+			gl::backend().bind_buffer(GL_COPY_READ_BUFFER, buffer);
+			gl::backend().copy_buffer_sub_data(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * stride_);
 			if (allow_name_change){
-				glDeleteBuffers(1, &buffer);
+				gl::backend().delete_buffers(1, &buffer);
 				buffer = tmp;
 			}
 			//If we can't change names now we need to resize the old buffer and move the old data back
 			else {
-				glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
-				glBindBuffer(GL_COPY_READ_BUFFER, tmp);
-				glBufferData(GL_COPY_WRITE_BUFFER, new_cap * stride_, NULL, access);
-				glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * stride_);
-				glDeleteBuffers(1, &tmp);
+				gl::backend().bind_buffer(GL_COPY_WRITE_BUFFER, buffer);
+				gl::backend().bind_buffer(GL_COPY_READ_BUFFER, tmp);
+				gl::backend().buffer_data(GL_COPY_WRITE_BUFFER, new_cap * stride_, NULL, access);
+				gl::backend().copy_buffer_sub_data(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, capacity * stride_);
+				gl::backend().delete_buffers(1, &tmp);
 			}
+			memtrack::gpu_free(memtrack::Gpu::BUFFER, capacity * stride_);
 		}
+		memtrack::gpu_alloc(memtrack::Gpu::BUFFER, new_cap * stride_);
 		capacity = new_cap;
 	}
+	/*
+	 * Replace the contents of the buffer with n blocks read straight from blocks,
+	 * which must already be laid out like the buffer's blocks. The buffer is resized
+	 * to hold exactly n blocks and must not be mapped
+	 */
+	void upload(const void *blocks, size_t n){
+		assert(data == nullptr);
+		gl::backend().bind_buffer(type, buffer);
+		gl::backend().buffer_data(type, n * stride_, blocks, access);
+		if (capacity > 0){
+			memtrack::gpu_free(memtrack::Gpu::BUFFER, capacity * stride_);
+		}
+		memtrack::gpu_alloc(memtrack::Gpu::BUFFER, n * stride_);
+		capacity = n;
+	}
 	/*
 	 * Get the number of blocks stored in the buffer
 	 */
@@ -377,6 +394,20 @@ private:
 	void at(size_t i, PtrTuple &t, detail::Sequence<N>){
 		std::get<N>(t) = &get<N>(i);
 	}
+	/*
+	 * Unmap and delete the buffer we own and remove it from the GPU memory counts
+	 */
+	void release(){
+		//If they forgot to unmap the buffer and we're the last one using it
+		if (data != nullptr){
+			bind(bound_target);
+			gl::backend().unmap_buffer(type);
+		}
+		gl::backend().delete_buffers(1, &buffer);
+		if (capacity > 0){
+			memtrack::gpu_free(memtrack::Gpu::BUFFER, capacity * stride_);
+		}
+	}
 	/*
 	 * Zero out all the members of the object dumping its information and reference
 	 * too a previously owned buffer. This is used by the move ctor/assign to remove
@@ -0,0 +1,80 @@
+#ifndef KTX_H
+#define KTX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "gl_core_3_3.h"
+
+/*
+ * Support for KTX 1.1 texture containers holding a single 2D image and its
+ * mip chain, either uncompressed RGBA8 or compressed with S3TC (BC1-3) or
+ * RGTC (BC4-5). Compressed levels are uploaded as is when the driver supports
+ * the format and decompressed on the CPU when it doesn't. Images are expected
+ * with their first row at the bottom, as tools/ktx_convert writes them, since
+ * compressed data can't be cheaply flipped at load time
+ */
+namespace ktx {
+	//S3TC formats from GL_EXT_texture_compression_s3tc, which isn't part of core
+	const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+	const GLenum COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+	const GLenum COMPRESSED_RGBA_S3TC_DXT3 = 0x83F2;
+	const GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+	/*
+	 * A mip level of the image, data points into the file's contents
+	 */
+	struct Level {
+		size_t width, height, size;
+		const unsigned char *data;
+	};
+	/*
+	 * The image in a KTX file. For compressed images type and format are 0
+	 * and internal_format is the compressed format
+	 */
+	struct Image {
+		GLenum type, format, internal_format, base_format;
+		size_t width, height;
+		std::vector<Level> levels;
+
+		bool compressed() const;
+	};
+
+	/*
+	 * Check if a file name has the .ktx extension
+	 */
+	bool is_ktx(const std::string &file);
+	/*
+	 * Parse a KTX file in memory, the levels point into data. Returns false
+	 * if it's not a KTX file or holds something other than a single 2D image
+	 * in one of the supported formats
+	 */
+	bool parse(const char *data, size_t len, Image &img);
+	/*
+	 * Write an image to a KTX file, marking its rows as bottom to top.
+	 * Returns false if writing failed
+	 */
+	bool write(const std::string &file, const Image &img);
+	/*
+	 * Check if the current context can sample a compressed format directly
+	 */
+	bool format_supported(GLenum internal_format);
+	/*
+	 * Decompress a level of a compressed image into 8 bit texels, with 4 channels
+	 * for S3TC, 1 for BC4 and 2 for BC5. Returns the number of channels written
+	 */
+	int decompress(const Image &img, const Level &level, std::vector<unsigned char> &out);
+	/*
+	 * Load KTX files into a 2D texture, or a 2D texture array if target is
+	 * GL_TEXTURE_2D_ARRAY, creating a new texture id. The images must all have
+	 * the same size, format and number of mip levels. Precomputed mip levels are
+	 * uploaded, mips are only generated for images that don't have any. Returns
+	 * 0 if loading failed, see util::load_texture for the out parameters
+	 */
+	GLuint load(const std::vector<std::string> &files, GLenum target, size_t *width = nullptr,
+		size_t *height = nullptr, size_t *bytes = nullptr);
+}
+
+#endif
+
@@ -1,23 +1,82 @@
 #ifndef LEVEL_H
 #define LEVEL_H
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <glm/glm.hpp>
 #include <entityx/entityx.h>
 #include <lfwatch.h>
 #include "interleavedbuffer.h"
 #include "events/input_event.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+#include "components/rigid_body.h"
+#include "thread_pool.h"
+#include "entity_pool.h"
+#include "sim_config.h"
+#include "input_source.h"
+#include "system_scheduler.h"
 
 class Level : public entityx::Manager, public entityx::Receiver<InputEvent> {
 	GLint shader_program;
 	InterleavedBuffer<Layout::PACKED, glm::mat4> viewing;
 	bool quit;
 	lfw::Watcher file_watcher;
+	std::shared_ptr<Kinematics> kinematics;
+	std::shared_ptr<Colliders> colliders;
+	std::shared_ptr<Bodies> bodies;
+	EntityPool entity_pool;
+	ThreadPool thread_pool;
+	std::unique_ptr<SystemScheduler> scheduler;
+	SimConfig config;
+	std::shared_ptr<InputSource> input;
+	uint64_t tick_count, tick_hash;
 	
 public:
-	Level();
+	/*
+	 * Create a level reading input from some source, by default input comes from SDL
+	 */
+	Level(const SimConfig &config = SimConfig{},
+		const std::shared_ptr<InputSource> &input = std::make_shared<SDLInputSource>());
 	~Level();
 	void receive(const InputEvent &input);
+	/*
+	 * Check if the level has been quit or a replay has run out of input
+	 */
 	bool should_quit();
+	/*
+	 * Get the number of ticks the simulation has run
+	 */
+	uint64_t ticks() const;
+	/*
+	 * Compute a hash of the simulation state, two deterministic runs are in sync
+	 * as long as their hashes match
+	 */
+	uint64_t state_hash() const;
+	/*
+	 * Get the state hash computed after the last tick, only computed in deterministic mode
+	 */
+	uint64_t last_tick_hash() const;
+	/*
+	 * Get the number of moving entities in the level
+	 */
+	size_t entities() const;
+	/*
+	 * Get the scheduler running the level's systems, eg. to see how long each took
+	 */
+	const SystemScheduler& systems() const;
+	/*
+	 * Save the entities and their component data to a snapshot file, returns
+	 * false if writing failed
+	 */
+	bool save_snapshot(const std::string &file);
+	/*
+	 * Replace the world with the one in some snapshot file, returns false if the
+	 * snapshot couldn't be read. Restoring a snapshot copies the component data in
+	 * bulk so it's much faster than spawning the entities again
+	 */
+	bool load_snapshot(const std::string &file);
 
 protected:
 	void configure() override;
@@ -26,6 +85,10 @@ protected:
 
 private:
 	void load_shader();
+	/*
+	 * Spawn the initial asteroids and player
+	 */
+	void spawn();
 };
 
 #endif
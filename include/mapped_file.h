@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/*
+ * A read only memory mapping of a whole file, the data stays mapped
+ * for the lifetime of the object. The mapping starts on a page boundary
+ * so data aligned within the file is aligned in memory as well
+ */
+class MappedFile {
+	const char *bytes;
+	size_t length;
+	bool mapped;
+#ifdef _WIN32
+	void *file, *mapping;
+#endif
+
+public:
+	/*
+	 * Map a file, check good() to see if it worked
+	 */
+	MappedFile(const std::string &file);
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	/*
+	 * Check if the file was mapped, an empty file maps to no data
+	 * but is still good
+	 */
+	bool good() const;
+	const char* data() const;
+	size_t size() const;
+};
+
+#endif
+
@@ -0,0 +1,78 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/*
+ * Accounting of host and GPU memory by the subsystem using it. Host
+ * allocations are attributed to the tag set by the innermost Scope on the
+ * allocating thread and tracked by replacing the global operator new and
+ * delete, which is only done when ASTEROIDS_MEMORY_TRACKING is defined since
+ * every allocation then pays for a header and a few atomic adds. GPU buffer
+ * and texture bytes are counted by the objects owning them and are always
+ * tracked
+ */
+namespace memtrack {
+#ifdef ASTEROIDS_MEMORY_TRACKING
+	const bool TRACKING_HOST = true;
+#else
+	const bool TRACKING_HOST = false;
+#endif
+	enum class Tag : uint8_t {
+		OTHER, ASSETS, ECS, RENDER, EVENTS, COUNT
+	};
+	enum class Gpu : uint8_t {
+		BUFFER, TEXTURE, COUNT
+	};
+	/*
+	 * Counts for a tag, live is the bytes currently allocated and
+	 * peak the most that have been live at once
+	 */
+	struct Stats {
+		uint64_t allocs, frees, live, peak, total;
+	};
+	const char* name(Tag tag);
+	const char* name(Gpu kind);
+	/*
+	 * Sets the tag for allocations made by the current thread during its
+	 * lifetime, restoring the previous tag once it's gone
+	 */
+	class Scope {
+		Tag prev;
+
+	public:
+		explicit Scope(Tag tag);
+		~Scope();
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+	/*
+	 * Get the tag allocations on the current thread are attributed to,
+	 * eg. to carry it over to work run on other threads
+	 */
+	Tag current_tag();
+	void host_alloc(Tag tag, size_t bytes);
+	void host_free(Tag tag, size_t bytes);
+	void gpu_alloc(Gpu kind, size_t bytes);
+	void gpu_free(Gpu kind, size_t bytes);
+	Stats host(Tag tag);
+	Stats gpu(Gpu kind);
+	/*
+	 * Get the most host memory that's been live at once over all tags
+	 */
+	uint64_t host_high_water();
+	/*
+	 * Reset the peaks to the current live bytes, eg. to find the peak
+	 * within a single frame
+	 */
+	void reset_peaks();
+	/*
+	 * Write a table of the host and GPU stats
+	 */
+	void dump(std::ostream &os);
+}
+
+#endif
+
@@ -0,0 +1,98 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <glm/glm.hpp>
+#include "interleavedbuffer.h"
+#include "mapped_file.h"
+#include "obj_parser.h"
+
+/*
+ * A binary cache of a parsed model so it can be loaded by mapping the file
+ * and handing the vertex and index data straight to the GPU. The file is a
+ * header describing the vertex layout and the mesh's bounds followed by the
+ * vertex and index arrays, each starting on a 64 byte boundary. The header
+ * stores a hash of the model file the cache was built from so stale caches
+ * are rebuilt when the model changes. Caches use the native byte order and
+ * aren't meant to be moved between machines, one in the wrong order fails
+ * the magic check and is rebuilt
+ */
+namespace mesh_cache {
+	const uint32_t MAGIC = 0x48534d41;
+	const uint32_t VERSION = 1;
+	//The vertex and index arrays start on multiples of this many bytes
+	const size_t ALIGN = 64;
+	//Caches are named after their model with this extension, see util::cache_path
+	const char EXTENSION[] = ".mesh";
+
+	/*
+	 * A vertex attribute: its offset in the vertex, number of components
+	 * and GL component type
+	 */
+	struct Attrib {
+		uint32_t offset, components, type;
+	};
+	/*
+	 * An axis aligned box and a bounding sphere around its center
+	 */
+	struct Bounds {
+		glm::vec3 min, max, center;
+		float radius;
+	};
+	struct Header {
+		uint32_t magic, version;
+		uint64_t source_hash;
+		uint32_t vertex_count, index_count, vertex_stride, index_size;
+		uint32_t attrib_count, reserved;
+		Attrib attribs[4];
+		Bounds bounds;
+		uint64_t vertex_offset, index_offset;
+	};
+
+	Bounds compute_bounds(const MeshVertex *vertices, size_t n);
+	/*
+	 * Write a mesh to a cache file, source_hash is the hash of the model file
+	 * it was parsed from. Returns false if writing failed
+	 */
+	bool write(const std::string &file, const MeshData &mesh, uint64_t source_hash);
+	/*
+	 * Parse a model and write its cache, returns false if either failed
+	 */
+	bool cook(const std::string &model, const std::string &file);
+
+	/*
+	 * A cache file mapped into memory, the vertex and index data point
+	 * into the mapping
+	 */
+	class CachedMesh {
+		MappedFile file;
+		Header header;
+		bool valid;
+
+	public:
+		/*
+		 * Map a cache file and check that it's well formed and in the
+		 * vertex layout MeshVertex uses
+		 */
+		CachedMesh(const std::string &file);
+		bool good() const;
+		const Header& info() const;
+		const MeshVertex* vertices() const;
+		const uint32_t* indices() const;
+	};
+
+	/*
+	 * Load a model into the buffers through its cache. If the cache is missing
+	 * or was built from a different version of the model it's rebuilt from the
+	 * OBJ file, if the OBJ file is missing the cache is used as is. The buffers
+	 * are resized to fit the mesh. Returns false if the model couldn't be loaded
+	 */
+	bool load(const std::string &model,
+		InterleavedBuffer<Layout::PACKED, glm::vec3, glm::vec3, glm::vec3> &vbo,
+		InterleavedBuffer<Layout::PACKED, GLuint> &ebo, size_t &n_elems, Bounds *bounds = nullptr);
+}
+
+#endif
+
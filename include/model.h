@@ -5,6 +5,7 @@
 #include <memory>
 #include <string>
 #include "interleavedbuffer.h"
+#include "mesh_cache.h"
 
 /*
  * A lightweight model class, stores the vao, vbo and ebo
@@ -12,12 +13,13 @@
 class Model {
 	GLuint vao;
 	InterleavedBuffer<Layout::PACKED, glm::vec3, glm::vec3, glm::vec3> vbo;
-	InterleavedBuffer<Layout::PACKED, GLushort> ebo;
+	InterleavedBuffer<Layout::PACKED, GLuint> ebo;
 	size_t n_elems;
+	mesh_cache::Bounds bounding;
 
 public:
 	/*
-	 * Load the model from an obj file
+	 * Load the model from an obj file, through its mesh cache
 	 */
 	Model(const std::string &file);
 	~Model();
@@ -31,6 +33,10 @@ public:
 	Model& operator=(Model &&m);
 	void bind();
 	size_t elems();
+	/*
+	 * Get the bounding box and sphere of the model's vertices
+	 */
+	const mesh_cache::Bounds& bounds() const;
 
 private:
 	/*
@@ -0,0 +1,60 @@
+#ifndef MOVEMENT_KERNEL_H
+#define MOVEMENT_KERNEL_H
+
+#include <cstddef>
+#include <glm/glm.hpp>
+
+/*
+ * Batch integration of positions by velocities: pos += vel * dt
+ * The positions and velocities are passed as streams of n interleaved xy
+ * pairs (ie. packed glm::vec2s, 2n floats). Since the update is the same for
+ * x and y each stream is treated as a flat array of floats and the SIMD
+ * variants just work down it a full register at a time
+ */
+namespace kernel {
+/*
+ * The instruction set used by a variant of the kernel
+ */
+enum class Isa { SCALAR, SSE2, AVX2, AVX512 };
+/*
+ * Bounds to wrap positions into after integrating, a position leaving
+ * through one side comes back in through the opposite one. The wrap is done
+ * with a single add or subtract of the bounds size so entities are assumed
+ * to move less than the width/height of the bounds per update
+ */
+struct Bounds {
+	glm::vec2 min, max;
+};
+/*
+ * Integrate the n positions using the best variant supported by the CPU,
+ * this is chosen once on the first call. If wrap is not null the positions
+ * are wrapped back into the bounds after the update
+ */
+void integrate(float *pos, const float *vel, size_t n, float dt, const Bounds *wrap = nullptr);
+/*
+ * Integrate the positions with a specific variant of the kernel, the variant
+ * must be supported by the CPU. Mostly useful for benchmarking and testing
+ */
+void integrate(Isa isa, float *pos, const float *vel, size_t n, float dt, const Bounds *wrap = nullptr);
+/*
+ * Check if the variant for some instruction set was built and is supported
+ * by the CPU
+ */
+bool supported(Isa isa);
+/*
+ * Get the best variant supported by the CPU
+ */
+Isa best_isa();
+const char* isa_name(Isa isa);
+
+namespace detail {
+//The variants of the kernel, these take the number of floats, 2n, in the streams
+void integrate_scalar(float *pos, const float *vel, size_t count, float dt, const Bounds *wrap);
+void integrate_sse2(float *pos, const float *vel, size_t count, float dt, const Bounds *wrap);
+void integrate_avx2(float *pos, const float *vel, size_t count, float dt, const Bounds *wrap);
+void integrate_avx512(float *pos, const float *vel, size_t count, float dt, const Bounds *wrap);
+}
+}
+
+#endif
+
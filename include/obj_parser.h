@@ -0,0 +1,44 @@
+#ifndef OBJ_PARSER_H
+#define OBJ_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+ * A vertex of a mesh, laid out the same as the packed vbo blocks
+ * Model uses so the vertices can be copied straight into the buffer
+ */
+struct MeshVertex {
+	glm::vec3 pos, normal, uv;
+};
+static_assert(sizeof(MeshVertex) == 9 * sizeof(float), "MeshVertex must be tightly packed");
+
+/*
+ * Mesh data read from a model file, an indexed triangle list
+ */
+struct MeshData {
+	std::vector<MeshVertex> vertices;
+	std::vector<uint32_t> indices;
+};
+
+namespace util {
+	/*
+	 * Parse OBJ text into a triangle mesh, vertices sharing the same
+	 * position, uv and normal indices are merged. Faces with more than 3
+	 * vertices are triangulated as fans, negative (relative) indices are
+	 * supported and faces can leave out the uv and/or normal: missing uvs
+	 * are 0 and missing normals are computed by averaging the normals of
+	 * the faces using the vertex. Returns false if the text is malformed
+	 */
+	bool parse_obj(const char *text, size_t len, MeshData &mesh);
+	/*
+	 * Read and parse an OBJ file, returns false if reading or parsing failed
+	 */
+	bool read_obj(const std::string &file, MeshData &mesh);
+}
+
+#endif
+
@@ -0,0 +1,34 @@
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * A minimal perfect hash over a fixed set of string keys, built by hash and
+ * displace: keys are split into small buckets and each bucket gets a seed
+ * that sends its keys to slots no other key uses. A lookup is one hash of
+ * the key and two table reads, the slots table maps each slot back to the
+ * index of its key. Keys that weren't in the set also land on some slot so
+ * the caller has to check the key at the index it gets back
+ */
+namespace perfect_hash {
+	/*
+	 * Build the tables for the keys, slots[slot] is the index in keys of the
+	 * key hashed to slot. If a key appears more than once its last index is
+	 * used and there are fewer slots than keys. Returns false if the keys
+	 * couldn't be placed, which only happens if two keys have the same 64 bit hash
+	 */
+	bool build(const std::vector<std::string> &keys, std::vector<uint32_t> &seeds,
+		std::vector<uint32_t> &slots);
+	/*
+	 * Find the slot a key hashes to with the seeds table of n_seeds buckets
+	 * built for n_slots keys
+	 */
+	size_t slot(const char *key, size_t len, const uint32_t *seeds, size_t n_seeds, size_t n_slots);
+}
+
+#endif
+
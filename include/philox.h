@@ -0,0 +1,57 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+/*
+ * Philox4x32-10 counter based random number generator. Each block of 4 random
+ * numbers is a pure function of the seed, stream and counter so generators
+ * give the same sequence on every platform, can be split into independent
+ * streams (eg. one per system) and can jump to any point in their sequence
+ *
+ * The conversions to floats and ranges are done here instead of with the
+ * standard distributions since those are implementation defined
+ */
+class Philox {
+public:
+	using Block = std::array<uint32_t, 4>;
+
+private:
+	uint64_t seed;
+	uint32_t stream;
+	uint64_t counter;
+	Block block;
+	//Number of values of the current block that have been handed out
+	unsigned used;
+
+public:
+	Philox(uint64_t seed, uint32_t stream = 0);
+	/*
+	 * Compute the block of random numbers for some counter value
+	 */
+	static Block generate(uint64_t seed, uint32_t stream, uint64_t counter);
+	/*
+	 * Get the next random 32 bit value
+	 */
+	uint32_t next();
+	/*
+	 * Get a random float in [0, 1)
+	 */
+	float uniform();
+	/*
+	 * Get a random float in [a, b)
+	 */
+	float uniform(float a, float b);
+	/*
+	 * Get a random integer in [0, n), n must be > 0
+	 */
+	uint32_t below(uint32_t n);
+	/*
+	 * Jump to the start of some block in the sequence
+	 */
+	void seek(uint64_t block_counter);
+};
+
+#endif
+
@@ -0,0 +1,73 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+/*
+ * Collision detection and response for circles and convex polygons that
+ * only move linearly. Contacts are solved with sequential impulses on the
+ * velocities, contacts that haven't happened yet but will within the step
+ * are kept as speculative contacts which only stop the bodies from closing
+ * more than the gap between them, so fast bodies can't tunnel through
+ */
+namespace physics {
+	/*
+	 * A shape positioned at the origin, a circle if count is 0
+	 */
+	struct Shape {
+		float radius;
+		uint32_t count;
+		const glm::vec2 *vertices;
+	};
+	struct Contact {
+		//Indices of the bodies, the normal points from a to b
+		uint32_t a, b;
+		glm::vec2 normal;
+		//Distance between the shapes along the normal, negative if they overlap
+		//and positive for a speculative contact
+		float separation;
+		//Restitution of the contact, the solver replaces it with the normal
+		//velocity the bodies should separate with after bouncing
+		float bounce;
+		//Impulse accumulated by the solver
+		float impulse;
+	};
+	/*
+	 * Find the time in [0, 1] at which two circles moving by da and db first touch,
+	 * returns false if they don't touch during the move. Circles that overlap at
+	 * the start have a time of 0
+	 */
+	bool time_of_impact(const glm::vec2 &pa, float ra, const glm::vec2 &da,
+		const glm::vec2 &pb, float rb, const glm::vec2 &db, float &t);
+	/*
+	 * Find the separating normal (from a to b) and distance between two shapes
+	 * at positions pa and pb. Separated polygons report a distance that's at
+	 * most the actual distance between them
+	 */
+	void collide(const Shape &a, const glm::vec2 &pa, const Shape &b, const glm::vec2 &pb,
+		glm::vec2 &normal, float &separation);
+	/*
+	 * Solve a set of contacts by sequential impulses, updating the velocities of the
+	 * bodies. Bodies with an inverse mass of 0 are never written to so contacts
+	 * touching different dynamic bodies can be solved in parallel
+	 */
+	void solve(Contact *contacts, size_t n, glm::vec2 *velocities, const float *inv_mass,
+		float dt, int iterations);
+	/*
+	 * Union find over body indices used to split contacts into islands of bodies
+	 * that affect each other
+	 */
+	class UnionFind {
+		std::vector<uint32_t> parent;
+
+	public:
+		void reset(size_t n);
+		uint32_t find(uint32_t i);
+		void join(uint32_t a, uint32_t b);
+	};
+}
+
+#endif
+
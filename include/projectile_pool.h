@@ -0,0 +1,72 @@
+#ifndef PROJECTILE_POOL_H
+#define PROJECTILE_POOL_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "movement_kernel.h"
+
+/*
+ * Fixed capacity storage for short lived projectiles like bullets, which are
+ * too numerous and die too quickly to be worth making entities. Projectiles
+ * are kept in a ring buffer with each property in its own array, since every
+ * projectile lives for the same amount of time they expire in the order they
+ * were fired and expiring is just moving the head of the ring forward
+ *
+ * Projectiles that hit something are killed in place and their slot is
+ * reclaimed once it reaches the head. Projectiles are referred to by their
+ * index from the oldest one, [0, size()), and slot(i) gives the index of
+ * their data in the arrays
+ */
+class ProjectilePool {
+	size_t mask, head, count;
+	float lifetime;
+	double clock;
+	std::vector<glm::vec2> pos, vel;
+	//Time each projectile expires at, killed projectiles expire immediately
+	std::vector<double> expiry;
+
+public:
+	/*
+	 * Create a pool with room for at least capacity projectiles, rounded
+	 * up to a power of 2, which live for lifetime seconds
+	 */
+	ProjectilePool(size_t capacity, float lifetime);
+	/*
+	 * Fire a projectile from p with velocity v, if the pool is full the
+	 * oldest projectile is dropped to make room
+	 */
+	void fire(const glm::vec2 &p, const glm::vec2 &v);
+	/*
+	 * Move the projectiles forward dt seconds and expire the ones that
+	 * have run out of time. If wrap is not null the projectiles wrap around
+	 * the bounds like the other moving entities
+	 */
+	void advance(float dt, const kernel::Bounds *wrap = nullptr);
+	/*
+	 * Kill projectile i, eg. when it's hit something
+	 */
+	void kill(size_t i);
+	bool alive(size_t i) const;
+	/*
+	 * Get the array slot of projectile i
+	 */
+	size_t slot(size_t i) const {
+		return (head + i) & mask;
+	}
+	/*
+	 * Get the number of projectiles in the ring, including killed ones
+	 * that haven't been reclaimed yet
+	 */
+	size_t size() const;
+	size_t capacity() const;
+	/*
+	 * Drop all the projectiles
+	 */
+	void clear();
+	const glm::vec2* positions() const;
+	const glm::vec2* velocities() const;
+};
+
+#endif
+
@@ -0,0 +1,58 @@
+#ifndef RAYCAST_KERNEL_H
+#define RAYCAST_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "movement_kernel.h"
+
+/*
+ * Batch test of a segment against a set of circles, used to find what a
+ * projectile hits while moving over a step. The circles are passed as
+ * separate x, y and radius arrays so the SIMD variants can test a full
+ * register of circles at a time against the same segment
+ *
+ * Every variant does the same float operations in the same order so they
+ * all find the same hit, on equal times the circle with the lowest index wins
+ */
+namespace kernel {
+/*
+ * Find the first of the n circles hit by the segment from o to o + d,
+ * returns the index of the circle hit or -1 if none are. The fraction of
+ * the segment travelled before hitting is written to t, a segment starting
+ * inside a circle hits it at t = 0. Uses the best variant supported by the CPU
+ */
+int32_t ray_circles(const glm::vec2 &o, const glm::vec2 &d, const float *cx, const float *cy,
+	const float *r, size_t n, float &t);
+/*
+ * Test the segment with a specific variant of the kernel, the variant
+ * must be supported by the CPU
+ */
+int32_t ray_circles(Isa isa, const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t);
+
+namespace detail {
+int32_t ray_circles_scalar(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t);
+int32_t ray_circles_sse2(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t);
+int32_t ray_circles_avx2(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t);
+int32_t ray_circles_avx512(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t);
+/*
+ * Merge the hit found for the circles after the first offset ones into the
+ * best hit found for the first ones, the earlier hit is kept on a tie
+ */
+inline int32_t merge_hit(int32_t best, float &t, int32_t tail, float tail_t, size_t offset){
+	if (tail >= 0 && (best < 0 || tail_t < t)){
+		t = tail_t;
+		return tail + static_cast<int32_t>(offset);
+	}
+	return best;
+}
+}
+}
+
+#endif
+
@@ -6,6 +6,7 @@
 #include <vector>
 #include <glm/glm.hpp>
 #include "gl_core_3_3.h"
+#include "gl_backend.h"
 #include "glattrib_type.h"
 #include "interleavedbuffer.h"
 #include "renderbatch.h"
@@ -146,14 +147,14 @@ public:
 		attributes.bind();
 		set_attrib_index<Attribs...>();
 		//Something is trampling state after this call on the letters. Perhaps in model loading?
-		glBindVertexArray(0);
+		gl::backend().bind_vertex_array(0);
 	}
 	/*
 	 * Render the batch
 	 */
 	void render(){
 		model->bind();
-		glDrawElementsInstanced(GL_TRIANGLES, model->elems(), GL_UNSIGNED_SHORT, 0, size);
+		gl::backend().draw_elements_instanced(GL_TRIANGLES, model->elems(), GL_UNSIGNED_INT, 0, size);
 	}
 	size_t batch_size() const {
 		return size;
@@ -186,18 +187,18 @@ private:
 		size_t num_indices = attrib_size / sizeof(glm::vec4);
 		num_indices = attrib_size % sizeof(glm::vec4) == 0 ? num_indices : num_indices + 1;
 		for (size_t i = 0; i < num_indices; ++i){
-			glEnableVertexAttribArray(i + indices[index]);
+			gl::backend().enable_vertex_attrib_array(i + indices[index]);
 			if (gl_type == GL_FLOAT || gl_type == GL_HALF_FLOAT || gl_type == GL_DOUBLE){
 				//TODO: How should we work through computing the number of values we're sending?
 				//or is just saying 4 fine
-				glVertexAttribPointer(i + indices[index], 4, gl_type, GL_FALSE, attributes.stride(),
+				gl::backend().vertex_attrib_pointer(i + indices[index], 4, gl_type, GL_FALSE, attributes.stride(),
 						(void*)(base_offset + sizeof(glm::vec4) * i));
 			}
 			else {
-				glVertexAttribIPointer(i + indices[index], 4, gl_type, attributes.stride(),
+				gl::backend().vertex_attrib_ipointer(i + indices[index], 4, gl_type, attributes.stride(),
 						(void*)(base_offset + sizeof(glm::vec4) * i));
 			}
-			glVertexAttribDivisor(i + indices[index], 1);
+			gl::backend().vertex_attrib_divisor(i + indices[index], 1);
 		}
 	}
 	template<typename A, typename B, typename... Args>
@@ -211,18 +212,18 @@ private:
 		size_t num_indices = attrib_size / sizeof(glm::vec4);
 		num_indices = attrib_size % sizeof(glm::vec4) == 0 ? num_indices : num_indices + 1;
 		for (size_t i = 0; i < num_indices; ++i){
-			glEnableVertexAttribArray(i + indices[index]);
+			gl::backend().enable_vertex_attrib_array(i + indices[index]);
 			if (gl_type == GL_FLOAT || gl_type == GL_HALF_FLOAT || gl_type == GL_DOUBLE){
 				//TODO: How should we work through computing the number of values we're sending?
 				//or is just saying 4 fine
-				glVertexAttribPointer(i + indices[index], 4, gl_type, GL_FALSE, attributes.stride(),
+				gl::backend().vertex_attrib_pointer(i + indices[index], 4, gl_type, GL_FALSE, attributes.stride(),
 						(void*)(base_offset + sizeof(glm::vec4) * i));
 			}
 			else {
-				glVertexAttribIPointer(i + indices[index], 4, gl_type, attributes.stride(),
+				gl::backend().vertex_attrib_ipointer(i + indices[index], 4, gl_type, attributes.stride(),
 						(void*)(base_offset + sizeof(glm::vec4) * i));
 			}
-			glVertexAttribDivisor(i + indices[index], 1);
+			gl::backend().vertex_attrib_divisor(i + indices[index], 1);
 			//Check that we didn't spill over into another attributes index space
 			if (i + indices[index] >= indices[index + 1]){
 				std::cerr << "RenderBatch Warning: attribute " << indices[index]
@@ -0,0 +1,51 @@
+#ifndef SIM_CONFIG_H
+#define SIM_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+ * Settings for how a Level runs its simulation. In deterministic mode
+ * every update advances the simulation by exactly one fixed tick no matter
+ * the frame time passed and a hash of the simulation state is computed
+ * after each tick, so two runs with the same seed and input can be compared
+ * tick by tick
+ *
+ * A headless level doesn't touch OpenGL directly, rendering still goes
+ * through the gl backend so a MockBackend should be set while running one
+ */
+struct SimConfig {
+	//Seed for the random streams used by the level and its systems
+	uint64_t seed;
+	bool deterministic, headless;
+	//Length of a tick in seconds in deterministic mode
+	double tick;
+	//If set the level's world is restored from this snapshot instead of being spawned
+	std::string snapshot;
+	//Number of asteroids to spawn and the half width of the square playfield they wrap
+	//around in, the view always shows the middle 10x10 units of the playfield
+	size_t asteroids;
+	float field;
+
+	/*
+	 * Create the default config, seeded from the clock and running
+	 * with the frame time
+	 */
+	SimConfig();
+	/*
+	 * Create a config for a deterministic run with some seed
+	 */
+	static SimConfig fixed(uint64_t seed, double tick = 1.0 / 60.0, bool headless = false);
+};
+
+/*
+ * The random streams used by the simulation, each user gets its own stream
+ * so adding random draws in one system doesn't shift the others
+ */
+enum class RandomStream : uint32_t {
+	SPAWN, ASTEROID_COLOR
+};
+
+#endif
+
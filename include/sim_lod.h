@@ -0,0 +1,94 @@
+#ifndef SIM_LOD_H
+#define SIM_LOD_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "components/kinematics.h"
+
+/*
+ * A level of detail bucket: entities closer to the focus than radius (and
+ * not in an earlier bucket) are updated once every period ticks
+ */
+struct LodBucket {
+	float radius;
+	uint32_t period;
+};
+
+/*
+ * Simulation level of detail for the kinematics pool. Entities are bucketed by
+ * their distance to a focus point (eg. the center of the view) and the pool is
+ * partitioned so each bucket is a contiguous range, nearest bucket first. A
+ * bucket with a period of N is split into N slices and one slice is updated
+ * each tick with N times the tick's dt, so far away entities cost 1/N as much
+ * while the work stays spread evenly over the ticks
+ *
+ * Partitioning the pool costs about as much as integrating it so entities are
+ * only rebucketed every few ticks, an entity crossing between buckets or slices
+ * may gain or lose a partial step when it's moved
+ *
+ * Anything that predicts motion over a tick, like the speculative contacts in
+ * PhysicsSystem, has to look period ticks ahead for entities in slower buckets
+ * since they move that far in one step, see period
+ */
+class SimLod {
+public:
+	/*
+	 * A range of the pool to update this tick and the dt to update it with
+	 */
+	struct Range {
+		size_t begin, end;
+		float dt;
+	};
+
+private:
+	std::vector<LodBucket> buckets;
+	//Bucket b covers [starts[b], starts[b + 1]) of the pool
+	std::vector<size_t> starts;
+	std::vector<uint8_t> assigned;
+	uint32_t rebucket_interval;
+	uint64_t tick;
+
+public:
+	/*
+	 * Create the LOD buckets, they should be sorted by radius and the last
+	 * bucket catches everything further away no matter its radius
+	 */
+	SimLod(const std::vector<LodBucket> &buckets, uint32_t rebucket_interval = 16);
+	/*
+	 * Advance a tick, rebucketing the pool if it's time to and filling ranges with
+	 * the parts of the pool to update this tick
+	 */
+	void update(Kinematics &pool, const glm::vec2 &focus, float dt, std::vector<Range> &ranges);
+	/*
+	 * Get the number of entities in bucket b as of the last rebucket
+	 */
+	size_t bucket_size(size_t b) const;
+	/*
+	 * Get the number of ticks the entity at index i of the pool moves in one
+	 * step. If the pool has changed size since it was last partitioned the
+	 * longest period is returned since the entity may be in any bucket
+	 */
+	uint32_t period(const Kinematics &pool, size_t i) const;
+	/*
+	 * Get the tick and partition of the pool to store in a snapshot, the pool's
+	 * order is stored with the pool itself
+	 */
+	std::vector<uint64_t> state() const;
+	/*
+	 * Check if the state saved by state() can be restored for a pool of
+	 * pool_size entities with these buckets
+	 */
+	bool can_restore(const uint64_t *state, size_t n, size_t pool_size) const;
+	/*
+	 * Restore the state saved by state(), returns false and changes nothing if
+	 * can_restore doesn't accept it
+	 */
+	bool restore(const uint64_t *state, size_t n, size_t pool_size);
+
+private:
+	void rebucket(Kinematics &pool, const glm::vec2 &focus);
+};
+
+#endif
+
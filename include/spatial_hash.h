@@ -0,0 +1,104 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "thread_pool.h"
+
+/*
+ * A uniform grid broadphase for circles. The grid is unbounded, cells are
+ * hashed into a table of buckets by wrapping them onto a smaller square grid
+ * and the circles are counting sorted by bucket on each build so every
+ * bucket's circles sit next to each other in memory. Wrapping instead of
+ * scrambling the cells keeps neighbouring cells close together in the table
+ * so the pair search walks memory mostly in order
+ *
+ * The cell size is at least the largest diameter so a circle can only
+ * overlap circles in its own and the 8 neighbouring cells
+ */
+class SpatialHash {
+public:
+	/*
+	 * A pair of overlapping circles, given by their index in the arrays
+	 * passed to build with a < b
+	 */
+	struct Pair {
+		uint32_t a, b;
+	};
+
+private:
+	struct Entry {
+		glm::vec2 pos;
+		float radius;
+		uint32_t index;
+		int32_t cx, cy;
+	};
+	float min_cell, cell;
+	//The bucket grid is 2^shift buckets on a side
+	uint32_t shift, mask;
+	//starts[b] is the first entry in bucket b, the bucket ends at starts[b + 1]
+	std::vector<uint32_t> starts;
+	std::vector<uint32_t> buckets;
+	std::vector<Entry> entries;
+	//Pairs found by each chunk of entries, merged in chunk order
+	mutable std::vector<std::vector<Pair>> chunk_pairs;
+
+public:
+	/*
+	 * Create a spatial hash with cells at least min_cell wide
+	 */
+	SpatialHash(float min_cell = 1.f);
+	/*
+	 * Rebuild the hash for n circles, the arrays are only read during the build
+	 */
+	void build(const glm::vec2 *pos, const float *radius, size_t n, ThreadPool &pool);
+	/*
+	 * Find all overlapping pairs of circles, splitting the work over the pool
+	 * The pairs are in the same order no matter how many threads are used
+	 */
+	void pairs(ThreadPool &pool, std::vector<Pair> &out) const;
+	/*
+	 * Call fn with the index of each circle overlapping the circle at p with radius r
+	 */
+	template<typename F>
+	void query(const glm::vec2 &p, float r, const F &fn) const {
+		if (entries.empty()){
+			return;
+		}
+		//A query circle may be bigger than the cells so walk all cells it touches
+		const int32_t x0 = cell_coord(p.x - r), x1 = cell_coord(p.x + r);
+		const int32_t y0 = cell_coord(p.y - r), y1 = cell_coord(p.y + r);
+		for (int32_t y = y0 - 1; y <= y1 + 1; ++y){
+			for (int32_t x = x0 - 1; x <= x1 + 1; ++x){
+				const uint32_t b = bucket(x, y);
+				for (uint32_t i = starts[b]; i < starts[b + 1]; ++i){
+					const Entry &e = entries[i];
+					if (e.cx == x && e.cy == y && overlaps(p, r, e.pos, e.radius)){
+						fn(e.index);
+					}
+				}
+			}
+		}
+	}
+	/*
+	 * Get the number of circles in the hash
+	 */
+	size_t size() const;
+	/*
+	 * Get the cell size used by the last build
+	 */
+	float cell_size() const;
+
+private:
+	int32_t cell_coord(float x) const;
+	uint32_t bucket(int32_t x, int32_t y) const;
+	static bool overlaps(const glm::vec2 &a, float ra, const glm::vec2 &b, float rb);
+	/*
+	 * Find the pairs between the entries [begin, end) and the entries after them
+	 */
+	void find_pairs(size_t begin, size_t end, std::vector<Pair> &out) const;
+};
+
+#endif
+
@@ -0,0 +1,24 @@
+#ifndef SPRITE_ID_H
+#define SPRITE_ID_H
+
+#include <cstdint>
+
+/*
+ * The id of a sprite in a texture atlas, its index in the atlas document.
+ * Ids for the sprites in an atlas are generated as constants by tools/atlas_ids
+ * so code using the atlas can refer to sprites without looking up their names
+ */
+struct SpriteId {
+	uint32_t index;
+};
+constexpr SpriteId INVALID_SPRITE{UINT32_MAX};
+
+constexpr bool operator==(const SpriteId &a, const SpriteId &b){
+	return a.index == b.index;
+}
+constexpr bool operator!=(const SpriteId &a, const SpriteId &b){
+	return a.index != b.index;
+}
+
+#endif
+
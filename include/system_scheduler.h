@@ -0,0 +1,120 @@
+#ifndef SYSTEM_SCHEDULER_H
+#define SYSTEM_SCHEDULER_H
+
+#include <bitset>
+#include <string>
+#include <vector>
+#include <entityx/entityx.h>
+#include "thread_pool.h"
+
+/*
+ * Describes the components a system reads and writes and if it must run on
+ * the main thread (eg. because it touches OpenGL or SDL). Components are
+ * identified by their entityx component family
+ */
+class SystemAccess {
+	std::bitset<64> reads, writes;
+	bool main_thread;
+
+public:
+	SystemAccess();
+	/*
+	 * Mark the components as read by the system
+	 */
+	template<typename... C>
+	SystemAccess& read(){
+		mark<C...>(reads);
+		return *this;
+	}
+	/*
+	 * Mark the components as written by the system
+	 */
+	template<typename... C>
+	SystemAccess& write(){
+		mark<C...>(writes);
+		return *this;
+	}
+	/*
+	 * Require the system to run on the main thread
+	 */
+	SystemAccess& pin_main_thread();
+	bool pinned() const;
+	/*
+	 * Check if two systems can't run at the same time, which is the case if
+	 * either writes a component the other reads or writes
+	 */
+	bool conflicts(const SystemAccess &other) const;
+
+private:
+	template<typename C>
+	void mark(std::bitset<64> &mask){
+		mask.set(entityx::Component<C>::family());
+	}
+	template<typename C, typename D, typename... Rest>
+	void mark(std::bitset<64> &mask){
+		mark<C>(mask);
+		mark<D, Rest...>(mask);
+	}
+};
+
+/*
+ * Runs a set of systems each frame, letting systems that don't access
+ * the same components run at the same time on a thread pool. Each frame
+ * a dependency graph is built from the order the systems were added in:
+ * a system depends on every earlier system it conflicts with, so the
+ * results are the same as running them one after another in that order
+ *
+ * Systems pinned to the main thread are run by the thread calling update,
+ * which also helps the pool out with other work while it waits
+ *
+ * Note that the EventManager isn't thread safe, so systems emitting events
+ * should be pinned to the main thread
+ */
+class SystemScheduler {
+	struct Node {
+		std::string name;
+		//The name as it's shown in traces
+		const char *trace_name;
+		entityx::ptr<entityx::BaseSystem> system;
+		SystemAccess access;
+		//Time in seconds the system took to run in the last update
+		double time;
+	};
+	ThreadPool &pool;
+	entityx::ptr<entityx::EntityManager> entities;
+	entityx::ptr<entityx::EventManager> events;
+	std::vector<Node> nodes;
+
+public:
+	SystemScheduler(ThreadPool &pool, entityx::ptr<entityx::EntityManager> entities,
+		entityx::ptr<entityx::EventManager> events);
+	/*
+	 * Add a system that's been added to the system manager, the system's
+	 * access is taken from its static S::access() function
+	 */
+	template<typename S>
+	void add(entityx::ptr<S> system, const std::string &name){
+		add(system, S::access(), name);
+	}
+	void add(entityx::ptr<entityx::BaseSystem> system, const SystemAccess &access,
+		const std::string &name);
+	/*
+	 * Run all the systems for a frame, returns once they've all finished
+	 */
+	void update(double dt);
+	/*
+	 * Get the number of systems being scheduled
+	 */
+	size_t size() const;
+	/*
+	 * Get the name of system i
+	 */
+	const std::string& name(size_t i) const;
+	/*
+	 * Get the time in seconds system i took to run in the last update
+	 */
+	double time(size_t i) const;
+};
+
+#endif
+
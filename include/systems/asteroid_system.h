@@ -1,15 +1,41 @@
 #ifndef ASTEROID_SYSTEM_H
 #define ASTEROID_SYSTEM_H
 
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
 #include <entityx/entityx.h>
 #include "renderbatch.h"
 #include "model.h"
+#include "system_scheduler.h"
+#include "thread_pool.h"
+#include "philox.h"
+#include "components/kinematics.h"
 
 class AsteroidSystem : public entityx::System<AsteroidSystem> {
 	RenderBatch<glm::mat4, int> render_batch;
+	ThreadPool &pool;
+	std::shared_ptr<Kinematics> kinematics;
+	uint64_t seed;
+	//Asteroids in the pool and their colors for this frame, kept around to reuse the memory
+	std::vector<entityx::Entity::Id> visible;
+	std::vector<std::tuple<glm::mat4, int>> updates;
 
 public:
-	AsteroidSystem(size_t n);
+	/*
+	 * Create the system with room for n asteroids, the per asteroid
+	 * transforms are built in parallel on the pool. Each asteroid's color
+	 * is a fixed draw from the asteroid color stream of the seed keyed by
+	 * its entity id, so it doesn't change from frame to frame
+	 */
+	AsteroidSystem(ThreadPool &pool, size_t n, const std::shared_ptr<Kinematics> &kinematics,
+		uint64_t seed);
+	/*
+	 * Rendering reads the asteroid positions and must be on the main thread
+	 * since it uses OpenGL
+	 */
+	static SystemAccess access();
 	void update(entityx::ptr<entityx::EntityManager> es,
 		entityx::ptr<entityx::EventManager> events, double dt) override;
 };
@@ -0,0 +1,47 @@
+#ifndef COLLISION_SYSTEM_H
+#define COLLISION_SYSTEM_H
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <entityx/entityx.h>
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "system_scheduler.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+
+/*
+ * Finds the collidable entities that overlap each frame using a spatial hash
+ * and emits a CollisionEvent for each overlapping pair. Collisions across the
+ * playfield wrap aren't detected
+ */
+class CollisionSystem : public entityx::System<CollisionSystem> {
+	ThreadPool &pool;
+	std::shared_ptr<Kinematics> kinematics;
+	std::shared_ptr<Colliders> colliders;
+	SpatialHash hash;
+	//Shapes gathered from the pools for this frame, kept around to reuse the memory
+	std::vector<entityx::Entity::Id> ids;
+	std::vector<glm::vec2> positions;
+	std::vector<float> radii;
+	std::vector<SpatialHash::Pair> pairs;
+
+public:
+	CollisionSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics,
+		const std::shared_ptr<Colliders> &colliders);
+	/*
+	 * Collision reads positions and shapes, it's pinned to the main thread
+	 * since it emits events
+	 */
+	static SystemAccess access();
+	void update(entityx::ptr<entityx::EntityManager> es,
+		entityx::ptr<entityx::EventManager> events, double dt) override;
+	/*
+	 * Get the number of collisions found in the last update
+	 */
+	size_t collisions() const;
+};
+
+#endif
+
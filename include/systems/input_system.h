@@ -1,9 +1,32 @@
 #ifndef INPUT_SYSTEM_H
 #define INPUT_SYSTEM_H
 
+#include <cstdint>
+#include <memory>
 #include <entityx/entityx.h>
+#include "system_scheduler.h"
+#include "input_source.h"
+#include "components/kinematics.h"
 
-struct InputSystem : public entityx::System<InputSystem> {
+class InputSystem : public entityx::System<InputSystem> {
+	std::shared_ptr<Kinematics> kinematics;
+	std::shared_ptr<InputSource> source;
+	//The level's tick count, which follows the level when it's restored from a snapshot
+	const uint64_t &tick;
+
+public:
+	/*
+	 * Create the input system reading events from some source, each update
+	 * reads the events for the tick the level is on. The tick count must
+	 * outlive the system
+	 */
+	InputSystem(const std::shared_ptr<Kinematics> &kinematics,
+		const std::shared_ptr<InputSource> &source, const uint64_t &tick);
+	/*
+	 * Input sets the velocity of controllable entities and has to run on
+	 * the main thread to poll SDL and emit the input events
+	 */
+	static SystemAccess access();
 	void update(entityx::ptr<entityx::EntityManager> es,
 		entityx::ptr<entityx::EventManager> events, double dt) override;
 };
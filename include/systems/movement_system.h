@@ -1,9 +1,57 @@
 #ifndef MOVEMENT_SYSTEM_H
 #define MOVEMENT_SYSTEM_H
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
 #include <entityx/entityx.h>
+#include "movement_kernel.h"
+#include "thread_pool.h"
+#include "sim_lod.h"
+#include "system_scheduler.h"
+#include "components/kinematics.h"
 
-struct MovementSystem : public entityx::System<MovementSystem> {
+/*
+ * Integrates the positions of all entities in the kinematics pool, optionally
+ * wrapping them around the edges of the playfield. The pool is split into
+ * ranges that are integrated in parallel on the thread pool
+ */
+class MovementSystem : public entityx::System<MovementSystem> {
+	ThreadPool &pool;
+	std::shared_ptr<Kinematics> kinematics;
+	bool wrap;
+	kernel::Bounds bounds;
+	std::shared_ptr<SimLod> lod;
+	glm::vec2 lod_focus;
+	std::vector<SimLod::Range> ranges;
+
+public:
+	/*
+	 * Create a movement system that lets entities move freely
+	 */
+	MovementSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics);
+	/*
+	 * Create a movement system that wraps entities around the edges of the bounds
+	 */
+	MovementSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics,
+		const kernel::Bounds &bounds);
+	/*
+	 * Update entities far from the focus less often, see SimLod. The focus
+	 * should be the center of the view so the nearest bucket can be sized to
+	 * cover everything on screen. Returns the LOD so systems that predict
+	 * motion can find each entity's step
+	 */
+	std::shared_ptr<const SimLod> enable_lod(const std::vector<LodBucket> &buckets, const glm::vec2 &focus,
+		uint32_t rebucket_interval = 16);
+	/*
+	 * Get the LOD to save or restore its state, null if LOD isn't enabled
+	 */
+	const std::shared_ptr<SimLod>& sim_lod() const;
+	/*
+	 * Movement reads velocities to update positions
+	 */
+	static SystemAccess access();
 	void update(entityx::ptr<entityx::EntityManager> es,
 		entityx::ptr<entityx::EventManager> events, double dt) override;
 };
@@ -0,0 +1,76 @@
+#ifndef PHYSICS_SYSTEM_H
+#define PHYSICS_SYSTEM_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <entityx/entityx.h>
+#include "physics.h"
+#include "sim_lod.h"
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "system_scheduler.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+#include "components/rigid_body.h"
+
+/*
+ * Resolves collisions between rigid bodies by changing their velocities, it
+ * should run before movement integrates the positions. Each step the bodies'
+ * swept bounds are put in a spatial hash, the pairs that touch during the step
+ * become contacts and the contacts are split into islands of bodies touching
+ * each other which are solved in parallel. If movement is using a SimLod the
+ * bodies are swept over the ticks they move in one step
+ */
+class PhysicsSystem : public entityx::System<PhysicsSystem> {
+	ThreadPool &pool;
+	std::shared_ptr<Kinematics> kinematics;
+	std::shared_ptr<Colliders> colliders;
+	std::shared_ptr<Bodies> bodies;
+	std::shared_ptr<const SimLod> lod;
+	int iterations;
+	SpatialHash hash;
+	physics::UnionFind islands;
+	//Per body data gathered from the pools for this step
+	std::vector<entityx::Entity::Id> ids;
+	std::vector<glm::vec2> positions, velocities, swept_centers;
+	//steps is the time each body moves for in one step of the LOD
+	std::vector<float> radii, swept_radii, steps, inv_mass, restitution;
+	std::vector<physics::Shape> shapes;
+	std::vector<SpatialHash::Pair> pairs;
+	std::vector<physics::Contact> contacts, sorted;
+	//Island i's contacts are [island_starts[i], island_starts[i + 1]) of sorted
+	std::vector<uint32_t> island_of, island_starts;
+	//Island of each contact and the next free slot of each island while sorting
+	std::vector<uint32_t> contact_island, island_next;
+
+public:
+	PhysicsSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics,
+		const std::shared_ptr<Colliders> &colliders, const std::shared_ptr<Bodies> &bodies,
+		int iterations = 8);
+	/*
+	 * Physics reads the shapes and positions of bodies to change their velocities
+	 */
+	static SystemAccess access();
+	/*
+	 * Sweep bodies over the LOD step they move with, pass null to go back to
+	 * sweeping every body over one tick
+	 */
+	void set_lod(const std::shared_ptr<const SimLod> &lod);
+	void update(entityx::ptr<entityx::EntityManager> es,
+		entityx::ptr<entityx::EventManager> events, double dt) override;
+	/*
+	 * Get the number of contacts and islands solved in the last update
+	 */
+	size_t contact_count() const;
+	size_t island_count() const;
+
+private:
+	void gather(float dt);
+	void find_contacts(float dt);
+	void build_islands();
+};
+
+#endif
+
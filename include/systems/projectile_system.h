@@ -0,0 +1,89 @@
+#ifndef PROJECTILE_SYSTEM_H
+#define PROJECTILE_SYSTEM_H
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <glm/glm.hpp>
+#include <entityx/entityx.h>
+#include "renderbatch.h"
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "entity_pool.h"
+#include "projectile_pool.h"
+#include "movement_kernel.h"
+#include "system_scheduler.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+
+/*
+ * Fires, moves and draws the bullets shot by controllable entities. Bullets
+ * live in a ProjectilePool instead of being entities, each step the path of
+ * every bullet is tested against the asteroids near it and asteroids that
+ * get hit are despawned along with the bullets that hit them. Controllable
+ * entities can't be hit, so players don't shoot themselves
+ */
+class ProjectileSystem : public entityx::System<ProjectileSystem> {
+	ProjectilePool bullets;
+	RenderBatch<glm::mat4, int> render_batch;
+	ThreadPool &pool;
+	EntityPool &entity_pool;
+	std::shared_ptr<Kinematics> kinematics;
+	std::shared_ptr<Colliders> colliders;
+	kernel::Bounds bounds;
+	SpatialHash hash;
+	//Asteroids that can be hit this step with their positions split into x and y
+	//for the ray kernel. Kept around to reuse the memory
+	std::vector<entityx::Entity::Id> targets;
+	std::vector<glm::vec2> target_pos;
+	std::vector<float> target_x, target_y, target_r;
+	//The asteroids near a bullet gathered up for the ray kernel, one per thread
+	//that can run hit test tasks so they're only allocated once
+	struct NearTargets {
+		std::vector<int32_t> ids;
+		std::vector<float> x, y, r;
+	};
+	std::vector<NearTargets> near_targets;
+	//Asteroid hit by each bullet this step or -1
+	std::vector<int32_t> hits;
+	std::vector<std::tuple<glm::mat4, int>> updates;
+
+public:
+	/*
+	 * Create the system with room for capacity bullets in flight, bullets
+	 * wrap around the bounds like the asteroids do
+	 */
+	ProjectileSystem(ThreadPool &pool, EntityPool &entity_pool,
+		const std::shared_ptr<Kinematics> &kinematics, const std::shared_ptr<Colliders> &colliders,
+		size_t capacity, const kernel::Bounds &bounds);
+	/*
+	 * The projectiles read the shooter and asteroid positions and shapes, it's
+	 * pinned to the main thread since it draws the bullets
+	 */
+	static SystemAccess access();
+	void update(entityx::ptr<entityx::EntityManager> es,
+		entityx::ptr<entityx::EventManager> events, double dt) override;
+	/*
+	 * Get the bullets currently in flight
+	 */
+	ProjectilePool& projectiles();
+
+private:
+	/*
+	 * Fire a spread of bullets from each controllable entity that's shooting
+	 */
+	void fire(entityx::ptr<entityx::EntityManager> &es);
+	/*
+	 * Test each bullet's path over the step against the asteroids, killing
+	 * bullets and despawning the asteroids they hit
+	 */
+	void hit_test(entityx::ptr<entityx::EntityManager> &es, float dt);
+	/*
+	 * Draw the bullets still in flight
+	 */
+	void render();
+};
+
+#endif
+
@@ -0,0 +1,45 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <functional>
+#include <vector>
+#include "thread_pool.h"
+
+/*
+ * A graph of tasks with dependencies between them that can be run on a
+ * ThreadPool. A task runs once all the tasks preceding it have finished,
+ * tasks pinned to the main thread are run by the thread calling run
+ */
+class TaskGraph {
+	struct Task {
+		std::function<void()> fn;
+		std::vector<size_t> successors;
+		size_t dependencies;
+		bool main_thread;
+	};
+	std::vector<Task> tasks;
+
+public:
+	/*
+	 * Add a task to the graph, returns the id of the task
+	 */
+	size_t add(const std::function<void()> &fn, bool main_thread = false);
+	/*
+	 * Make task before finish before task after can start
+	 */
+	void precede(size_t before, size_t after);
+	/*
+	 * Run all tasks in the graph, returns once they're all done. The calling
+	 * thread runs the pinned tasks and helps the pool out with the others
+	 * The graph must not have cycles
+	 */
+	void run(ThreadPool &pool);
+	/*
+	 * Remove all tasks from the graph
+	 */
+	void clear();
+	size_t size() const;
+};
+
+#endif
+
@@ -1,12 +1,17 @@
 #ifndef TEXTURE_ATLAS_H
 #define TEXTURE_ATLAS_H
 
+#include <cstdint>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include <array>
 #include <SDL.h>
 #include <glm/glm.hpp>
 #include "gl_core_3_3.h"
+#include "atlas_descriptor.h"
+#include "atlas_cache.h"
+#include "sprite_id.h"
+#include "texture_loader.h"
 
 /*
  * Support for working with texture atlases described by the
@@ -25,23 +30,39 @@
  *
  * <TextureAtlas imagePath="image.png">
  *     <sprite n="sprite_1" x="0" y="50" w="100" h="125" />
+ *     <sprite n="sprite_2" x="100" y="50" w="100" h="125" r="y" />
  *     ...
  * </TextureAtlas>
  *
+ * Sprites with r="y" are stored turned 90 degrees clockwise in the image,
+ * which is what TexturePacker and tools/atlas_pack write for rotated sprites
+ *
  * Note that the actual names of the tags don't matter, only that the
  * correct attributes are there. Only the first TextureAtlas child will
  * be read in if multiple ones exist
+ *
+ * Documents are loaded through atlas_cache, the first load cooks a .atlas
+ * file next to the document that later loads map instead of parsing the XML
+ *
+ * Sprites can be looked up by name or by SpriteId, their index in the document.
+ * Ids are a direct index into the uv table, code that uses the same sprites
+ * every frame should look them up by id, either resolving the names once
+ * with id() or using the constants generated for the atlas by tools/atlas_ids
  */
 class TextureAtlas {
 	GLuint texture;
 	size_t width, height;
-	//Map of the uvs for each subtexture, accessed by subtexture name from
-	//the XML document
-	std::unordered_map<std::string, std::array<glm::vec2, 4>> images;
+	//Bytes used by the texture on the GPU
+	size_t bytes;
+	//The loader uploading the texture, if it was loaded through one
+	TextureLoader *loader;
+	//The cooked descriptor, kept to look up sprite ids by name
+	atlas_cache::CachedAtlas cached;
+	//The uvs of each subtexture, indexed by SpriteId
+	std::vector<std::array<glm::vec2, 4>> images;
 
 public:
-	using const_iterator =
-		std::unordered_map<std::string, std::array<glm::vec2, 4>>::const_iterator;
+	using const_iterator = std::vector<std::array<glm::vec2, 4>>::const_iterator;
 
 	/*
 	 * Load the texture atlas described by the xml file
@@ -50,6 +71,12 @@ public:
 	 * folder as the xml document being loaded
 	 */
 	TextureAtlas(const std::string &file);
+	/*
+	 * Load the texture atlas with its image decoded and uploaded in the
+	 * background by the loader, the uvs are available right away but the
+	 * texture is empty until the loader has uploaded it
+	 */
+	TextureAtlas(const std::string &file, TextureLoader &loader);
 	/*
 	 * Destroy the OpenGL texture being referenced
 	 */
@@ -65,12 +92,30 @@ public:
 	 * returns all -1 if the name isn't found
 	 */
 	std::array<glm::vec2, 4> uvs(const std::string &name) const;
+	/*
+	 * Get the uvs for an image by id, the id must be valid for this atlas
+	 */
+	const std::array<glm::vec2, 4>& uvs(SpriteId id) const;
+	/*
+	 * Get the id of an image by name, returns INVALID_SPRITE if the name isn't found
+	 */
+	SpriteId id(const std::string &name) const;
+	/*
+	 * Get the name of an image by id
+	 */
+	std::string name(SpriteId id) const;
 	/*
 	 * Check if an image with some name is contained in this atlas
 	 */
 	bool has_image(const std::string &name) const;
 	/*
-	 * Get a const iterator to the beginning/end of the list of subtextures
+	 * Get the hash of the xml document the atlas was loaded from, to check
+	 * that sprite ids generated by tools/atlas_ids came from the same document
+	 */
+	uint64_t source_hash() const;
+	/*
+	 * Get a const iterator to the beginning/end of the list of subtexture uvs,
+	 * in id order
 	 */
 	const_iterator cbegin() const;
 	const_iterator cend() const;
@@ -81,19 +126,11 @@ public:
 
 private:
 	/*
-	 * Load the texture atlas described by the xml file
+	 * Load the image of the cooked atlas and fill out the uv table,
+	 * through the loader if one is passed
 	 */
-	void load(const std::string &file);
-	/*
-	 * Load the information about the images in the atlas from
-	 * the children of the <TextureAtlas> node passed
-	 */
-	void load(tinyxml2::XMLNode *node);
+	void load(const std::string &file, TextureLoader *loader);
 };
-/*
- * Map tinyxml errors to printable strings
- */
-std::string get_xml_error(const tinyxml2::XMLError &error);
 
 #endif
 
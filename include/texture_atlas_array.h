@@ -10,6 +10,7 @@
 #include <SDL.h>
 #include <glm/glm.hpp>
 #include "gl_core_3_3.h"
+#include "texture_loader.h"
 
 /*
  * Support for working with arrays of texture atlases described by the
@@ -35,9 +36,13 @@
  *
  * <TextureAtlas imagePath="image.png">
  *     <sprite n="sprite_1" x="0" y="50" w="100" h="125" />
+ *     <sprite n="sprite_2" x="100" y="50" w="100" h="125" r="y" />
  *     ...
  * </TextureAtlas>
  *
+ * Sprites with r="y" are stored turned 90 degrees clockwise in the image,
+ * which is what TexturePacker and tools/atlas_pack write for rotated sprites
+ *
  * Note that the actual names of the tags don't matter, only that the
  * correct attributes are there. Only the first TextureAtlas child will
  * be read in if multiple ones exist
@@ -45,6 +50,10 @@
 class TextureAtlasArray {
 	GLuint texture;
 	size_t width, height;
+	//Bytes used by the texture on the GPU
+	size_t bytes;
+	//The loader uploading the texture, if it was loaded through one
+	TextureLoader *loader;
 	std::unordered_map<std::string, std::array<glm::vec3, 4>> images;
 
 public:
@@ -58,6 +67,12 @@ public:
 	 */
 	TextureAtlasArray(const std::vector<std::string> &files);
 	TextureAtlasArray(const std::initializer_list<std::string> &files);
+	/*
+	 * Load the texture atlases with their images decoded and uploaded in
+	 * the background by the loader, the uvs are available right away but the
+	 * texture is empty until the loader has uploaded it
+	 */
+	TextureAtlasArray(const std::vector<std::string> &files, TextureLoader &loader);
 	/*
 	 * Destroy the OpenGL texture being referenced
 	 */
@@ -95,13 +110,6 @@ private:
 	 * returns the name of the image file to load for this atlas
 	 */
 	std::string load(const std::string &file, int img);
-	/*
-	 * Load the information about the images in the atlas from
-	 * the children of the <TextureAtlas> node passed
-	 * img refers to the index in the array of textures of
-	 * the atlas being loaded
-	 */
-	void load(tinyxml2::XMLNode *node, int img);
 	/*
 	 * Scale the sizes into normalized uv coordinates range
 	 * and set the y axis to match OpenGL
@@ -0,0 +1,140 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "gl_core_3_3.h"
+#include "thread_pool.h"
+
+/*
+ * Loads textures without blocking the GL thread on decoding. Requesting a
+ * texture reads just the image headers to create the texture and its storage
+ * right away, so it can be bound and its size used immediately, while the
+ * images are decoded and y-flipped on the thread pool. The GL thread then
+ * calls update to copy decoded images into a ring of pixel buffer objects
+ * and issue glTexSubImage from them, which lets the driver do the copy to the
+ * texture asynchronously. Mipmaps are generated on the update after a texture's
+ * last image is uploaded, until then the texture's max level is 0 so it samples
+ * from the base level only. KTX files are loaded right away since they
+ * don't need decoding
+ *
+ * The loader must be used from the thread owning the GL context and must be
+ * destroyed before the pool it's using
+ */
+class TextureLoader {
+public:
+	/*
+	 * Info about a requested texture, texture is 0 if the request failed.
+	 * bytes is the size of the texture on the GPU, including its mipmaps
+	 */
+	struct Info {
+		GLuint texture;
+		size_t width, height, layers, bytes;
+	};
+
+private:
+	//An image to be decoded or uploaded into layer of texture
+	struct Image {
+		GLuint texture;
+		//The request the image belongs to, the texture's name may be reused
+		//by a later request if it's cancelled while the image is decoding
+		uint64_t request;
+		GLenum target;
+		GLenum format;
+		int width, height, channels, layer;
+		std::string file;
+		//The decoded pixels, nullptr if decoding failed
+		unsigned char *pixels;
+	};
+	//A texture with images still to upload
+	struct Pending {
+		uint64_t request;
+		GLenum target;
+		size_t layers_left;
+	};
+	ThreadPool &pool;
+	std::vector<GLuint> pbos;
+	size_t next_pbo;
+	//Images waiting on a worker to decode them
+	std::atomic<size_t> decoding;
+	std::mutex decoded_mutex;
+	std::vector<Image> decoded;
+	//Decoded images waiting for the GL thread to upload them
+	std::deque<Image> staged;
+	std::unordered_map<GLuint, Pending> pending;
+	uint64_t next_request;
+	//Textures and their targets to generate mipmaps for on the next update
+	std::vector<std::pair<GLuint, GLenum>> mips;
+
+public:
+	/*
+	 * Create a loader decoding on the pool passed and uploading through a
+	 * ring of some number of pixel buffer objects
+	 */
+	TextureLoader(ThreadPool &pool, size_t ring_size = 3);
+	/*
+	 * Waits for images still being decoded, any that weren't uploaded are dropped
+	 */
+	~TextureLoader();
+	TextureLoader(const TextureLoader&) = delete;
+	TextureLoader& operator=(const TextureLoader&) = delete;
+	/*
+	 * Request an image be loaded into a 2D texture, the texture is created
+	 * and bound to GL_TEXTURE_2D on the active texture unit
+	 */
+	Info load(const std::string &file);
+	/*
+	 * Request a series of images be loaded into a 2D texture array, in the order
+	 * they're passed. The texture is created and bound to GL_TEXTURE_2D_ARRAY on the
+	 * active texture unit. It's an error if the images don't all have the same
+	 * dimensions and format
+	 */
+	Info load_array(const std::vector<std::string> &files);
+	/*
+	 * Upload decoded images until at least budget bytes have been sent, at least
+	 * one image is uploaded if any are ready, and generate mipmaps for the textures
+	 * finished on the previous update. Textures are bound to the active texture
+	 * unit while uploading. Returns true if there's still work outstanding
+	 */
+	bool update(size_t budget = std::numeric_limits<size_t>::max());
+	/*
+	 * Stop loading a texture, its images that are decoded or staged are dropped
+	 * and ones still decoding are dropped once they finish. This must be called
+	 * before deleting a texture that was requested from the loader
+	 */
+	void cancel(GLuint texture);
+	/*
+	 * Check if every requested texture has been uploaded and had its mipmaps made
+	 */
+	bool done();
+	/*
+	 * Finish loading everything requested, the calling thread helps decode
+	 */
+	void finish();
+
+private:
+	/*
+	 * Create the texture for some images, using the dimensions and format read
+	 * from their headers, and queue them for decoding
+	 */
+	Info request(GLenum target, const std::vector<std::string> &files);
+	/*
+	 * Decode and flip an image, run on the pool
+	 */
+	void decode(Image img);
+	/*
+	 * Upload a decoded image through the next pixel buffer in the ring
+	 */
+	void upload(Image &img);
+};
+
+#endif
+
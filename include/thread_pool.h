@@ -0,0 +1,100 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A work stealing thread pool. Each worker has its own deque of tasks, it
+ * takes work from the back of its own deque and when that's empty steals
+ * from the front of the other workers' deques. Tasks submitted from a
+ * worker go on that worker's deque, tasks submitted from other threads
+ * are spread round robin over the workers
+ *
+ * Threads outside the pool that are waiting on tasks should call run_one
+ * to help out instead of blocking, which also lets a pool with no workers
+ * run everything on the calling thread
+ */
+class ThreadPool {
+	using Task = std::function<void()>;
+	struct Queue {
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+	std::mutex sleep_mutex;
+	std::condition_variable wake;
+	//Number of tasks sitting in the queues
+	std::atomic<size_t> pending;
+	std::atomic<size_t> next_queue;
+	std::atomic<bool> quit;
+
+public:
+	/*
+	 * Create a pool with some number of worker threads, the default
+	 * leaves one hardware thread for the main thread
+	 */
+	ThreadPool(size_t workers = default_workers());
+	/*
+	 * Stop and join the workers, any tasks still queued are dropped so
+	 * outstanding work should be waited on before destroying the pool
+	 */
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	/*
+	 * Queue a task to be run by the pool
+	 */
+	void submit(Task task);
+	/*
+	 * Try to run a single queued task on the calling thread, returns
+	 * false if there was no work to be found
+	 */
+	bool run_one();
+	/*
+	 * Run fn over the range [begin, end) split into chunks of about grain
+	 * elements, fn is called as fn(chunk_begin, chunk_end) and the call returns
+	 * once all chunks are done. The calling thread works on chunks as well
+	 * Chunks are split at the same points no matter how many threads there are,
+	 * so as long as fn only writes to the elements in its chunk the output is
+	 * the same as running it serially
+	 */
+	void parallel_for(size_t begin, size_t end, size_t grain,
+		const std::function<void(size_t, size_t)> &fn);
+	/*
+	 * Help run tasks until the counter reaches 0
+	 */
+	void wait(const std::atomic<size_t> &counter);
+	/*
+	 * Get the number of worker threads in the pool
+	 */
+	size_t size() const;
+	/*
+	 * Get the index of the calling thread's worker in this pool, the
+	 * index is in [0, size()) for workers and size() for any other thread
+	 */
+	size_t thread_index() const;
+	/*
+	 * Number of workers used by default, one less than the hardware threads
+	 */
+	static size_t default_workers();
+
+private:
+	void worker(size_t index);
+	/*
+	 * Take a task for the thread owning queue index, first checking the back of
+	 * its own queue then stealing from the front of the others. Threads outside
+	 * the pool pass size() and only steal
+	 */
+	bool take(size_t index, Task &task);
+};
+
+#endif
+
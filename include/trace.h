@@ -0,0 +1,100 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/*
+ * Scoped timers written out in the Chrome trace event format, the traces can
+ * be opened in chrome://tracing or Perfetto. Each thread records into its own
+ * fixed size ring buffer so recording doesn't take any locks, when a ring is
+ * full new events are dropped until it's flushed. A thread only gets a ring
+ * when it first records an event and the rings of threads that have exited
+ * are reused once they've been flushed
+ *
+ * The TRACE_* macros compile to nothing unless ASTEROIDS_TRACE is defined, so
+ * instrumentation can be left in hot code. Recording is off until enable is
+ * called, when sampling every n frames only every nth frame (marked by
+ * TRACE_FRAME) is recorded so tracing can be left on without filling the rings
+ */
+namespace trace {
+#ifdef ASTEROIDS_TRACE
+	const bool COMPILED_IN = true;
+#else
+	const bool COMPILED_IN = false;
+#endif
+	namespace detail {
+		//If the current frame is being recorded
+		extern std::atomic<bool> recording;
+	}
+	/*
+	 * Start recording, keeping one of every n frames
+	 */
+	void enable(uint32_t every_n_frames = 1);
+	void disable();
+	inline bool active(){
+		return detail::recording.load(std::memory_order_relaxed);
+	}
+	/*
+	 * Mark the start of a new frame, deciding if it will be recorded
+	 */
+	void begin_frame();
+	/*
+	 * Name the calling thread in the trace
+	 */
+	void set_thread_name(const std::string &name);
+	/*
+	 * Get a copy of the string that lives until the program exits, for
+	 * naming scopes with strings that aren't literals
+	 */
+	const char* intern(const std::string &name);
+	/*
+	 * Get the current time in nanoseconds on the trace clock
+	 */
+	uint64_t now();
+	/*
+	 * Record an event on the calling thread that ran from start to end, name
+	 * must stay valid until the events are flushed
+	 */
+	void record(const char *name, uint64_t start, uint64_t end);
+	/*
+	 * Write the events recorded so far by all threads to a trace file, the
+	 * events written are removed from the rings. Returns false if the file
+	 * couldn't be written
+	 */
+	bool flush(const std::string &file);
+
+	/*
+	 * Records an event for its lifetime if the frame is being recorded
+	 */
+	class Scope {
+		const char *name;
+		uint64_t start;
+
+	public:
+		Scope(const char *n) : name(active() ? n : nullptr), start(name ? now() : 0) {}
+		~Scope(){
+			if (name){
+				record(name, start, now());
+			}
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+}
+
+#ifdef ASTEROIDS_TRACE
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(trace_scope_, __LINE__){name}
+#define TRACE_FRAME() trace::begin_frame()
+#define TRACE_THREAD_NAME(name) trace::set_thread_name(name)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_FRAME()
+#define TRACE_THREAD_NAME(name)
+#endif
+
+#endif
+
@@ -0,0 +1,20 @@
+#ifndef TYPE_INDEX_H
+#define TYPE_INDEX_H
+
+#include <type_traits>
+
+namespace detail {
+/*
+ * Find the index of the first occurance of T in the List of types,
+ * accessed through IndexOf::value
+ */
+template<typename T, typename... List>
+struct IndexOf;
+template<typename T, typename... List>
+struct IndexOf<T, T, List...> : std::integral_constant<int, 0> {};
+template<typename T, typename U, typename... List>
+struct IndexOf<T, U, List...> : std::integral_constant<int, 1 + IndexOf<T, List...>::value> {};
+}
+
+#endif
+
@@ -27,6 +27,17 @@ namespace util {
 	* the string will be empty
 	*/
 	std::string read_file(const std::string &fName);
+	/*
+	 * Get the path of the cache for some file, the file's extension is
+	 * replaced with ext, eg. model.obj with ".mesh" gives model.mesh
+	 */
+	std::string cache_path(const std::string &file, const std::string &ext);
+	/*
+	 * Move a finished temporary file over file. Caches are written to a temporary
+	 * file and then moved into place so a crash or another process never leaves a
+	 * partly written one behind. Returns false and removes tmp if it couldn't be moved
+	 */
+	bool replace_file(const std::string &tmp, const std::string &file);
 	/*
 	 * Load a GLSL shader from some file, returns -1 if loading failed
 	 */
@@ -35,25 +46,52 @@ namespace util {
 	 * Build a shader program from the list of shaders passed
 	 */
 	GLint load_program(const std::vector<std::tuple<GLenum, std::string>> &shaders);
+	/*
+	 * Flip an image of some number of rows of row_bytes each upside down so
+	 * OpenGL has it right-side up
+	 */
+	void flip_rows(unsigned char *img, size_t row_bytes, size_t rows);
+	/*
+	 * Get the bytes used by a texture of some number of w x h layers with n bytes
+	 * per texel and a full mip chain
+	 */
+	size_t mip_chain_bytes(size_t w, size_t h, size_t layers, size_t n);
+	/*
+	 * Get the GL format for an image with some number of 8 bit channels
+	 */
+	GLenum image_format(int channels);
+	/*
+	 * Read the size of an image from its header without decoding it,
+	 * returns false if the file couldn't be read
+	 */
+	bool image_size(const std::string &file, size_t &width, size_t &height);
 	/*
 	 * Load an image into a 2D texture, creating a new texture id
+	 * KTX files are loaded with their mip chain through ktx::load
 	 * The texture unit desired for this texture should be set active
 	 * before loading the texture as it will be bound during the loading process
 	 * Can also optionally pass width & height variables to return the width
-	 * and height of the loaded image
+	 * and height of the loaded image and bytes to return the size of the texture
+	 * on the GPU, including its mipmaps
 	 */
-	GLuint load_texture(const std::string &file, size_t *width = nullptr, size_t *height = nullptr);
+	GLuint load_texture(const std::string &file, size_t *width = nullptr, size_t *height = nullptr,
+		size_t *bytes = nullptr);
 	/*
 	 * Load a series of images into a 2D texture array, creating a new texture id
 	 * The images will appear in the array in the same order they're passed in
+	 * KTX files are loaded with their mip chain through ktx::load
 	 * It is an error if the images don't all have the same dimensions
 	 * or have different formats
+	 * The array is allocated from the image headers then each layer is decoded
+	 * and uploaded in turn, so only one layer is held in memory at a time
 	 * The texture unit desired for this texture should be set active
 	 * before loading the texture as it will be bound during the loading process
 	 * Can also optionally pass width & height variables to return the width
-	 * and height of the loaded image
+	 * and height of the loaded image and bytes to return the size of the texture
+	 * on the GPU, including its mipmaps
 	 */
-	GLuint load_texture_array(const std::vector<std::string> &files, size_t *w = nullptr, size_t *h = nullptr);
+	GLuint load_texture_array(const std::vector<std::string> &files, size_t *w = nullptr, size_t *h = nullptr,
+		size_t *bytes = nullptr);
 	/*
 	 * Check for an OpenGL error and log it along with the message passed
 	 * if an error occured. Will return true if an error occured & was logged
@@ -70,31 +108,15 @@ namespace util {
 		GLsizei len, const GLchar *msg, const GLvoid *user);
 #endif
 	/*
-	* Load an OBJ model file into the vbo and ebo passed in
-	* The model must have vertex, texture and normal data and be a triangle mesh
+	* Load an OBJ model file into the vbo and ebo passed in, see util::parse_obj
+	* for what's supported
 	* The vbo elems are: vec3 pos, vec3 normal, vec3 uv
 	* returns true on success, false on failure
 	* TODO: Take any buffer layout?
 	*/
 	bool load_obj(const std::string &fname,
 		InterleavedBuffer<Layout::PACKED, glm::vec3, glm::vec3, glm::vec3> &vbo,
-		InterleavedBuffer<Layout::PACKED, GLushort> &ebo, size_t &n_elems);
-	/*
-	* Functions to get values from formatted strings, for use in reading the
-	* model file
-	*/
-	glm::vec2 capture_vec2(const std::string &str);
-	glm::vec3 capture_vec3(const std::string &str);
-	/*
-	* Get the vertex informaton for a face as an array of strings containing
-	* the face data. 3 are returned for tri faces, 4 for quad faces
-	*/
-	std::vector<std::string> capture_faces(const std::string &str);
-	/*
-	* Capture the indices of the vertex components, the array contains the
-	* face information: v/vt/vn
-	*/
-	std::array<unsigned int, 3> capture_vertex(const std::string &str);
+		InterleavedBuffer<Layout::PACKED, GLuint> &ebo, size_t &n_elems);
 }
 
 #endif
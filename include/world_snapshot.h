@@ -0,0 +1,189 @@
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <entityx/entityx.h>
+#include "component_pool.h"
+#include "type_at.h"
+
+/*
+ * A versioned binary snapshot of the world. The file is a header followed by
+ * blocks, each block holds a contiguous array of one kind of data (the ids of a
+ * pool, one component type, ...) and is tagged with a four character code and
+ * its element size so mismatched layouts are caught on load. Block data is
+ * 8 byte aligned in the file so the whole file can be read in one go and the
+ * arrays copied straight out of it
+ */
+namespace snapshot {
+	const uint32_t MAGIC = 0x4e535741;
+	const uint32_t VERSION = 1;
+
+	struct Header {
+		uint32_t magic, version, blocks, reserved;
+		uint64_t tick;
+	};
+	struct BlockHeader {
+		uint32_t tag, elem_size;
+		uint64_t count;
+	};
+	/*
+	 * Make a block tag from a four character code
+	 */
+	constexpr uint32_t tag(const char (&code)[5]){
+		return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8
+			| static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+	}
+
+	class Writer {
+		std::ofstream out;
+		Header header;
+
+	public:
+		Writer(const std::string &file, uint64_t tick);
+		/*
+		 * Write a block of count elements of elem_size bytes
+		 */
+		void block(uint32_t tag, const void *data, uint32_t elem_size, uint64_t count);
+		template<typename T>
+		void block(uint32_t tag, const T *data, uint64_t count){
+			static_assert(std::is_trivially_copyable<T>::value, "Snapshot blocks must be trivially copyable");
+			block(tag, data, sizeof(T), count);
+		}
+		/*
+		 * Write the ids and components of a pool as one block per array, the ids
+		 * get the first tag and each component type the following ones
+		 */
+		template<typename... Components>
+		void pool(const ComponentPool<Components...> &p, const uint32_t (&tags)[sizeof...(Components) + 1]){
+			block(tags[0], p.id_data(), p.size());
+			pool_blocks<0>(p, tags);
+		}
+		/*
+		 * Finish the snapshot, filling in the block count, returns false if
+		 * any writes failed
+		 */
+		bool finish();
+
+	private:
+		template<int N, typename... Components>
+		typename std::enable_if<N < sizeof...(Components)>::type
+		pool_blocks(const ComponentPool<Components...> &p, const uint32_t (&tags)[sizeof...(Components) + 1]){
+			using C = typename detail::TypeAt<N, Components...>::type;
+			block(tags[N + 1], p.template data<C>(), p.size());
+			pool_blocks<N + 1>(p, tags);
+		}
+		template<int N, typename... Components>
+		typename std::enable_if<N == sizeof...(Components)>::type
+		pool_blocks(const ComponentPool<Components...>&, const uint32_t (&)[sizeof...(Components) + 1]){}
+	};
+
+	class Reader {
+		struct Block {
+			BlockHeader header;
+			const char *data;
+		};
+		//Storage for the file, kept as uint64s so the block data is aligned
+		std::unique_ptr<uint64_t[]> storage;
+		Header header;
+		std::vector<Block> blocks;
+		bool loaded;
+
+	public:
+		/*
+		 * Read a snapshot file, check good() to see if it was valid
+		 */
+		Reader(const std::string &file);
+		bool good() const;
+		uint64_t tick() const;
+		/*
+		 * Get a block's data and element count, returns nullptr if there's no such
+		 * block or its elements aren't the size expected
+		 */
+		const void* block(uint32_t tag, uint32_t elem_size, uint64_t &count) const;
+		template<typename T>
+		const T* block(uint32_t tag, uint64_t &count) const {
+			static_assert(std::is_trivially_copyable<T>::value, "Snapshot blocks must be trivially copyable");
+			return static_cast<const T*>(block(tag, sizeof(T), count));
+		}
+		/*
+		 * Check that a pool written by Writer::pool can be restored into p without
+		 * restoring it: all its blocks are there with matching sizes and each saved
+		 * id is a different one of the snapshot's entities. slot(id) gives the index
+		 * of id among the entities, or entities if it isn't one of them
+		 */
+		template<typename... Components, typename F>
+		bool pool_ok(const ComponentPool<Components...>&, const uint32_t (&tags)[sizeof...(Components) + 1],
+			size_t entities, const F &slot) const
+		{
+			uint64_t count = 0;
+			const entityx::Entity::Id *ids = block<entityx::Entity::Id>(tags[0], count);
+			if (!ids || !pool_valid<0, Components...>(tags, count)){
+				return false;
+			}
+			//An entity in the pool twice would have two components restored onto it
+			std::vector<bool> seen(entities, false);
+			for (size_t i = 0; i < count; ++i){
+				const size_t s = slot(ids[i]);
+				if (s >= entities || seen[s]){
+					return false;
+				}
+				seen[s] = true;
+			}
+			return true;
+		}
+		/*
+		 * Restore a pool written by Writer::pool, the ids in the snapshot are mapped to
+		 * new ids with remap(id) and the component arrays are copied in bulk. Returns
+		 * false if any of the blocks are missing or don't match
+		 */
+		template<typename... Components, typename F>
+		bool pool(ComponentPool<Components...> &p, const uint32_t (&tags)[sizeof...(Components) + 1],
+			const F &remap) const
+		{
+			uint64_t count = 0;
+			const entityx::Entity::Id *ids = block<entityx::Entity::Id>(tags[0], count);
+			if (!ids || !pool_valid<0, Components...>(tags, count)){
+				return false;
+			}
+			std::vector<entityx::Entity::Id> remapped(count);
+			for (size_t i = 0; i < count; ++i){
+				remapped[i] = remap(ids[i]);
+			}
+			p.assign_ids(remapped.data(), count);
+			pool_copy<0>(p, tags);
+			return true;
+		}
+
+	private:
+		template<size_t N, typename C, typename... Rest, size_t T>
+		bool pool_valid(const uint32_t (&tags)[T], uint64_t count) const {
+			uint64_t n = 0;
+			return block<C>(tags[N + 1], n) && n == count && pool_valid<N + 1, Rest...>(tags, count);
+		}
+		template<size_t N, size_t T>
+		bool pool_valid(const uint32_t (&)[T], uint64_t) const {
+			return true;
+		}
+		template<int N, typename... Components>
+		typename std::enable_if<N < sizeof...(Components)>::type
+		pool_copy(ComponentPool<Components...> &p, const uint32_t (&tags)[sizeof...(Components) + 1]) const {
+			using C = typename detail::TypeAt<N, Components...>::type;
+			uint64_t n = 0;
+			const C *data = block<C>(tags[N + 1], n);
+			std::memcpy(p.template data<C>(), data, n * sizeof(C));
+			pool_copy<N + 1>(p, tags);
+		}
+		template<int N, typename... Components>
+		typename std::enable_if<N == sizeof...(Components)>::type
+		pool_copy(ComponentPool<Components...>&, const uint32_t (&)[sizeof...(Components) + 1]) const {}
+	};
+}
+
+#endif
+
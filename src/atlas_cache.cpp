@@ -0,0 +1,236 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "hash.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "util.h"
+#include "mapped_file.h"
+#include "perfect_hash.h"
+#include "atlas_descriptor.h"
+#include "atlas_cache.h"
+
+namespace {
+	inline uint64_t align8(uint64_t x){
+		return (x + 7) & ~uint64_t{7};
+	}
+}
+
+atlas_cache::CachedAtlas::CachedAtlas(const std::string &file) : mapped(new MappedFile{file}),
+	data(mapped->data()), header(), valid(false)
+{
+	if (mapped->good()){
+		validate(mapped->size());
+	}
+}
+atlas_cache::CachedAtlas::CachedAtlas(std::vector<char> cooked) : owned(std::move(cooked)),
+	data(owned.data()), header(), valid(false)
+{
+	validate(owned.size());
+}
+bool atlas_cache::CachedAtlas::good() const {
+	return valid;
+}
+const atlas_cache::Header& atlas_cache::CachedAtlas::info() const {
+	return header;
+}
+size_t atlas_cache::CachedAtlas::size() const {
+	return header.sprite_count;
+}
+std::string atlas_cache::CachedAtlas::image() const {
+	return std::string{data + header.strings_offset + header.image, header.image_length};
+}
+const atlas_cache::Sprite& atlas_cache::CachedAtlas::sprite(size_t i) const {
+	return reinterpret_cast<const Sprite*>(data + header.sprites_offset)[i];
+}
+std::string atlas_cache::CachedAtlas::name(size_t i) const {
+	const Sprite &s = sprite(i);
+	return std::string{data + header.strings_offset + s.name, s.name_length};
+}
+size_t atlas_cache::CachedAtlas::find(const std::string &name) const {
+	const char *strings = data + header.strings_offset;
+	auto matches = [&](size_t i){
+		const Sprite &s = sprite(i);
+		return s.name_length == name.size() && std::memcmp(strings + s.name, name.data(), name.size()) == 0;
+	};
+	if (header.hash_slots == 0){
+		//The names couldn't be hashed when cooking, fall back to searching for the last match
+		for (size_t i = size(); i-- > 0;){
+			if (matches(i)){
+				return i;
+			}
+		}
+		return size();
+	}
+	const uint32_t *seeds = hash_table();
+	const uint32_t *slots = seeds + header.hash_seeds;
+	const size_t i = slots[perfect_hash::slot(name.data(), name.size(), seeds, header.hash_seeds,
+		header.hash_slots)];
+	return matches(i) ? i : size();
+}
+const glm::vec2* atlas_cache::CachedAtlas::uvs(size_t i) const {
+	return reinterpret_cast<const glm::vec2*>(data + header.uvs_offset) + 4 * i;
+}
+AtlasSprite atlas_cache::CachedAtlas::atlas_sprite(size_t i) const {
+	const Sprite &s = sprite(i);
+	return AtlasSprite{"", s.x, s.y, s.w, s.h, s.rotated != 0};
+}
+const uint32_t* atlas_cache::CachedAtlas::hash_table() const {
+	return reinterpret_cast<const uint32_t*>(data + header.hash_offset);
+}
+void atlas_cache::CachedAtlas::validate(size_t len){
+	if (len < sizeof(Header)){
+		return;
+	}
+	std::memcpy(&header, data, sizeof(Header));
+	const uint64_t n = header.sprite_count;
+	if (header.magic != MAGIC || header.version != VERSION
+		|| header.sprites_offset % 8 != 0 || header.uvs_offset % 8 != 0
+		|| header.hash_offset % 4 != 0 || header.hash_slots > n
+		|| (header.hash_slots != 0 && header.hash_seeds == 0))
+	{
+		return;
+	}
+	//The offsets are checked to be in order and in the file before any sizes are
+	//compared against the space between them, so a bad offset can't wrap around
+	if (header.sprites_offset < sizeof(Header) || header.uvs_offset < header.sprites_offset
+		|| header.hash_offset < header.uvs_offset || header.strings_offset < header.hash_offset
+		|| header.strings_offset > len
+		|| n * sizeof(Sprite) > header.uvs_offset - header.sprites_offset
+		|| n * 4 * sizeof(glm::vec2) > header.hash_offset - header.uvs_offset
+		|| (uint64_t{header.hash_seeds} + header.hash_slots) * 4 > header.strings_offset - header.hash_offset
+		|| header.strings_size > len - header.strings_offset
+		|| uint64_t{header.image} + header.image_length > header.strings_size)
+	{
+		return;
+	}
+	//Check every name and hash slot is in bounds so lookups don't need to
+	for (size_t i = 0; i < n; ++i){
+		const Sprite &s = sprite(i);
+		if (uint64_t{s.name} + s.name_length > header.strings_size){
+			return;
+		}
+	}
+	const uint32_t *slots = hash_table() + header.hash_seeds;
+	for (size_t i = 0; i < header.hash_slots; ++i){
+		if (slots[i] >= n){
+			return;
+		}
+	}
+	valid = true;
+}
+
+std::string atlas_cache::cache_path(const std::string &xml, const std::string &cache_dir){
+	const std::string cache = util::cache_path(xml, EXTENSION);
+	if (cache_dir.empty()){
+		return cache;
+	}
+	return cache_dir + util::PATH_SEP + cache.substr(cache.find_last_of("/\\") + 1);
+}
+std::vector<char> atlas_cache::cook(const AtlasDescriptor &desc, const std::string &image,
+	uint64_t source_hash, size_t width, size_t height)
+{
+	TRACE_SCOPE("atlas_cache::cook");
+	std::string strings = image;
+	std::vector<Sprite> sprites;
+	std::vector<glm::vec2> uvs;
+	sprites.reserve(desc.sprites.size());
+	uvs.reserve(4 * desc.sprites.size());
+	std::vector<std::string> names;
+	names.reserve(desc.sprites.size());
+	const glm::vec2 dim{width, height};
+	for (const AtlasSprite &s : desc.sprites){
+		names.push_back(s.name);
+		sprites.push_back(Sprite{static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(s.name.size()),
+			s.x, s.y, s.w, s.h, s.rotated, 0});
+		strings += s.name;
+		//If we couldn't find the image size the uvs are left as 0, they won't
+		//match the texture's size and will be recomputed on load
+		const std::array<glm::vec2, 4> u = width && height ? s.uvs(dim) : std::array<glm::vec2, 4>{};
+		uvs.insert(uvs.end(), u.begin(), u.end());
+	}
+	std::vector<uint32_t> seeds, slots;
+	if (!perfect_hash::build(names, seeds, slots)){
+		std::cerr << "Warning: couldn't build a perfect hash of the sprite names, "
+			<< "lookups by name will search the sprites\n";
+		seeds.clear();
+		slots.clear();
+	}
+	Header h = Header();
+	h.magic = MAGIC;
+	h.version = VERSION;
+	h.source_hash = source_hash;
+	h.sprite_count = static_cast<uint32_t>(sprites.size());
+	h.image_width = static_cast<uint32_t>(width);
+	h.image_height = static_cast<uint32_t>(height);
+	h.image = 0;
+	h.image_length = static_cast<uint32_t>(image.size());
+	h.hash_seeds = static_cast<uint32_t>(seeds.size());
+	h.hash_slots = static_cast<uint32_t>(slots.size());
+	h.sprites_offset = align8(sizeof(Header));
+	h.uvs_offset = h.sprites_offset + sprites.size() * sizeof(Sprite);
+	h.hash_offset = h.uvs_offset + uvs.size() * sizeof(glm::vec2);
+	h.strings_offset = h.hash_offset + (seeds.size() + slots.size()) * sizeof(uint32_t);
+	h.strings_size = strings.size();
+
+	std::vector<char> out(h.strings_offset + h.strings_size, 0);
+	std::memcpy(out.data(), &h, sizeof(Header));
+	if (!sprites.empty()){
+		std::memcpy(&out[h.sprites_offset], sprites.data(), sprites.size() * sizeof(Sprite));
+		std::memcpy(&out[h.uvs_offset], uvs.data(), uvs.size() * sizeof(glm::vec2));
+	}
+	if (!slots.empty()){
+		std::memcpy(&out[h.hash_offset], seeds.data(), seeds.size() * sizeof(uint32_t));
+		std::memcpy(&out[h.hash_offset + seeds.size() * sizeof(uint32_t)], slots.data(),
+			slots.size() * sizeof(uint32_t));
+	}
+	std::memcpy(&out[h.strings_offset], strings.data(), strings.size());
+	return out;
+}
+atlas_cache::CachedAtlas atlas_cache::load(const std::string &xml, const std::string &cache_dir){
+	TRACE_SCOPE("atlas_cache::load");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	const std::string cache = cache_path(xml, cache_dir);
+	MappedFile source{xml};
+	const uint64_t hash = source.good() ? util::fnv1a(source.data(), source.size()) : 0;
+	{
+		CachedAtlas cached{cache};
+		if (cached.good() && (!source.good() || cached.info().source_hash == hash)){
+			return cached;
+		}
+	}
+	if (!source.good()){
+		std::cerr << "TextureAtlas error loading " << xml << " - "
+			<< get_xml_error(tinyxml2::XML_ERROR_FILE_NOT_FOUND) << std::endl;
+		return CachedAtlas{std::vector<char>{}};
+	}
+	const std::string dir = xml.substr(0, xml.rfind(util::PATH_SEP) + 1);
+	AtlasDescriptor desc;
+	if (!desc.parse(source.data(), source.size(), dir)){
+		std::cerr << "TextureAtlas error: failed to read " << xml << std::endl;
+		return CachedAtlas{std::vector<char>{}};
+	}
+	size_t width = 0, height = 0;
+	if (!util::image_size(desc.image, width, height)){
+		std::cerr << "Warning: couldn't read the size of atlas image " << desc.image << "\n";
+	}
+	std::vector<char> cooked = cook(desc, desc.image.substr(dir.size()), hash, width, height);
+	//Failing to write the cache isn't fatal, we'll just parse the XML again next time.
+	//It's written to a temporary file first so a reader never maps a partly written one
+	const std::string tmp = cache + ".tmp";
+	std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+	out.write(cooked.data(), cooked.size());
+	out.close();
+	if (!out || !util::replace_file(tmp, cache)){
+		std::remove(tmp.c_str());
+		std::cerr << "Warning: failed to write atlas cache " << cache << "\n";
+	}
+	return CachedAtlas{std::move(cooked)};
+}
+
@@ -0,0 +1,150 @@
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include <tinyxml2.h>
+#include "util.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "atlas_descriptor.h"
+
+std::array<glm::vec2, 4> AtlasSprite::corners() const {
+	const glm::vec2 pos{x, y};
+	if (!rotated){
+		return std::array<glm::vec2, 4>{{pos + glm::vec2{0, h}, pos + glm::vec2{w, h},
+			pos, pos + glm::vec2{w, 0}}};
+	}
+	//Turned clockwise the sprite's top left ends up at the top right of the
+	//h x w rect it takes up in the image and its bottom left at the top left
+	return std::array<glm::vec2, 4>{{pos, pos + glm::vec2{0, w},
+		pos + glm::vec2{h, 0}, pos + glm::vec2{h, w}}};
+}
+std::array<glm::vec2, 4> AtlasSprite::uvs(const glm::vec2 &dim) const {
+	std::array<glm::vec2, 4> arr = corners();
+	for (glm::vec2 &c : arr){
+		c = glm::vec2{c.x, dim.y - c.y} / dim;
+	}
+	return arr;
+}
+bool AtlasDescriptor::load(const std::string &file){
+	TRACE_SCOPE("AtlasDescriptor::load");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	std::ifstream in(file, std::ios::binary);
+	if (!in.is_open()){
+		std::cerr << "TextureAtlas error loading " << file << " - "
+			<< get_xml_error(tinyxml2::XML_ERROR_FILE_NOT_FOUND) << std::endl;
+		return false;
+	}
+	const std::string xml{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	if (!parse(xml.data(), xml.size(), file.substr(0, file.rfind(util::PATH_SEP) + 1))){
+		std::cerr << "TextureAtlas error: failed to read " << file << std::endl;
+		return false;
+	}
+	return true;
+}
+bool AtlasDescriptor::parse(const char *xml, size_t len, const std::string &dir){
+	using namespace tinyxml2;
+	image.clear();
+	sprites.clear();
+	XMLDocument doc;
+	XMLError err = doc.Parse(xml, len);
+	if (err != XML_SUCCESS){
+		std::cerr << "TextureAtlas error parsing document - " << get_xml_error(err) << std::endl;
+		return false;
+	}
+	XMLElement *atlas = doc.FirstChildElement("TextureAtlas");
+	if (atlas == nullptr){
+		std::cerr << "TextureAtlas error: document had no TextureAtlas element\n";
+		return false;
+	}
+	if (!atlas->Attribute("imagePath")){
+		std::cerr << "TextureAtlas error: loading unsupported format" << std::endl;
+		return false;
+	}
+	image = dir + atlas->Attribute("imagePath");
+	//Warn the user if there are any TextureAtlas elements following this one
+	//since they'll be ignored
+	if (atlas->NextSiblingElement("TextureAtlas")){
+		std::cerr << "TextureAtlas warning: Ignoring other TextureAtlas definitions\n";
+	}
+	//Iterate over all the subtextures in the xml document and load their positions
+	for (XMLElement *e = atlas->FirstChildElement(); e != nullptr; e = e->NextSiblingElement()){
+		//Support both the attribute format used by Kenny.NL and TexturePacker's
+		//generic XML output
+		AtlasSprite s;
+		//The texture packer generic XML format
+		if (e->Attribute("n") && e->Attribute("x") && e->Attribute("y")
+			&& e->Attribute("w") && e->Attribute("h"))
+		{
+			s = AtlasSprite{e->Attribute("n"), e->IntAttribute("x"), e->IntAttribute("y"),
+				e->IntAttribute("w"), e->IntAttribute("h"), false};
+		}
+		//The format used by Kenny.NL
+		else if (e->Attribute("name") && e->Attribute("x") && e->Attribute("y")
+			&& e->Attribute("width") && e->Attribute("height"))
+		{
+			s = AtlasSprite{e->Attribute("name"), e->IntAttribute("x"), e->IntAttribute("y"),
+				e->IntAttribute("width"), e->IntAttribute("height"), false};
+		}
+		else {
+			std::cerr << "TextureAtlas error: loading unsupported format" << std::endl;
+			return false;
+		}
+		//TexturePacker marks rotated sprites with r="y"
+		const char *r = e->Attribute("r");
+		s.rotated = r && std::strcmp(r, "y") == 0;
+		sprites.push_back(s);
+	}
+	return true;
+}
+std::string get_xml_error(const tinyxml2::XMLError &error){
+	using namespace tinyxml2;
+	switch (error){
+		case XML_NO_ATTRIBUTE:
+			return "XML_NO_ATTRIBUTE";
+		case XML_WRONG_ATTRIBUTE_TYPE:
+			return "XML_WRONG_ATTRIBUTE_TYPE";
+		case XML_ERROR_FILE_NOT_FOUND:
+			return "XML_ERROR_FILE_NOT_FOUND";
+		case XML_ERROR_FILE_COULD_NOT_BE_OPENED:
+			return "XML_ERROR_FILE_COULD_NOT_BE_OPENED";
+		case XML_ERROR_FILE_READ_ERROR:
+			return "XML_ERROR_FILE_READ_ERROR";
+		case XML_ERROR_ELEMENT_MISMATCH:
+			return "XML_ERROR_ELEMENT_MISMATCH";
+		case XML_ERROR_PARSING_ELEMENT:
+			return "XML_ERROR_PARSING_ELEMENT";
+		case XML_ERROR_PARSING_ATTRIBUTE:
+			return "XML_ERROR_PARSING_ATTRIBUTE";
+		case XML_ERROR_IDENTIFYING_TAG:
+			return "XML_ERROR_IDENTIFYING_TAG";
+		case XML_ERROR_PARSING_TEXT:
+			return "XML_ERROR_PARSING_TEXT";
+		case XML_ERROR_PARSING_CDATA:
+			return "XML_ERROR_PARSING_CDATA";
+		case XML_ERROR_PARSING_COMMENT:
+			return "XML_ERROR_PARSING_COMMENT";
+		case XML_ERROR_PARSING_DECLARATION:
+			return "XML_ERROR_PARSING_DECLARATION";
+		case XML_ERROR_PARSING_UNKNOWN:
+			return "XML_ERROR_PARSING_UNKNOWN";
+		case XML_ERROR_EMPTY_DOCUMENT:
+			return "XML_ERROR_EMPTY_DOCUMENT";
+		case XML_ERROR_MISMATCHED_ELEMENT:
+			return "XML_ERROR_MISMATCHED_ELEMENT";
+		case XML_ERROR_PARSING:
+			return "XML_ERROR_PARSING";
+		case XML_CAN_NOT_CONVERT_TEXT:
+			return "XML_CAN_NOT_CONVERT_TEXT";
+		case XML_NO_TEXT_NODE:
+			return "XML_NO_TEXT_NODE";
+		default:
+			return "XML_SUCCESS";
+	}
+}
+
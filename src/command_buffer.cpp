@@ -0,0 +1,168 @@
+#include <cstdint>
+#include <vector>
+#include "gl_core_3_3.h"
+#include "gl_backend.h"
+#include "command_buffer.h"
+
+gl::CommandBuffer::CommandBuffer(Backend &target) : target(target) {}
+void gl::CommandBuffer::submit(){
+	replay(target);
+	clear();
+}
+void gl::CommandBuffer::replay(Backend &b) const {
+	for (const Command &c : commands){
+		execute(c, b);
+	}
+}
+void gl::CommandBuffer::clear(){
+	commands.clear();
+	payloads.clear();
+}
+size_t gl::CommandBuffer::size() const {
+	return commands.size();
+}
+void gl::CommandBuffer::gen_buffers(GLsizei n, GLuint *buffers){
+	submit();
+	target.gen_buffers(n, buffers);
+}
+void gl::CommandBuffer::delete_buffers(GLsizei n, const GLuint *buffers){
+	for (GLsizei i = 0; i < n; ++i){
+		record(Op::DELETE_BUFFER, 0, 0, buffers[i], 0, 0, 0);
+	}
+}
+void gl::CommandBuffer::bind_buffer(GLenum t, GLuint buffer){
+	record(Op::BIND_BUFFER, t, 0, buffer, 0, 0, 0);
+}
+void gl::CommandBuffer::bind_buffer_base(GLenum t, GLuint index, GLuint buffer){
+	record(Op::BIND_BUFFER_BASE, t, 0, index, buffer, 0, 0);
+}
+void gl::CommandBuffer::buffer_data(GLenum t, GLsizeiptr size, const void *data, GLenum usage){
+	record(Op::BUFFER_DATA, t, usage, size, 0, 0, 0, data, data ? size : 0);
+}
+void gl::CommandBuffer::buffer_sub_data(GLenum t, GLintptr offset, GLsizeiptr size, const void *data){
+	record(Op::BUFFER_SUB_DATA, t, 0, offset, size, 0, 0, data, size);
+}
+void gl::CommandBuffer::copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+	GLintptr write_offset, GLsizeiptr size)
+{
+	record(Op::COPY_BUFFER_SUB_DATA, read_target, write_target, read_offset, write_offset, size, 0);
+}
+void* gl::CommandBuffer::map_buffer(GLenum t, GLenum access){
+	submit();
+	return target.map_buffer(t, access);
+}
+void* gl::CommandBuffer::map_buffer_range(GLenum t, GLintptr offset, GLsizeiptr length, GLbitfield access){
+	submit();
+	return target.map_buffer_range(t, offset, length, access);
+}
+void gl::CommandBuffer::flush_mapped_buffer_range(GLenum t, GLintptr offset, GLsizeiptr length){
+	record(Op::FLUSH_MAPPED_BUFFER_RANGE, t, 0, offset, length, 0, 0);
+}
+GLboolean gl::CommandBuffer::unmap_buffer(GLenum t){
+	submit();
+	return target.unmap_buffer(t);
+}
+void gl::CommandBuffer::gen_vertex_arrays(GLsizei n, GLuint *arrays){
+	submit();
+	target.gen_vertex_arrays(n, arrays);
+}
+void gl::CommandBuffer::delete_vertex_arrays(GLsizei n, const GLuint *arrays){
+	for (GLsizei i = 0; i < n; ++i){
+		record(Op::DELETE_VERTEX_ARRAY, 0, 0, arrays[i], 0, 0, 0);
+	}
+}
+void gl::CommandBuffer::bind_vertex_array(GLuint array){
+	record(Op::BIND_VERTEX_ARRAY, 0, 0, array, 0, 0, 0);
+}
+void gl::CommandBuffer::enable_vertex_attrib_array(GLuint index){
+	record(Op::ENABLE_VERTEX_ATTRIB_ARRAY, 0, 0, index, 0, 0, 0);
+}
+void gl::CommandBuffer::vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+	GLsizei stride, const void *offset)
+{
+	record(Op::VERTEX_ATTRIB_POINTER, type, normalized, index, size, stride,
+		reinterpret_cast<intptr_t>(offset));
+}
+void gl::CommandBuffer::vertex_attrib_ipointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+	const void *offset)
+{
+	record(Op::VERTEX_ATTRIB_IPOINTER, type, 0, index, size, stride,
+		reinterpret_cast<intptr_t>(offset));
+}
+void gl::CommandBuffer::vertex_attrib_divisor(GLuint index, GLuint divisor){
+	record(Op::VERTEX_ATTRIB_DIVISOR, 0, 0, index, divisor, 0, 0);
+}
+void gl::CommandBuffer::draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+	GLsizei instances)
+{
+	record(Op::DRAW_ELEMENTS_INSTANCED, mode, type, count, reinterpret_cast<intptr_t>(indices),
+		instances, 0);
+}
+void gl::CommandBuffer::record(Op op, GLenum e0, GLenum e1, GLint64 a0, GLint64 a1, GLint64 a2, GLint64 a3,
+	const void *data, size_t size)
+{
+	Command c{op, e0, e1, a0, a1, a2, a3, static_cast<size_t>(-1)};
+	if (data){
+		c.payload = payloads.size();
+		const char *d = static_cast<const char*>(data);
+		payloads.insert(payloads.end(), d, d + size);
+	}
+	commands.push_back(c);
+}
+void gl::CommandBuffer::execute(const Command &c, Backend &b) const {
+	const void *data = c.payload == static_cast<size_t>(-1) ? nullptr : payloads.data() + c.payload;
+	switch (c.op){
+		case Op::DELETE_BUFFER:
+		{
+			GLuint buf = c.a0;
+			b.delete_buffers(1, &buf);
+			break;
+		}
+		case Op::BIND_BUFFER:
+			b.bind_buffer(c.e0, c.a0);
+			break;
+		case Op::BIND_BUFFER_BASE:
+			b.bind_buffer_base(c.e0, c.a0, c.a1);
+			break;
+		case Op::BUFFER_DATA:
+			b.buffer_data(c.e0, c.a0, data, c.e1);
+			break;
+		case Op::BUFFER_SUB_DATA:
+			b.buffer_sub_data(c.e0, c.a0, c.a1, data);
+			break;
+		case Op::COPY_BUFFER_SUB_DATA:
+			b.copy_buffer_sub_data(c.e0, c.e1, c.a0, c.a1, c.a2);
+			break;
+		case Op::FLUSH_MAPPED_BUFFER_RANGE:
+			b.flush_mapped_buffer_range(c.e0, c.a0, c.a1);
+			break;
+		case Op::DELETE_VERTEX_ARRAY:
+		{
+			GLuint vao = c.a0;
+			b.delete_vertex_arrays(1, &vao);
+			break;
+		}
+		case Op::BIND_VERTEX_ARRAY:
+			b.bind_vertex_array(c.a0);
+			break;
+		case Op::ENABLE_VERTEX_ATTRIB_ARRAY:
+			b.enable_vertex_attrib_array(c.a0);
+			break;
+		case Op::VERTEX_ATTRIB_POINTER:
+			b.vertex_attrib_pointer(c.a0, c.a1, c.e0, c.e1, c.a2,
+				reinterpret_cast<const void*>(static_cast<intptr_t>(c.a3)));
+			break;
+		case Op::VERTEX_ATTRIB_IPOINTER:
+			b.vertex_attrib_ipointer(c.a0, c.a1, c.e0, c.a2,
+				reinterpret_cast<const void*>(static_cast<intptr_t>(c.a3)));
+			break;
+		case Op::VERTEX_ATTRIB_DIVISOR:
+			b.vertex_attrib_divisor(c.a0, c.a1);
+			break;
+		case Op::DRAW_ELEMENTS_INSTANCED:
+			b.draw_elements_instanced(c.e0, c.a0, c.e1,
+				reinterpret_cast<const void*>(static_cast<intptr_t>(c.a1)), c.a2);
+			break;
+	}
+}
+
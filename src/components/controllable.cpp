@@ -3,23 +3,25 @@
 #include "components/velocity.h"
 #include "components/controllable.h"
 
-Controllable::Controllable(bool enabled) : enabled(enabled) {}
-void Controllable::control(entityx::Entity &entity, const SDL_Event &event){
+Controllable::Controllable(bool enabled) : enabled(enabled), firing(false) {}
+void Controllable::control(Velocity &vel, const SDL_Event &event){
 	//Just some basic keyboard control for now
-	entityx::ptr<Velocity> vel = entity.component<Velocity>();
 	if (event.type == SDL_KEYDOWN){
 		switch (event.key.keysym.sym){
 			case SDLK_w:
-				vel->vel.y = 0.5f;
+				vel.vel.y = 0.5f;
 				break;
 			case SDLK_s:
-				vel->vel.y = -0.5f;
+				vel.vel.y = -0.5f;
 				break;
 			case SDLK_d:
-				vel->vel.x = 0.5f;
+				vel.vel.x = 0.5f;
 				break;
 			case SDLK_a:
-				vel->vel.x = -0.5f;
+				vel.vel.x = -0.5f;
+				break;
+			case SDLK_SPACE:
+				firing = true;
 				break;
 		}
 	}
@@ -27,11 +29,14 @@ void Controllable::control(entityx::Entity &entity, const SDL_Event &event){
 		switch (event.key.keysym.sym){
 			case SDLK_w:
 			case SDLK_s:
-				vel->vel.y = 0;
+				vel.vel.y = 0;
 				break;
 			case SDLK_d:
 			case SDLK_a:
-				vel->vel.x = 0;
+				vel.vel.x = 0;
+				break;
+			case SDLK_SPACE:
+				firing = false;
 				break;
 		}
 	}
@@ -0,0 +1,56 @@
+#include <cstdint>
+#include "cpu_features.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPU_FEATURES_X86
+static void cpuid(int leaf, int subleaf, uint32_t regs[4]){
+	int r[4];
+	__cpuidex(r, leaf, subleaf);
+	for (int i = 0; i < 4; ++i){
+		regs[i] = r[i];
+	}
+}
+static uint64_t xgetbv(){
+	return _xgetbv(0);
+}
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define CPU_FEATURES_X86
+static void cpuid(int leaf, int subleaf, uint32_t regs[4]){
+	__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+}
+static uint64_t xgetbv(){
+	uint32_t lo, hi;
+	__asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return static_cast<uint64_t>(hi) << 32 | lo;
+}
+#endif
+
+static CpuFeatures detect(){
+	CpuFeatures f{false, false, false};
+#ifdef CPU_FEATURES_X86
+	uint32_t regs[4];
+	cpuid(0, 0, regs);
+	const uint32_t max_leaf = regs[0];
+	cpuid(1, 0, regs);
+	f.sse2 = (regs[3] & (1 << 26)) != 0;
+	//AVX state can only be used if the OS has enabled saving it through XSAVE
+	const bool osxsave = (regs[2] & (1 << 27)) != 0;
+	const uint64_t xcr0 = osxsave ? xgetbv() : 0;
+	//xmm and ymm state for AVX, plus opmask and zmm state for AVX-512
+	const bool os_avx = (xcr0 & 0x6) == 0x6;
+	const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+	if (max_leaf >= 7){
+		cpuid(7, 0, regs);
+		f.avx2 = os_avx && (regs[1] & (1 << 5)) != 0;
+		f.avx512f = os_avx512 && (regs[1] & (1 << 16)) != 0;
+	}
+#endif
+	return f;
+}
+const CpuFeatures& cpu_features(){
+	static const CpuFeatures features = detect();
+	return features;
+}
+
@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <mutex>
+#include <vector>
+#include <entityx/entityx.h>
+#include "entity_pool.h"
+
+EntityPool::EntityPool(entityx::ptr<entityx::EntityManager> entities) : entities(entities) {}
+void EntityPool::reserve(size_t n){
+	//entityx has no way to reserve directly, but creating entities grows its storage
+	//and destroying them puts their indices on the free list for reuse
+	size_t live = entities->size();
+	if (n <= live){
+		return;
+	}
+	std::vector<entityx::Entity::Id> warm;
+	warm.reserve(n - live);
+	for (size_t i = live; i < n; ++i){
+		warm.push_back(entities->create().id());
+	}
+	for (auto id : warm){
+		entities->destroy(id);
+	}
+	std::lock_guard<std::mutex> lock(despawn_mutex);
+	despawns.reserve(n);
+}
+void EntityPool::create(size_t n, std::vector<entityx::Entity> &out){
+	out.reserve(out.size() + n);
+	for (size_t i = 0; i < n; ++i){
+		out.push_back(entities->create());
+	}
+}
+void EntityPool::despawn(entityx::Entity::Id id){
+	std::lock_guard<std::mutex> lock(despawn_mutex);
+	despawns.push_back(id);
+}
+void EntityPool::despawn(const std::vector<entityx::Entity::Id> &ids){
+	std::lock_guard<std::mutex> lock(despawn_mutex);
+	despawns.insert(despawns.end(), ids.begin(), ids.end());
+}
+size_t EntityPool::flush(){
+	std::lock_guard<std::mutex> lock(despawn_mutex);
+	//Drop duplicates and destroy in index order, which also keeps the order the
+	//pooled components are swapped around in the same from run to run
+	std::sort(despawns.begin(), despawns.end(),
+		[](const entityx::Entity::Id &a, const entityx::Entity::Id &b){
+			return a.index() < b.index() || (a.index() == b.index() && a.version() < b.version());
+		});
+	despawns.erase(std::unique(despawns.begin(), despawns.end()), despawns.end());
+	size_t destroyed = 0;
+	for (auto id : despawns){
+		if (entities->valid(id)){
+			entities->destroy(id);
+			++destroyed;
+		}
+	}
+	despawns.clear();
+	return destroyed;
+}
+size_t EntityPool::pending(){
+	std::lock_guard<std::mutex> lock(despawn_mutex);
+	return despawns.size();
+}
+
@@ -0,0 +1,277 @@
+#include <cassert>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include "gl_core_3_3.h"
+#include "gl_backend.h"
+
+gl::Stats::Stats(){
+	reset();
+}
+void gl::Stats::reset(){
+	calls = 0;
+	bytes_uploaded = 0;
+	bytes_copied = 0;
+	state_changes = 0;
+	draw_calls = 0;
+	instances = 0;
+}
+
+void gl::GLBackend::gen_buffers(GLsizei n, GLuint *buffers){
+	glGenBuffers(n, buffers);
+}
+void gl::GLBackend::delete_buffers(GLsizei n, const GLuint *buffers){
+	glDeleteBuffers(n, buffers);
+}
+void gl::GLBackend::bind_buffer(GLenum target, GLuint buffer){
+	glBindBuffer(target, buffer);
+}
+void gl::GLBackend::bind_buffer_base(GLenum target, GLuint index, GLuint buffer){
+	glBindBufferBase(target, index, buffer);
+}
+void gl::GLBackend::buffer_data(GLenum target, GLsizeiptr size, const void *data, GLenum usage){
+	glBufferData(target, size, data, usage);
+}
+void gl::GLBackend::buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void *data){
+	glBufferSubData(target, offset, size, data);
+}
+void gl::GLBackend::copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+	GLintptr write_offset, GLsizeiptr size)
+{
+	glCopyBufferSubData(read_target, write_target, read_offset, write_offset, size);
+}
+void* gl::GLBackend::map_buffer(GLenum target, GLenum access){
+	return glMapBuffer(target, access);
+}
+void* gl::GLBackend::map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+	return glMapBufferRange(target, offset, length, access);
+}
+void gl::GLBackend::flush_mapped_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length){
+	glFlushMappedBufferRange(target, offset, length);
+}
+GLboolean gl::GLBackend::unmap_buffer(GLenum target){
+	return glUnmapBuffer(target);
+}
+void gl::GLBackend::gen_vertex_arrays(GLsizei n, GLuint *arrays){
+	glGenVertexArrays(n, arrays);
+}
+void gl::GLBackend::delete_vertex_arrays(GLsizei n, const GLuint *arrays){
+	glDeleteVertexArrays(n, arrays);
+}
+void gl::GLBackend::bind_vertex_array(GLuint array){
+	glBindVertexArray(array);
+}
+void gl::GLBackend::enable_vertex_attrib_array(GLuint index){
+	glEnableVertexAttribArray(index);
+}
+void gl::GLBackend::vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+	GLsizei stride, const void *offset)
+{
+	glVertexAttribPointer(index, size, type, normalized, stride, offset);
+}
+void gl::GLBackend::vertex_attrib_ipointer(GLuint index, GLint size, GLenum type, GLsizei stride,
+	const void *offset)
+{
+	glVertexAttribIPointer(index, size, type, stride, offset);
+}
+void gl::GLBackend::vertex_attrib_divisor(GLuint index, GLuint divisor){
+	glVertexAttribDivisor(index, divisor);
+}
+void gl::GLBackend::draw_elements_instanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+	GLsizei instances)
+{
+	glDrawElementsInstanced(mode, count, type, indices, instances);
+}
+
+gl::MockBackend::Buffer::Buffer() : map_offset(0), map_length(0), map_access(0) {}
+gl::MockBackend::MockBackend() : next_name(1), bound_vao(0) {}
+void gl::MockBackend::gen_buffers(GLsizei n, GLuint *names){
+	++stats_.calls;
+	for (GLsizei i = 0; i < n; ++i){
+		names[i] = next_name++;
+		buffers[names[i]] = Buffer{};
+	}
+}
+void gl::MockBackend::delete_buffers(GLsizei n, const GLuint *names){
+	++stats_.calls;
+	for (GLsizei i = 0; i < n; ++i){
+		buffers.erase(names[i]);
+		//Deleting a bound buffer unbinds it
+		for (auto &b : bound){
+			if (b.second == names[i]){
+				b.second = 0;
+			}
+		}
+		for (auto &b : bound_indexed){
+			if (b.second == names[i]){
+				b.second = 0;
+			}
+		}
+	}
+}
+void gl::MockBackend::bind_buffer(GLenum target, GLuint buffer){
+	++stats_.calls;
+	GLuint &b = bound[target];
+	if (b != buffer){
+		++stats_.state_changes;
+		b = buffer;
+	}
+}
+void gl::MockBackend::bind_buffer_base(GLenum target, GLuint index, GLuint buffer){
+	++stats_.calls;
+	//The indexed binding also changes the generic binding point
+	GLuint &b = bound[target];
+	GLuint &indexed = bound_indexed[static_cast<uint64_t>(target) << 32 | index];
+	if (b != buffer || indexed != buffer){
+		++stats_.state_changes;
+		b = buffer;
+		indexed = buffer;
+	}
+}
+void gl::MockBackend::buffer_data(GLenum target, GLsizeiptr size, const void *data, GLenum){
+	++stats_.calls;
+	Buffer &b = bound_buffer(target);
+	b.data.resize(size);
+	if (data){
+		std::memcpy(b.data.data(), data, size);
+		stats_.bytes_uploaded += size;
+	}
+}
+void gl::MockBackend::buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void *data){
+	++stats_.calls;
+	Buffer &b = bound_buffer(target);
+	assert(offset + size <= static_cast<GLintptr>(b.data.size()));
+	std::memcpy(b.data.data() + offset, data, size);
+	stats_.bytes_uploaded += size;
+}
+void gl::MockBackend::copy_buffer_sub_data(GLenum read_target, GLenum write_target, GLintptr read_offset,
+	GLintptr write_offset, GLsizeiptr size)
+{
+	++stats_.calls;
+	Buffer &r = bound_buffer(read_target);
+	Buffer &w = bound_buffer(write_target);
+	assert(read_offset + size <= static_cast<GLintptr>(r.data.size())
+		&& write_offset + size <= static_cast<GLintptr>(w.data.size()));
+	std::memmove(w.data.data() + write_offset, r.data.data() + read_offset, size);
+	stats_.bytes_copied += size;
+}
+void* gl::MockBackend::map_buffer(GLenum target, GLenum access){
+	++stats_.calls;
+	Buffer &b = bound_buffer(target);
+	assert(b.map_length == 0);
+	b.map_offset = 0;
+	b.map_length = b.data.size();
+	switch (access){
+		case GL_READ_ONLY:
+			b.map_access = GL_MAP_READ_BIT;
+			break;
+		case GL_WRITE_ONLY:
+			b.map_access = GL_MAP_WRITE_BIT;
+			break;
+		default:
+			b.map_access = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT;
+	}
+	return b.data.data();
+}
+void* gl::MockBackend::map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access){
+	++stats_.calls;
+	Buffer &b = bound_buffer(target);
+	assert(b.map_length == 0 && offset + length <= static_cast<GLintptr>(b.data.size()));
+	b.map_offset = offset;
+	b.map_length = length;
+	b.map_access = access;
+	return b.data.data() + offset;
+}
+void gl::MockBackend::flush_mapped_buffer_range(GLenum target, GLintptr, GLsizeiptr length){
+	++stats_.calls;
+	Buffer &b = bound_buffer(target);
+	assert(b.map_length > 0);
+	stats_.bytes_uploaded += length;
+}
+GLboolean gl::MockBackend::unmap_buffer(GLenum target){
+	++stats_.calls;
+	Buffer &b = bound_buffer(target);
+	assert(b.map_length > 0);
+	//With explicit flushing only the flushed ranges are sent, which we've already counted
+	if ((b.map_access & GL_MAP_WRITE_BIT) && !(b.map_access & GL_MAP_FLUSH_EXPLICIT_BIT)){
+		stats_.bytes_uploaded += b.map_length;
+	}
+	b.map_offset = 0;
+	b.map_length = 0;
+	b.map_access = 0;
+	return GL_TRUE;
+}
+void gl::MockBackend::gen_vertex_arrays(GLsizei n, GLuint *arrays){
+	++stats_.calls;
+	for (GLsizei i = 0; i < n; ++i){
+		arrays[i] = next_name++;
+	}
+}
+void gl::MockBackend::delete_vertex_arrays(GLsizei n, const GLuint *arrays){
+	++stats_.calls;
+	for (GLsizei i = 0; i < n; ++i){
+		if (arrays[i] == bound_vao){
+			bound_vao = 0;
+		}
+	}
+}
+void gl::MockBackend::bind_vertex_array(GLuint array){
+	++stats_.calls;
+	if (bound_vao != array){
+		++stats_.state_changes;
+		bound_vao = array;
+	}
+}
+void gl::MockBackend::enable_vertex_attrib_array(GLuint){
+	++stats_.calls;
+	++stats_.state_changes;
+}
+void gl::MockBackend::vertex_attrib_pointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*){
+	++stats_.calls;
+	++stats_.state_changes;
+}
+void gl::MockBackend::vertex_attrib_ipointer(GLuint, GLint, GLenum, GLsizei, const void*){
+	++stats_.calls;
+	++stats_.state_changes;
+}
+void gl::MockBackend::vertex_attrib_divisor(GLuint, GLuint){
+	++stats_.calls;
+	++stats_.state_changes;
+}
+void gl::MockBackend::draw_elements_instanced(GLenum, GLsizei, GLenum, const void*, GLsizei instances){
+	++stats_.calls;
+	++stats_.draw_calls;
+	stats_.instances += instances;
+}
+const gl::Stats& gl::MockBackend::stats() const {
+	return stats_;
+}
+void gl::MockBackend::reset_stats(){
+	stats_.reset();
+}
+const std::vector<char>* gl::MockBackend::contents(GLuint buffer) const {
+	auto fnd = buffers.find(buffer);
+	if (fnd == buffers.end()){
+		return nullptr;
+	}
+	return &fnd->second.data;
+}
+gl::MockBackend::Buffer& gl::MockBackend::bound_buffer(GLenum target){
+	auto b = bound.find(target);
+	assert(b != bound.end() && b->second != 0);
+	auto fnd = buffers.find(b->second);
+	assert(fnd != buffers.end());
+	return fnd->second;
+}
+
+namespace {
+gl::GLBackend gl_backend;
+gl::Backend *current = &gl_backend;
+}
+gl::Backend& gl::backend(){
+	return *current;
+}
+void gl::set_backend(Backend *b){
+	current = b ? b : &gl_backend;
+}
+
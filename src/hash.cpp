@@ -0,0 +1,13 @@
+#include <cstddef>
+#include <cstdint>
+#include "hash.h"
+
+uint64_t util::fnv1a(const void *data, size_t n, uint64_t hash){
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+	for (size_t i = 0; i < n; ++i){
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
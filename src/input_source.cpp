@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <SDL.h>
+#include "input_source.h"
+
+bool InputSource::finished(uint64_t) const {
+	return false;
+}
+
+bool SDLInputSource::poll(uint64_t, SDL_Event &e){
+	return SDL_PollEvent(&e) != 0;
+}
+
+InputRecorder::InputRecorder(const std::shared_ptr<InputSource> &source, const std::string &file,
+	uint64_t seed, double tick)
+	: source(source), log(file, std::ios::binary), last_tick(0)
+{
+	input_log::Header header{input_log::MAGIC, input_log::VERSION, seed, tick};
+	log.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!log){
+		std::cerr << "InputRecorder: failed to open " << file << " for writing\n";
+	}
+}
+InputRecorder::~InputRecorder(){
+	input_log::Record end{last_tick, 0, input_log::END, 0, 0};
+	log.write(reinterpret_cast<const char*>(&end), sizeof(end));
+}
+bool InputRecorder::poll(uint64_t tick, SDL_Event &e){
+	last_tick = tick;
+	if (!source->poll(tick, e)){
+		return false;
+	}
+	input_log::Record r{tick, e.common.timestamp, e.type, 0, 0};
+	if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP){
+		r.key = e.key.keysym.sym;
+		r.repeat = e.key.repeat;
+	}
+	log.write(reinterpret_cast<const char*>(&r), sizeof(r));
+	return true;
+}
+bool InputRecorder::finished(uint64_t tick) const {
+	return source->finished(tick);
+}
+bool InputRecorder::good() const {
+	return log.good();
+}
+
+InputReplay::InputReplay(const std::string &file) : log(file, std::ios::binary),
+	next{0, 0, input_log::END, 0, 0}, loaded(false)
+{
+	std::memset(&header, 0, sizeof(header));
+	log.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!log || header.magic != input_log::MAGIC || header.version != input_log::VERSION){
+		std::cerr << "InputReplay: " << file << " is not a valid input log\n";
+		return;
+	}
+	loaded = true;
+	read_next();
+}
+bool InputReplay::poll(uint64_t tick, SDL_Event &e){
+	if (next.type == input_log::END || next.tick > tick){
+		return false;
+	}
+	std::memset(&e, 0, sizeof(e));
+	e.type = next.type;
+	e.common.timestamp = next.timestamp;
+	if (e.type == SDL_KEYDOWN || e.type == SDL_KEYUP){
+		e.key.state = e.type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+		e.key.repeat = next.repeat;
+		e.key.keysym.sym = next.key;
+	}
+	read_next();
+	return true;
+}
+bool InputReplay::finished(uint64_t tick) const {
+	return next.type == input_log::END && tick > next.tick;
+}
+bool InputReplay::good() const {
+	return loaded;
+}
+uint64_t InputReplay::seed() const {
+	return header.seed;
+}
+double InputReplay::tick_length() const {
+	return header.tick;
+}
+void InputReplay::read_next(){
+	const uint64_t last = next.tick;
+	if (!log.read(reinterpret_cast<char*>(&next), sizeof(next))){
+		next = input_log::Record{last, 0, input_log::END, 0, 0};
+	}
+}
+
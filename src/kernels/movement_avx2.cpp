@@ -0,0 +1,53 @@
+#include <cstddef>
+#include "movement_kernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+void kernel::detail::integrate_avx2(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	const __m256 vdt = _mm256_set1_ps(dt);
+	size_t i = 0;
+	//Note that we don't use FMA here so the results match the other variants exactly
+	if (!wrap){
+		for (; i + 16 <= count; i += 16){
+			__m256 p0 = _mm256_loadu_ps(pos + i);
+			__m256 p1 = _mm256_loadu_ps(pos + i + 8);
+			__m256 v0 = _mm256_loadu_ps(vel + i);
+			__m256 v1 = _mm256_loadu_ps(vel + i + 8);
+			_mm256_storeu_ps(pos + i, _mm256_add_ps(p0, _mm256_mul_ps(v0, vdt)));
+			_mm256_storeu_ps(pos + i + 8, _mm256_add_ps(p1, _mm256_mul_ps(v1, vdt)));
+		}
+		for (; i + 8 <= count; i += 8){
+			__m256 p = _mm256_loadu_ps(pos + i);
+			__m256 v = _mm256_loadu_ps(vel + i);
+			_mm256_storeu_ps(pos + i, _mm256_add_ps(p, _mm256_mul_ps(v, vdt)));
+		}
+	}
+	else {
+		const __m256 lo = _mm256_setr_ps(wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y,
+			wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y);
+		const __m256 hi = _mm256_setr_ps(wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y,
+			wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y);
+		const __m256 size = _mm256_sub_ps(hi, lo);
+		for (; i + 8 <= count; i += 8){
+			__m256 p = _mm256_loadu_ps(pos + i);
+			__m256 v = _mm256_loadu_ps(vel + i);
+			p = _mm256_add_ps(p, _mm256_mul_ps(v, vdt));
+			__m256 over = _mm256_and_ps(_mm256_cmp_ps(p, hi, _CMP_GE_OQ), size);
+			__m256 under = _mm256_and_ps(_mm256_cmp_ps(p, lo, _CMP_LT_OQ), size);
+			p = _mm256_add_ps(_mm256_sub_ps(p, over), under);
+			_mm256_storeu_ps(pos + i, p);
+		}
+	}
+	integrate_scalar(pos + i, vel + i, count - i, dt, wrap);
+}
+#else
+void kernel::detail::integrate_avx2(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	integrate_scalar(pos, vel, count, dt, wrap);
+}
+#endif
+
@@ -0,0 +1,43 @@
+#include <cstddef>
+#include "movement_kernel.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+void kernel::detail::integrate_avx512(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	const __m512 vdt = _mm512_set1_ps(dt);
+	const __m512 lo = wrap ? _mm512_setr_ps(wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y,
+		wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y,
+		wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y)
+		: _mm512_setzero_ps();
+	const __m512 hi = wrap ? _mm512_setr_ps(wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y,
+		wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y,
+		wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y)
+		: _mm512_setzero_ps();
+	const __m512 size = _mm512_sub_ps(hi, lo);
+	//The tail is handled with a masked load/store instead of falling back to scalar code
+	for (size_t i = 0; i < count; i += 16){
+		const __mmask16 mask = count - i >= 16 ? 0xffff
+			: static_cast<__mmask16>((1u << (count - i)) - 1);
+		__m512 p = _mm512_maskz_loadu_ps(mask, pos + i);
+		__m512 v = _mm512_maskz_loadu_ps(mask, vel + i);
+		p = _mm512_add_ps(p, _mm512_mul_ps(v, vdt));
+		if (wrap){
+			__mmask16 over = _mm512_cmp_ps_mask(p, hi, _CMP_GE_OQ);
+			__mmask16 under = _mm512_cmp_ps_mask(p, lo, _CMP_LT_OQ);
+			p = _mm512_mask_sub_ps(p, over, p, size);
+			p = _mm512_mask_add_ps(p, under, p, size);
+		}
+		_mm512_mask_storeu_ps(pos + i, mask, p);
+	}
+}
+#else
+void kernel::detail::integrate_avx512(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	integrate_scalar(pos, vel, count, dt, wrap);
+}
+#endif
+
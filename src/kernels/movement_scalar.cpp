@@ -0,0 +1,29 @@
+#include <cstddef>
+#include "movement_kernel.h"
+
+void kernel::detail::integrate_scalar(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	if (!wrap){
+		for (size_t i = 0; i < count; ++i){
+			pos[i] += vel[i] * dt;
+		}
+		return;
+	}
+	const float lo[2] = { wrap->min.x, wrap->min.y };
+	const float hi[2] = { wrap->max.x, wrap->max.y };
+	const float size[2] = { hi[0] - lo[0], hi[1] - lo[1] };
+	for (size_t i = 0; i < count; ++i){
+		//Even floats are x and odd ones are y
+		const size_t c = i & 1;
+		float p = pos[i] + vel[i] * dt;
+		if (p >= hi[c]){
+			p -= size[c];
+		}
+		else if (p < lo[c]){
+			p += size[c];
+		}
+		pos[i] = p;
+	}
+}
+
@@ -0,0 +1,45 @@
+#include <cstddef>
+#include "movement_kernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+void kernel::detail::integrate_sse2(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	const __m128 vdt = _mm_set1_ps(dt);
+	size_t i = 0;
+	if (!wrap){
+		for (; i + 4 <= count; i += 4){
+			__m128 p = _mm_loadu_ps(pos + i);
+			__m128 v = _mm_loadu_ps(vel + i);
+			_mm_storeu_ps(pos + i, _mm_add_ps(p, _mm_mul_ps(v, vdt)));
+		}
+	}
+	else {
+		//Registers hold two xy pairs so the bounds are repeated in the same pattern
+		const __m128 lo = _mm_setr_ps(wrap->min.x, wrap->min.y, wrap->min.x, wrap->min.y);
+		const __m128 hi = _mm_setr_ps(wrap->max.x, wrap->max.y, wrap->max.x, wrap->max.y);
+		const __m128 size = _mm_sub_ps(hi, lo);
+		for (; i + 4 <= count; i += 4){
+			__m128 p = _mm_loadu_ps(pos + i);
+			__m128 v = _mm_loadu_ps(vel + i);
+			p = _mm_add_ps(p, _mm_mul_ps(v, vdt));
+			//Subtract size where p >= hi and add it where p < lo
+			__m128 over = _mm_and_ps(_mm_cmpge_ps(p, hi), size);
+			__m128 under = _mm_and_ps(_mm_cmplt_ps(p, lo), size);
+			p = _mm_add_ps(_mm_sub_ps(p, over), under);
+			_mm_storeu_ps(pos + i, p);
+		}
+	}
+	//i is always even here so the remainder still starts on an x component
+	integrate_scalar(pos + i, vel + i, count - i, dt, wrap);
+}
+#else
+void kernel::detail::integrate_sse2(float *pos, const float *vel, size_t count, float dt,
+	const Bounds *wrap)
+{
+	integrate_scalar(pos, vel, count, dt, wrap);
+}
+#endif
+
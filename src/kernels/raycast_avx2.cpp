@@ -0,0 +1,64 @@
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "raycast_kernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+int32_t kernel::detail::ray_circles_avx2(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	const __m256 ox = _mm256_set1_ps(o.x), oy = _mm256_set1_ps(o.y);
+	const __m256 dx = _mm256_set1_ps(d.x), dy = _mm256_set1_ps(d.y);
+	const __m256 a = _mm256_set1_ps(d.x * d.x + d.y * d.y);
+	const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.f);
+	const __m256 sign = _mm256_set1_ps(-0.f);
+	__m256 best_t = _mm256_set1_ps(2.f);
+	__m256i best_i = _mm256_set1_epi32(-1);
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256i step = _mm256_set1_epi32(8);
+	size_t i = 0;
+	//Note that we don't use FMA here so the results match the other variants exactly
+	for (; i + 8 <= n; i += 8, index = _mm256_add_epi32(index, step)){
+		const __m256 mx = _mm256_sub_ps(ox, _mm256_loadu_ps(cx + i));
+		const __m256 my = _mm256_sub_ps(oy, _mm256_loadu_ps(cy + i));
+		const __m256 rr = _mm256_loadu_ps(r + i);
+		const __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(mx, mx), _mm256_mul_ps(my, my)),
+			_mm256_mul_ps(rr, rr));
+		const __m256 b = _mm256_add_ps(_mm256_mul_ps(mx, dx), _mm256_mul_ps(my, dy));
+		const __m256 disc = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+		__m256 ti = _mm256_sub_ps(_mm256_xor_ps(b, sign), _mm256_sqrt_ps(_mm256_max_ps(disc, zero)));
+		ti = _mm256_div_ps(ti, a);
+		const __m256 inside = _mm256_cmp_ps(c, zero, _CMP_LE_OQ);
+		const __m256 reach = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(b, zero, _CMP_LT_OQ),
+			_mm256_cmp_ps(disc, zero, _CMP_GE_OQ)), _mm256_cmp_ps(ti, one, _CMP_LE_OQ));
+		ti = _mm256_andnot_ps(inside, ti);
+		const __m256 better = _mm256_and_ps(_mm256_or_ps(inside, reach),
+			_mm256_cmp_ps(ti, best_t, _CMP_LT_OQ));
+		best_t = _mm256_blendv_ps(best_t, ti, better);
+		best_i = _mm256_blendv_epi8(best_i, index, _mm256_castps_si256(better));
+	}
+	float lane_t[8];
+	int32_t lane_i[8];
+	_mm256_storeu_ps(lane_t, best_t);
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(lane_i), best_i);
+	int32_t best = -1;
+	for (int l = 0; l < 8; ++l){
+		if (lane_i[l] >= 0 && (best < 0 || lane_t[l] < t || (lane_t[l] == t && lane_i[l] < best))){
+			best = lane_i[l];
+			t = lane_t[l];
+		}
+	}
+	float tail_t = 0;
+	const int32_t tail = ray_circles_scalar(o, d, cx + i, cy + i, r + i, n - i, tail_t);
+	return merge_hit(best, t, tail, tail_t, i);
+}
+#else
+int32_t kernel::detail::ray_circles_avx2(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	return ray_circles_scalar(o, d, cx, cy, r, n, t);
+}
+#endif
+
@@ -0,0 +1,62 @@
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "raycast_kernel.h"
+
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+int32_t kernel::detail::ray_circles_avx512(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	const __m512 ox = _mm512_set1_ps(o.x), oy = _mm512_set1_ps(o.y);
+	const __m512 dx = _mm512_set1_ps(d.x), dy = _mm512_set1_ps(d.y);
+	const __m512 a = _mm512_set1_ps(d.x * d.x + d.y * d.y);
+	const __m512 zero = _mm512_setzero_ps(), one = _mm512_set1_ps(1.f);
+	__m512 best_t = _mm512_set1_ps(2.f);
+	__m512i best_i = _mm512_set1_epi32(-1);
+	__m512i index = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+	const __m512i step = _mm512_set1_epi32(16);
+	//The tail is handled with masked loads, masked off lanes never count as hits
+	for (size_t i = 0; i < n; i += 16, index = _mm512_add_epi32(index, step)){
+		const __mmask16 mask = n - i >= 16 ? 0xffff
+			: static_cast<__mmask16>((1u << (n - i)) - 1);
+		const __m512 mx = _mm512_sub_ps(ox, _mm512_maskz_loadu_ps(mask, cx + i));
+		const __m512 my = _mm512_sub_ps(oy, _mm512_maskz_loadu_ps(mask, cy + i));
+		const __m512 rr = _mm512_maskz_loadu_ps(mask, r + i);
+		const __m512 c = _mm512_sub_ps(_mm512_add_ps(_mm512_mul_ps(mx, mx), _mm512_mul_ps(my, my)),
+			_mm512_mul_ps(rr, rr));
+		const __m512 b = _mm512_add_ps(_mm512_mul_ps(mx, dx), _mm512_mul_ps(my, dy));
+		const __m512 disc = _mm512_sub_ps(_mm512_mul_ps(b, b), _mm512_mul_ps(a, c));
+		__m512 ti = _mm512_sub_ps(_mm512_sub_ps(zero, b), _mm512_sqrt_ps(_mm512_max_ps(disc, zero)));
+		ti = _mm512_div_ps(ti, a);
+		const __mmask16 inside = _mm512_mask_cmp_ps_mask(mask, c, zero, _CMP_LE_OQ);
+		__mmask16 reach = _mm512_mask_cmp_ps_mask(mask, b, zero, _CMP_LT_OQ);
+		reach = _mm512_mask_cmp_ps_mask(reach, disc, zero, _CMP_GE_OQ);
+		reach = _mm512_mask_cmp_ps_mask(reach, ti, one, _CMP_LE_OQ);
+		ti = _mm512_mask_mov_ps(ti, inside, zero);
+		const __mmask16 better = _mm512_mask_cmp_ps_mask(inside | reach, ti, best_t, _CMP_LT_OQ);
+		best_t = _mm512_mask_mov_ps(best_t, better, ti);
+		best_i = _mm512_mask_mov_epi32(best_i, better, index);
+	}
+	float lane_t[16];
+	int32_t lane_i[16];
+	_mm512_storeu_ps(lane_t, best_t);
+	_mm512_storeu_si512(lane_i, best_i);
+	int32_t best = -1;
+	for (int l = 0; l < 16; ++l){
+		if (lane_i[l] >= 0 && (best < 0 || lane_t[l] < t || (lane_t[l] == t && lane_i[l] < best))){
+			best = lane_i[l];
+			t = lane_t[l];
+		}
+	}
+	return best;
+}
+#else
+int32_t kernel::detail::ray_circles_avx512(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	return ray_circles_scalar(o, d, cx, cy, r, n, t);
+}
+#endif
+
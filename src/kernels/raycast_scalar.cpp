@@ -0,0 +1,37 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "raycast_kernel.h"
+
+int32_t kernel::detail::ray_circles_scalar(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	const float a = d.x * d.x + d.y * d.y;
+	int32_t best = -1;
+	for (size_t i = 0; i < n; ++i){
+		//Solve |m + d t| = r where m is the segment start relative to the circle
+		const float mx = o.x - cx[i];
+		const float my = o.y - cy[i];
+		const float c = (mx * mx + my * my) - r[i] * r[i];
+		const float b = mx * d.x + my * d.y;
+		float ti = 0;
+		if (c > 0){
+			const float disc = b * b - a * c;
+			//Moving away from the circle or missing it entirely
+			if (b >= 0 || disc < 0){
+				continue;
+			}
+			ti = (-b - std::sqrt(disc)) / a;
+			if (ti > 1){
+				continue;
+			}
+		}
+		if (best < 0 || ti < t){
+			best = static_cast<int32_t>(i);
+			t = ti;
+		}
+	}
+	return best;
+}
+
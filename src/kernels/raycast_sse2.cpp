@@ -0,0 +1,66 @@
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "raycast_kernel.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+
+int32_t kernel::detail::ray_circles_sse2(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	const __m128 ox = _mm_set1_ps(o.x), oy = _mm_set1_ps(o.y);
+	const __m128 dx = _mm_set1_ps(d.x), dy = _mm_set1_ps(d.y);
+	const __m128 a = _mm_set1_ps(d.x * d.x + d.y * d.y);
+	const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.f);
+	const __m128 sign = _mm_set1_ps(-0.f);
+	//Each lane tracks the first hit among the circles it's seen
+	__m128 best_t = _mm_set1_ps(2.f);
+	__m128i best_i = _mm_set1_epi32(-1);
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+	const __m128i step = _mm_set1_epi32(4);
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4, index = _mm_add_epi32(index, step)){
+		const __m128 mx = _mm_sub_ps(ox, _mm_loadu_ps(cx + i));
+		const __m128 my = _mm_sub_ps(oy, _mm_loadu_ps(cy + i));
+		const __m128 rr = _mm_loadu_ps(r + i);
+		const __m128 c = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my)),
+			_mm_mul_ps(rr, rr));
+		const __m128 b = _mm_add_ps(_mm_mul_ps(mx, dx), _mm_mul_ps(my, dy));
+		const __m128 disc = _mm_sub_ps(_mm_mul_ps(b, b), _mm_mul_ps(a, c));
+		__m128 ti = _mm_sub_ps(_mm_xor_ps(b, sign), _mm_sqrt_ps(_mm_max_ps(disc, zero)));
+		ti = _mm_div_ps(ti, a);
+		//Starting inside hits at t = 0, otherwise we must be moving towards the
+		//circle and reach it within the segment
+		const __m128 inside = _mm_cmple_ps(c, zero);
+		const __m128 reach = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(b, zero), _mm_cmpge_ps(disc, zero)),
+			_mm_cmple_ps(ti, one));
+		ti = _mm_andnot_ps(inside, ti);
+		const __m128 better = _mm_and_ps(_mm_or_ps(inside, reach), _mm_cmplt_ps(ti, best_t));
+		best_t = _mm_or_ps(_mm_and_ps(better, ti), _mm_andnot_ps(better, best_t));
+		const __m128i take = _mm_castps_si128(better);
+		best_i = _mm_or_si128(_mm_and_si128(take, index), _mm_andnot_si128(take, best_i));
+	}
+	float lane_t[4];
+	int32_t lane_i[4];
+	_mm_storeu_ps(lane_t, best_t);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(lane_i), best_i);
+	int32_t best = -1;
+	for (int l = 0; l < 4; ++l){
+		if (lane_i[l] >= 0 && (best < 0 || lane_t[l] < t || (lane_t[l] == t && lane_i[l] < best))){
+			best = lane_i[l];
+			t = lane_t[l];
+		}
+	}
+	float tail_t = 0;
+	const int32_t tail = ray_circles_scalar(o, d, cx + i, cy + i, r + i, n - i, tail_t);
+	return merge_hit(best, t, tail, tail_t, i);
+}
+#else
+int32_t kernel::detail::ray_circles_sse2(const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	return ray_circles_scalar(o, d, cx, cy, r, n, t);
+}
+#endif
+
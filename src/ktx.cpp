@@ -0,0 +1,400 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gl_core_3_3.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "mapped_file.h"
+#include "util.h"
+#include "ktx.h"
+
+namespace {
+	const unsigned char IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+	const uint32_t ENDIANNESS = 0x04030201;
+	//The orientation we write, the first row of the image is its bottom
+	const char ORIENTATION_KEY[] = "KTXorientation";
+	const char ORIENTATION[] = "S=r,T=u";
+
+	struct Header {
+		uint32_t endianness, type, type_size, format, internal_format, base_format;
+		uint32_t width, height, depth, array_elements, faces, mip_levels, kv_bytes;
+	};
+
+	inline size_t pad4(size_t x){
+		return (x + 3) & ~size_t{3};
+	}
+	/*
+	 * Get the bytes per 4x4 block of a compressed format, or 0 if it's not
+	 * one we support
+	 */
+	size_t block_bytes(GLenum format){
+		switch (format){
+			case ktx::COMPRESSED_RGB_S3TC_DXT1:
+			case ktx::COMPRESSED_RGBA_S3TC_DXT1:
+			case GL_COMPRESSED_RED_RGTC1:
+				return 8;
+			case ktx::COMPRESSED_RGBA_S3TC_DXT3:
+			case ktx::COMPRESSED_RGBA_S3TC_DXT5:
+			case GL_COMPRESSED_RG_RGTC2:
+				return 16;
+			default:
+				return 0;
+		}
+	}
+	/*
+	 * Get the channels in an uncompressed 8 bit format, or 0 if it's not one we support
+	 */
+	int format_channels(GLenum format){
+		switch (format){
+			case GL_RED:
+				return 1;
+			case GL_RG:
+				return 2;
+			case GL_RGB:
+				return 3;
+			case GL_RGBA:
+				return 4;
+			default:
+				return 0;
+		}
+	}
+	/*
+	 * Get the expected size of a w x h level of an image
+	 */
+	size_t level_size(const ktx::Image &img, size_t w, size_t h){
+		if (img.compressed()){
+			return ((w + 3) / 4) * ((h + 3) / 4) * block_bytes(img.internal_format);
+		}
+		//Rows of uncompressed levels are padded to 4 bytes
+		return pad4(w * format_channels(img.format)) * h;
+	}
+
+	/*
+	 * Decode the 16 colors of a BC1 block, four_color forces the 4 color
+	 * mode used by the color part of BC2 and BC3 blocks
+	 */
+	void decode_bc1(const unsigned char *b, bool four_color, unsigned char out[16][4]){
+		const uint16_t c[2] = {static_cast<uint16_t>(b[0] | b[1] << 8), static_cast<uint16_t>(b[2] | b[3] << 8)};
+		int colors[4][4];
+		for (int i = 0; i < 2; ++i){
+			colors[i][0] = ((c[i] >> 11) * 255 + 15) / 31;
+			colors[i][1] = (((c[i] >> 5) & 63) * 255 + 31) / 63;
+			colors[i][2] = ((c[i] & 31) * 255 + 15) / 31;
+			colors[i][3] = 255;
+		}
+		for (int j = 0; j < 4; ++j){
+			if (four_color || c[0] > c[1]){
+				colors[2][j] = (2 * colors[0][j] + colors[1][j]) / 3;
+				colors[3][j] = (colors[0][j] + 2 * colors[1][j]) / 3;
+			}
+			else {
+				colors[2][j] = (colors[0][j] + colors[1][j]) / 2;
+				colors[3][j] = 0;
+			}
+		}
+		const uint32_t indices = b[4] | b[5] << 8 | b[6] << 16 | static_cast<uint32_t>(b[7]) << 24;
+		for (int i = 0; i < 16; ++i){
+			const int *col = colors[(indices >> (2 * i)) & 3];
+			for (int j = 0; j < 4; ++j){
+				out[i][j] = static_cast<unsigned char>(col[j]);
+			}
+		}
+	}
+	/*
+	 * Decode the 16 values of a BC4 block, also used for the alpha of BC3
+	 * and each channel of BC5
+	 */
+	void decode_bc4(const unsigned char *b, unsigned char out[16]){
+		int values[8] = {b[0], b[1]};
+		if (b[0] > b[1]){
+			for (int i = 2; i < 8; ++i){
+				values[i] = ((8 - i) * b[0] + (i - 1) * b[1]) / 7;
+			}
+		}
+		else {
+			for (int i = 2; i < 6; ++i){
+				values[i] = ((6 - i) * b[0] + (i - 1) * b[1]) / 5;
+			}
+			values[6] = 0;
+			values[7] = 255;
+		}
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; ++i){
+			indices |= static_cast<uint64_t>(b[2 + i]) << (8 * i);
+		}
+		for (int i = 0; i < 16; ++i){
+			out[i] = static_cast<unsigned char>(values[(indices >> (3 * i)) & 7]);
+		}
+	}
+}
+
+bool ktx::Image::compressed() const {
+	return type == 0;
+}
+bool ktx::is_ktx(const std::string &file){
+	return file.size() > 4 && file.compare(file.size() - 4, 4, ".ktx") == 0;
+}
+bool ktx::parse(const char *data, size_t len, Image &img){
+	img.levels.clear();
+	Header h;
+	if (len < sizeof(IDENTIFIER) + sizeof(Header) || std::memcmp(data, IDENTIFIER, sizeof(IDENTIFIER)) != 0){
+		std::cerr << "KTX error: not a KTX file\n";
+		return false;
+	}
+	std::memcpy(&h, data + sizeof(IDENTIFIER), sizeof(Header));
+	if (h.endianness != ENDIANNESS){
+		std::cerr << "KTX error: files in the other byte order aren't supported\n";
+		return false;
+	}
+	if (h.depth > 1 || h.array_elements > 0 || h.faces != 1 || h.width == 0 || h.height == 0){
+		std::cerr << "KTX error: only single 2D images are supported\n";
+		return false;
+	}
+	img.type = h.type;
+	img.format = h.format;
+	img.internal_format = h.internal_format;
+	img.base_format = h.base_format;
+	img.width = h.width;
+	img.height = h.height;
+	if ((img.compressed() && block_bytes(img.internal_format) == 0)
+		|| (!img.compressed() && (img.type != GL_UNSIGNED_BYTE || format_channels(img.format) == 0)))
+	{
+		std::cerr << "KTX error: unsupported format " << std::hex << img.internal_format << std::dec << "\n";
+		return false;
+	}
+	size_t pos = sizeof(IDENTIFIER) + sizeof(Header);
+	if (h.kv_bytes > len - pos){
+		std::cerr << "KTX error: file is truncated\n";
+		return false;
+	}
+	//Only the orientation is looked at, warn if the rows are top to bottom since
+	//we don't flip them on load
+	for (size_t kv = pos; kv + 4 <= pos + h.kv_bytes;){
+		uint32_t kv_len;
+		std::memcpy(&kv_len, data + kv, 4);
+		if (kv_len > pos + h.kv_bytes - kv - 4){
+			break;
+		}
+		const std::string entry{data + kv + 4, kv_len};
+		if (entry.compare(0, sizeof(ORIENTATION_KEY), ORIENTATION_KEY, sizeof(ORIENTATION_KEY)) == 0
+			&& entry.find("T=d") != std::string::npos)
+		{
+			std::cerr << "KTX warning: image rows are top to bottom and will appear upside down\n";
+		}
+		kv += 4 + pad4(kv_len);
+	}
+	pos += h.kv_bytes;
+	const size_t n_levels = std::max(h.mip_levels, uint32_t{1});
+	size_t w = img.width, ht = img.height;
+	for (size_t i = 0; i < n_levels; ++i){
+		uint32_t size;
+		if (len - pos < 4){
+			std::cerr << "KTX error: file is truncated\n";
+			return false;
+		}
+		std::memcpy(&size, data + pos, 4);
+		pos += 4;
+		if (size != level_size(img, w, ht) || size > len - pos){
+			std::cerr << "KTX error: mip level " << i << " has the wrong size\n";
+			return false;
+		}
+		img.levels.push_back(Level{w, ht, size, reinterpret_cast<const unsigned char*>(data + pos)});
+		pos += pad4(size);
+		w = std::max(w / 2, size_t{1});
+		ht = std::max(ht / 2, size_t{1});
+	}
+	return true;
+}
+bool ktx::write(const std::string &file, const Image &img){
+	std::ofstream out(file, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()){
+		return false;
+	}
+	const char zeros[4] = {0};
+	const uint32_t kv_len = sizeof(ORIENTATION_KEY) + sizeof(ORIENTATION);
+	const Header h{ENDIANNESS, img.type, 1, img.format, img.internal_format,
+		img.base_format, static_cast<uint32_t>(img.width), static_cast<uint32_t>(img.height), 0, 0, 1,
+		static_cast<uint32_t>(img.levels.size()), static_cast<uint32_t>(4 + pad4(kv_len))};
+	out.write(reinterpret_cast<const char*>(IDENTIFIER), sizeof(IDENTIFIER));
+	out.write(reinterpret_cast<const char*>(&h), sizeof(Header));
+	out.write(reinterpret_cast<const char*>(&kv_len), 4);
+	out.write(ORIENTATION_KEY, sizeof(ORIENTATION_KEY));
+	out.write(ORIENTATION, sizeof(ORIENTATION));
+	out.write(zeros, pad4(kv_len) - kv_len);
+	for (const Level &l : img.levels){
+		const uint32_t size = static_cast<uint32_t>(l.size);
+		out.write(reinterpret_cast<const char*>(&size), 4);
+		out.write(reinterpret_cast<const char*>(l.data), l.size);
+		out.write(zeros, pad4(l.size) - l.size);
+	}
+	return static_cast<bool>(out);
+}
+bool ktx::format_supported(GLenum internal_format){
+	//RGTC is core since 3.0, S3TC needs the extension
+	if (internal_format == GL_COMPRESSED_RED_RGTC1 || internal_format == GL_COMPRESSED_RG_RGTC2){
+		return true;
+	}
+	static int s3tc = -1;
+	if (s3tc == -1){
+		s3tc = 0;
+		GLint n = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+		for (GLint i = 0; i < n && !s3tc; ++i){
+			const char *ext = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			s3tc = ext && std::strcmp(ext, "GL_EXT_texture_compression_s3tc") == 0;
+		}
+	}
+	return s3tc == 1;
+}
+int ktx::decompress(const Image &img, const Level &level, std::vector<unsigned char> &out){
+	const GLenum f = img.internal_format;
+	const int channels = f == GL_COMPRESSED_RED_RGTC1 ? 1 : f == GL_COMPRESSED_RG_RGTC2 ? 2 : 4;
+	const size_t bs = block_bytes(f), bw = (level.width + 3) / 4, bh = (level.height + 3) / 4;
+	out.resize(level.width * level.height * channels);
+	unsigned char texels[16][4];
+	unsigned char values[16];
+	for (size_t by = 0; by < bh; ++by){
+		for (size_t bx = 0; bx < bw; ++bx){
+			const unsigned char *b = level.data + (by * bw + bx) * bs;
+			if (f == GL_COMPRESSED_RED_RGTC1 || f == GL_COMPRESSED_RG_RGTC2){
+				for (int c = 0; c < channels; ++c){
+					decode_bc4(b + 8 * c, values);
+					for (int i = 0; i < 16; ++i){
+						texels[i][c] = values[i];
+					}
+				}
+			}
+			else if (f == COMPRESSED_RGB_S3TC_DXT1 || f == COMPRESSED_RGBA_S3TC_DXT1){
+				decode_bc1(b, false, texels);
+				//The transparent black of 3 color blocks is opaque black in the RGB format
+				if (f == COMPRESSED_RGB_S3TC_DXT1){
+					for (int i = 0; i < 16; ++i){
+						texels[i][3] = 255;
+					}
+				}
+			}
+			else {
+				decode_bc1(b + 8, true, texels);
+				if (f == COMPRESSED_RGBA_S3TC_DXT3){
+					for (int i = 0; i < 16; ++i){
+						texels[i][3] = static_cast<unsigned char>(((b[i / 2] >> (4 * (i % 2))) & 15) * 17);
+					}
+				}
+				else {
+					decode_bc4(b, values);
+					for (int i = 0; i < 16; ++i){
+						texels[i][3] = values[i];
+					}
+				}
+			}
+			//Blocks on the right and top edges can hang off the image
+			for (size_t y = 0; y < 4 && by * 4 + y < level.height; ++y){
+				for (size_t x = 0; x < 4 && bx * 4 + x < level.width; ++x){
+					std::memcpy(&out[((by * 4 + y) * level.width + bx * 4 + x) * channels],
+						texels[y * 4 + x], channels);
+				}
+			}
+		}
+	}
+	return channels;
+}
+GLuint ktx::load(const std::vector<std::string> &files, GLenum target, size_t *width, size_t *height,
+	size_t *bytes)
+{
+	TRACE_SCOPE("ktx::load");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	std::vector<std::unique_ptr<MappedFile>> mapped;
+	std::vector<Image> images(files.size());
+	for (size_t i = 0; i < files.size(); ++i){
+		mapped.emplace_back(new MappedFile{files[i]});
+		if (!mapped.back()->good() || !parse(mapped.back()->data(), mapped.back()->size(), images[i])){
+			std::cerr << "Failed to load KTX file " << files[i] << std::endl;
+			return 0;
+		}
+		const Image &a = images.front(), &b = images[i];
+		if (a.width != b.width || a.height != b.height || a.type != b.type || a.format != b.format
+			|| a.internal_format != b.internal_format || a.levels.size() != b.levels.size())
+		{
+			std::cerr << "load_texture_array error: Attempt to create array of incompatible images\n";
+			return 0;
+		}
+	}
+	const Image &first = images.front();
+	const GLsizei layers = static_cast<GLsizei>(images.size());
+	const bool direct = !first.compressed() || format_supported(first.internal_format);
+	if (!direct){
+		std::cerr << "KTX warning: compressed format " << std::hex << first.internal_format << std::dec
+			<< " isn't supported, decompressing on load\n";
+	}
+	if (width){
+		*width = first.width;
+	}
+	if (height){
+		*height = first.height;
+	}
+
+	GLuint tex;
+	glGenTextures(1, &tex);
+	glBindTexture(target, tex);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, direct ? 4 : 1);
+	size_t total = 0;
+	int channels = format_channels(first.format);
+	std::vector<unsigned char> texels;
+	for (size_t l = 0; l < first.levels.size(); ++l){
+		const Level &lv = first.levels[l];
+		const GLsizei w = static_cast<GLsizei>(lv.width), h = static_cast<GLsizei>(lv.height);
+		if (first.compressed() && direct){
+			const GLenum f = first.internal_format;
+			if (target == GL_TEXTURE_2D){
+				glCompressedTexImage2D(target, l, f, w, h, 0, lv.size, lv.data);
+			}
+			else {
+				glCompressedTexImage3D(target, l, f, w, h, layers, 0, lv.size * layers, nullptr);
+				for (GLsizei i = 0; i < layers; ++i){
+					glCompressedTexSubImage3D(target, l, 0, 0, i, w, h, 1, f, lv.size, images[i].levels[l].data);
+				}
+			}
+			total += lv.size * layers;
+			continue;
+		}
+		for (GLsizei i = 0; i < layers; ++i){
+			const unsigned char *data = images[i].levels[l].data;
+			if (first.compressed()){
+				channels = decompress(images[i], images[i].levels[l], texels);
+				data = texels.data();
+			}
+			const GLenum format = first.compressed() ? util::image_format(channels) : first.format;
+			const GLenum internal = first.compressed() ? format : first.internal_format;
+			if (target == GL_TEXTURE_2D){
+				glTexImage2D(target, l, internal, w, h, 0, format, GL_UNSIGNED_BYTE, data);
+			}
+			else {
+				if (i == 0){
+					glTexImage3D(target, l, internal, w, h, layers, 0, format, GL_UNSIGNED_BYTE, nullptr);
+				}
+				glTexSubImage3D(target, l, 0, 0, i, w, h, 1, format, GL_UNSIGNED_BYTE, data);
+			}
+		}
+		total += lv.width * lv.height * channels * layers;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	//Files without a mip chain get one made, unless they're compressed since
+	//drivers can't be relied on to generate mips for compressed formats
+	if (first.levels.size() == 1 && !(first.compressed() && direct)){
+		glGenerateMipmap(target);
+		total = util::mip_chain_bytes(first.width, first.height, layers, channels);
+	}
+	else {
+		glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, first.levels.size() - 1);
+	}
+	if (bytes){
+		*bytes = total;
+	}
+	return tex;
+}
+
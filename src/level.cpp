@@ -1,28 +1,56 @@
-#include <random>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <tuple>
-#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
 #include <SDL.h>
 #include <entityx/entityx.h>
-#include <entityx/deps/Dependencies.h>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <lfwatch.h>
 #include "util.h"
 #include "interleavedbuffer.h"
+#include "thread_pool.h"
+#include "entity_pool.h"
+#include "sim_config.h"
+#include "input_source.h"
+#include "philox.h"
+#include "hash.h"
+#include "world_snapshot.h"
+#include "system_scheduler.h"
+#include "movement_kernel.h"
+#include "sim_lod.h"
+#include "trace.h"
+#include "memory_tracker.h"
 #include "events/input_event.h"
 #include "systems/movement_system.h"
 #include "systems/input_system.h"
 #include "systems/asteroid_system.h"
+#include "systems/collision_system.h"
+#include "systems/physics_system.h"
+#include "systems/projectile_system.h"
 #include "components/position.h"
 #include "components/velocity.h"
 #include "components/appearance.h"
 #include "components/controllable.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+#include "components/rigid_body.h"
 #include "level.h"
 
-Level::Level() : shader_program(0), viewing(2, GL_UNIFORM_BUFFER, GL_STATIC_DRAW), quit(false) {}
+Level::Level(const SimConfig &config, const std::shared_ptr<InputSource> &input) : shader_program(0),
+	viewing(2, GL_UNIFORM_BUFFER, GL_STATIC_DRAW), quit(false),
+	kinematics(std::make_shared<Kinematics>()), colliders(std::make_shared<Colliders>()),
+	bodies(std::make_shared<Bodies>()),
+	entity_pool(entity_manager), config(config), input(input), tick_count(0), tick_hash(0)
+{}
 Level::~Level(){
-	glDeleteProgram(shader_program);
+	if (!config.headless){
+		glDeleteProgram(shader_program);
+	}
 }
 void Level::receive(const InputEvent &input){
 	switch (input.event.type){
@@ -37,19 +65,74 @@ void Level::receive(const InputEvent &input){
 	}
 }
 bool Level::should_quit(){
-	return quit;
+	return quit || input->finished(tick_count);
+}
+uint64_t Level::ticks() const {
+	return tick_count;
+}
+uint64_t Level::state_hash() const {
+	//The packed order only depends on the order entities were added and removed,
+	//so it's the same between deterministic runs and we can hash the arrays directly.
+	//Entity ids aren't hashed since a world restored from a snapshot gets new ids
+	uint64_t hash = util::FNV_OFFSET;
+	hash = util::fnv1a(kinematics->data<Position>(), kinematics->size() * sizeof(Position), hash);
+	hash = util::fnv1a(kinematics->data<Velocity>(), kinematics->size() * sizeof(Velocity), hash);
+	return util::fnv1a(&tick_count, sizeof(tick_count), hash);
+}
+uint64_t Level::last_tick_hash() const {
+	return tick_hash;
+}
+size_t Level::entities() const {
+	return kinematics->size();
 }
+const SystemScheduler& Level::systems() const {
+	return *scheduler;
+}
+//Room for the bullets in flight
+static const size_t MAX_BULLETS = 1 << 16;
+//Half the width of the square area the camera shows around the origin
+static const float VIEW_EXTENT = 5.f;
+
 void Level::configure(){
-	system_manager->add<MovementSystem>();
-	system_manager->add<AsteroidSystem>(1);
-	system_manager->add<InputSystem>();
-	system_manager->add<entityx::deps::Dependency<Asteroid, Position, Velocity>>();
+	//Asteroids and bullets wrap around the edges of the playfield
+	const kernel::Bounds playfield{glm::vec2{-config.field, -config.field},
+		glm::vec2{config.field, config.field}};
+	auto movement = system_manager->add<MovementSystem>(thread_pool, kinematics, playfield);
+	//Everything on screen moves every tick, further out it's every 2nd then every 4th tick.
+	//The camera doesn't move so the LOD is centered on the view, the first bucket reaches
+	//the corners of the view with some room for entities moving in between rebuckets
+	const float near = std::sqrt(2.f) * VIEW_EXTENT + 1.f;
+	auto lod = movement->enable_lod({LodBucket{near, 1}, LodBucket{3.f * near, 2}, LodBucket{0.f, 4}},
+		glm::vec2{0.f, 0.f});
+	system_manager->add<AsteroidSystem>(thread_pool, config.asteroids + 1, kinematics, config.seed);
+	system_manager->add<InputSystem>(kinematics, input, tick_count);
+	system_manager->add<CollisionSystem>(thread_pool, kinematics, colliders);
+	system_manager->add<PhysicsSystem>(thread_pool, kinematics, colliders, bodies)->set_lod(lod);
+	system_manager->add<ProjectileSystem>(thread_pool, entity_pool, kinematics, colliders,
+		MAX_BULLETS, playfield);
+	//The systems are scheduled in the order they'd run one after another, anything that
+	//doesn't conflict with the systems before it can run in parallel with them
+	scheduler.reset(new SystemScheduler{thread_pool, entity_manager, event_manager});
+	scheduler->add(system_manager->system<InputSystem>(), "input");
+	//Contacts are resolved before moving so nothing passes through anything else
+	scheduler->add(system_manager->system<PhysicsSystem>(), "physics");
+	scheduler->add(system_manager->system<MovementSystem>(), "movement");
+	scheduler->add(system_manager->system<CollisionSystem>(), "collision");
+	scheduler->add(system_manager->system<ProjectileSystem>(), "projectile");
+	scheduler->add(system_manager->system<AsteroidSystem>(), "asteroid");
 
+	event_manager->subscribe<InputEvent>(*this);
+	event_manager->subscribe<entityx::EntityDestroyedEvent>(*kinematics);
+	event_manager->subscribe<entityx::EntityDestroyedEvent>(*colliders);
+	event_manager->subscribe<entityx::EntityDestroyedEvent>(*bodies);
+	//Headless levels have no context to compile shaders with
+	if (config.headless){
+		return;
+	}
 	std::string res_path = util::get_resource_path();
 	shader_program = util::load_program({std::make_tuple(GL_VERTEX_SHADER, res_path + "vertex.glsl"),
 		std::make_tuple(GL_FRAGMENT_SHADER, res_path + "fragment.glsl")});
 	assert(shader_program != -1);
-	event_manager->subscribe<InputEvent>(*this);
 	file_watcher.watch(res_path, lfw::Notify::FILE_MODIFIED,
 		[this](const lfw::EventData &e){
 			if (e.fname == "vertex.glsl" || e.fname == "fragment.glsl"){
@@ -58,36 +141,39 @@ void Level::configure(){
 		});
 }
 void Level::initialize(){
-	std::mt19937 gen{std::time(0)};
-	std::uniform_real_distribution<float> dir{0, 2 * 3.14};
-	std::uniform_real_distribution<float> pos{-5, 5};
-	for (int i = 0; i < 30; ++i){
-		entityx::Entity e = entity_manager->create();
-		if (i == 0){
-			e.assign<Controllable>();
-		}
-		else {
-			e.assign<Position>(glm::vec2{pos(gen), pos(gen)});
-			float angle = dir(gen);
-			e.assign<Velocity>(0.25f * glm::vec2{std::cos(angle), std::sin(angle)});
-		}
-		e.assign<Asteroid>();
+	if (config.snapshot.empty() || !load_snapshot(config.snapshot)){
+		spawn();
 	}
 	viewing.map(GL_WRITE_ONLY);
 	viewing.write<0>(0) = glm::lookAt(glm::vec3{0.f, 0.f, 8.f}, glm::vec3{0.f, 0.f, 0.f},
 		glm::vec3{0.f, 1.f, 0.f});
-	viewing.write<0>(1) = glm::ortho(-5.f, 5.f, -5.f, 5.f, 1.f, 100.f);
+	viewing.write<0>(1) = glm::ortho(-VIEW_EXTENT, VIEW_EXTENT, -VIEW_EXTENT, VIEW_EXTENT, 1.f, 100.f);
 	viewing.unmap();
+	if (config.headless){
+		return;
+	}
 	GLuint viewing_block = glGetUniformBlockIndex(shader_program, "Viewing");
 	glUniformBlockBinding(shader_program, viewing_block, 0);
 	viewing.bind_base(0);
 	glUseProgram(shader_program);
 }
 void Level::update(double dt){
+	TRACE_FRAME();
+	TRACE_SCOPE("Level::update");
 	file_watcher.update();
-	system_manager->update<InputSystem>(dt);
-	system_manager->update<MovementSystem>(dt);
-	system_manager->update<AsteroidSystem>(dt);
+	//In deterministic mode each update is one fixed tick, the caller decides how often to tick
+	scheduler->update(config.deterministic ? config.tick : dt);
+	//Despawns queued during the frame are applied together once all the systems are done
+	{
+		TRACE_SCOPE("EntityPool::flush");
+		memtrack::Scope mem_tag{memtrack::Tag::ECS};
+		entity_pool.flush();
+	}
+	++tick_count;
+	if (config.deterministic){
+		TRACE_SCOPE("Level::state_hash");
+		tick_hash = state_hash();
+	}
 }
 void Level::load_shader(){
 	std::string res_path = util::get_resource_path();
@@ -102,4 +188,168 @@ void Level::load_shader(){
 		shader_program = shader;
 	}
 }
+void Level::spawn(){
+	memtrack::Scope mem_tag{memtrack::Tag::ECS};
+	Philox rng{config.seed, static_cast<uint32_t>(RandomStream::SPAWN)};
+	const size_t n = config.asteroids + 1;
+	entity_pool.reserve(n);
+	kinematics->reserve(n);
+	colliders->reserve(n);
+	bodies->reserve(n);
+	std::vector<entityx::Entity> spawned;
+	entity_pool.create(n, spawned);
+	for (size_t i = 0; i < spawned.size(); ++i){
+		entityx::Entity &e = spawned[i];
+		if (i == 0){
+			e.assign<Controllable>();
+			kinematics->assign(e.id(), Position{}, Velocity{});
+		}
+		else {
+			const float f = config.field;
+			glm::vec2 p{rng.uniform(-f, f), rng.uniform(-f, f)};
+			//Pick the direction by rejection sampling the unit circle instead of using sin
+			//and cos since sqrt is the same everywhere but the trig functions aren't
+			glm::vec2 dir;
+			float len2 = 0;
+			do {
+				dir = glm::vec2{rng.uniform(-1.f, 1.f), rng.uniform(-1.f, 1.f)};
+				len2 = dir.x * dir.x + dir.y * dir.y;
+			} while (len2 > 1.f || len2 < 1e-4f);
+			kinematics->assign(e.id(), Position{p}, Velocity{0.25f * dir / std::sqrt(len2)});
+		}
+		EntityPool::tag<Asteroid>(e);
+		colliders->assign(e.id(), Collidable{0.5f});
+		bodies->assign(e.id(), RigidBody{1.f, 0.8f});
+	}
+}
+//Block tags for the snapshot
+static const uint32_t ENTITIES = snapshot::tag("ENTS");
+static const uint32_t TAGS = snapshot::tag("TAGS");
+static const uint32_t KINEMATICS[] = {snapshot::tag("KIDS"), snapshot::tag("POS_"), snapshot::tag("VEL_")};
+static const uint32_t COLLIDERS[] = {snapshot::tag("CIDS"), snapshot::tag("COLL")};
+static const uint32_t BODIES[] = {snapshot::tag("BIDS"), snapshot::tag("BODY")};
+static const uint32_t LOD = snapshot::tag("LOD_");
+//Bits of the tag mask stored for each entity
+enum TagBits : uint8_t {
+	TAG_ASTEROID = 1, TAG_CONTROLLABLE = 2, TAG_CONTROL_ENABLED = 4
+};
+
+bool Level::save_snapshot(const std::string &file){
+	//Snapshot every entity with a component we store, sorted so the restored
+	//entities are created in the same order
+	std::vector<entityx::Entity::Id> ids(kinematics->id_data(), kinematics->id_data() + kinematics->size());
+	ids.insert(ids.end(), colliders->id_data(), colliders->id_data() + colliders->size());
+	ids.insert(ids.end(), bodies->id_data(), bodies->id_data() + bodies->size());
+	for (auto e : entity_manager->entities_with_components<Asteroid>()){
+		ids.push_back(e.id());
+	}
+	for (auto e : entity_manager->entities_with_components<Controllable>()){
+		ids.push_back(e.id());
+	}
+	std::sort(ids.begin(), ids.end(),
+		[](const entityx::Entity::Id &a, const entityx::Entity::Id &b){
+			return a.index() < b.index();
+		});
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+	std::vector<uint8_t> tags(ids.size(), 0);
+	for (size_t i = 0; i < ids.size(); ++i){
+		entityx::Entity e = entity_manager->get(ids[i]);
+		if (e.component<Asteroid>()){
+			tags[i] |= TAG_ASTEROID;
+		}
+		if (auto c = e.component<Controllable>()){
+			tags[i] |= TAG_CONTROLLABLE | (c->enabled ? TAG_CONTROL_ENABLED : 0);
+		}
+	}
+	snapshot::Writer writer{file, tick_count};
+	writer.block(ENTITIES, ids.data(), ids.size());
+	writer.block(TAGS, tags.data(), tags.size());
+	writer.pool(*kinematics, KINEMATICS);
+	writer.pool(*colliders, COLLIDERS);
+	writer.pool(*bodies, BODIES);
+	//The kinematics pool is saved in LOD order, save the partition and tick with it
+	//so the restored run updates the same slices
+	if (const auto &lod = system_manager->system<MovementSystem>()->sim_lod()){
+		const std::vector<uint64_t> state = lod->state();
+		writer.block(LOD, state.data(), state.size());
+	}
+	return writer.finish();
+}
+bool Level::load_snapshot(const std::string &file){
+	memtrack::Scope mem_tag{memtrack::Tag::ECS};
+	snapshot::Reader reader{file};
+	uint64_t n = 0, n_tags = 0;
+	const entityx::Entity::Id *ids = reader.good() ? reader.block<entityx::Entity::Id>(ENTITIES, n) : nullptr;
+	const uint8_t *tags = reader.good() ? reader.block<uint8_t>(TAGS, n_tags) : nullptr;
+	if (!ids || !tags || n != n_tags){
+		std::cerr << "Level: " << file << " is missing the entity blocks\n";
+		return false;
+	}
+	//Check everything before touching the world so a bad snapshot leaves it as it was
+	std::unordered_map<uint32_t, size_t> saved;
+	saved.reserve(n);
+	for (size_t i = 0; i < n; ++i){
+		if (!saved.emplace(ids[i].index(), i).second){
+			std::cerr << "Level: " << file << " has duplicate entities\n";
+			return false;
+		}
+	}
+	auto slot = [&](const entityx::Entity::Id &id){
+		auto f = saved.find(id.index());
+		return f != saved.end() ? f->second : n;
+	};
+	if (!reader.pool_ok(*kinematics, KINEMATICS, n, slot) || !reader.pool_ok(*colliders, COLLIDERS, n, slot)
+		|| !reader.pool_ok(*bodies, BODIES, n, slot))
+	{
+		std::cerr << "Level: " << file << " has missing or mismatched component blocks\n";
+		return false;
+	}
+	std::shared_ptr<SimLod> lod = system_manager->system<MovementSystem>()->sim_lod();
+	uint64_t n_lod = 0, n_kinematics = 0;
+	const uint64_t *lod_state = reader.block<uint64_t>(LOD, n_lod);
+	reader.block<entityx::Entity::Id>(KINEMATICS[0], n_kinematics);
+	if (lod && (!lod_state || !lod->can_restore(lod_state, n_lod, n_kinematics))){
+		std::cerr << "Level: " << file << " has a missing or mismatched LOD block\n";
+		return false;
+	}
+	//Clear out the current world and create new entities for the snapshot's,
+	//mapping the saved entity indices to the new ids
+	for (auto e : entity_manager->entities_with_components<Asteroid>()){
+		entity_pool.despawn(e.id());
+	}
+	for (auto e : entity_manager->entities_with_components<Controllable>()){
+		entity_pool.despawn(e.id());
+	}
+	entity_pool.despawn(std::vector<entityx::Entity::Id>(kinematics->id_data(),
+		kinematics->id_data() + kinematics->size()));
+	entity_pool.despawn(std::vector<entityx::Entity::Id>(colliders->id_data(),
+		colliders->id_data() + colliders->size()));
+	entity_pool.despawn(std::vector<entityx::Entity::Id>(bodies->id_data(),
+		bodies->id_data() + bodies->size()));
+	entity_pool.flush();
 
+	entity_pool.reserve(n);
+	std::vector<entityx::Entity> spawned;
+	entity_pool.create(n, spawned);
+	for (size_t i = 0; i < n; ++i){
+		entityx::Entity &e = spawned[i];
+		if (tags[i] & TAG_ASTEROID){
+			EntityPool::tag<Asteroid>(e);
+		}
+		if (tags[i] & TAG_CONTROLLABLE){
+			e.assign<Controllable>((tags[i] & TAG_CONTROL_ENABLED) != 0);
+		}
+	}
+	auto remap_id = [&](const entityx::Entity::Id &id){
+		return spawned[saved.find(id.index())->second].id();
+	};
+	reader.pool(*kinematics, KINEMATICS, remap_id);
+	reader.pool(*colliders, COLLIDERS, remap_id);
+	reader.pool(*bodies, BODIES, remap_id);
+	if (lod){
+		lod->restore(lod_state, n_lod, kinematics->size());
+	}
+	tick_count = reader.tick();
+	return true;
+}
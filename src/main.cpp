@@ -1,5 +1,10 @@
 #include <iostream>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
 #include <tuple>
 #include <array>
 #include <string>
@@ -15,11 +20,21 @@
 #include "renderbatch.h"
 #include "model.h"
 #include "level.h"
+#include "sim_config.h"
+#include "input_source.h"
+#include "gl_backend.h"
 #include "layout_padding.h"
 #include "texture_atlas.h"
 #include "texture_atlas_array.h"
+#include "texture_loader.h"
+#include "thread_pool.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "tiles_spritesheet_sprites.h"
 
-void run(SDL_Window *win);
+void run(SDL_Window *win, const std::string &record_file);
+//Replay an input log without a window as fast as possible, printing timing and the final state hash
+int replay(const std::string &file);
 void tile_demo(SDL_Window *win);
 //This is just for testing that the alignments/offsets I compute match STD140 in GLSL
 std::string gltype_tostring(GLint type);
@@ -27,6 +42,44 @@ void print_glsl_blocks();
 void test_buffer();
 
 int main(int argc, char **argv){
+	//Report where the memory went once everything's been cleaned up, on stderr since
+	//--replay's output on stdout is read by scripts
+	std::atexit([](){
+		memtrack::dump(std::cerr);
+	});
+	//--record <log> plays the level recording the input, --replay <log> replays it headless
+	//--trace <file> writes a trace of the run, recording one in every --trace-every <n> frames
+	std::string record_file, replay_file, trace_file;
+	uint32_t trace_every = 1;
+	for (int i = 1; i < argc - 1; ++i){
+		std::string arg = argv[i];
+		if (arg == "--record"){
+			record_file = argv[++i];
+		}
+		else if (arg == "--replay"){
+			replay_file = argv[++i];
+		}
+		else if (arg == "--trace"){
+			trace_file = argv[++i];
+		}
+		else if (arg == "--trace-every"){
+			trace_every = std::max(std::atoi(argv[++i]), 1);
+		}
+	}
+	if (!trace_file.empty()){
+		if (!trace::COMPILED_IN){
+			std::cerr << "Tracing isn't compiled in, rebuild with ASTEROIDS_TRACE on\n";
+		}
+		TRACE_THREAD_NAME("main");
+		trace::enable(trace_every);
+	}
+	if (!replay_file.empty()){
+		const int ret = replay(replay_file);
+		if (!trace_file.empty()){
+			trace::flush(trace_file);
+		}
+		return ret;
+	}
 	if (SDL_Init(SDL_INIT_EVERYTHING) != 0){
 		std::cerr << "SDL_Init error: " << SDL_GetError() << "\n";
 		return 1;
@@ -66,20 +119,31 @@ int main(int argc, char **argv){
 	glDebugMessageControlARB(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0,
 		NULL, GL_TRUE);
 
-	tile_demo(win);
+	if (!record_file.empty()){
+		run(win, record_file);
+	}
+	else {
+		tile_demo(win);
+	}
 
+	if (!trace_file.empty()){
+		trace::flush(trace_file);
+	}
 	SDL_GL_DeleteContext(context);
 	SDL_DestroyWindow(win);
 	SDL_Quit();
 	return 0;
 }
-void run(SDL_Window *win){
-	Level level;
+void run(SDL_Window *win, const std::string &record_file){
+	//Recording runs in deterministic mode so the replay can recreate the same world
+	SimConfig config = SimConfig::fixed(static_cast<uint64_t>(std::time(0)));
+	std::shared_ptr<InputSource> input = std::make_shared<InputRecorder>(
+		std::make_shared<SDLInputSource>(), record_file, config.seed, config.tick);
+	Level level{config, input};
 	level.start();
 	while (!level.should_quit()){
-		//TODO Fake time for now
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		level.step(0.1);
+		level.step(config.tick);
 		GLenum err = glGetError();
 		if (err != GL_NO_ERROR){
 			std::cerr << "OpenGL Error: " << std::hex << err << std::dec << "\n";
@@ -89,8 +153,48 @@ void run(SDL_Window *win){
 		SDL_Delay(16);
 	}
 }
+int replay(const std::string &file){
+	auto input = std::make_shared<InputReplay>(file);
+	if (!input->good()){
+		return 1;
+	}
+	gl::MockBackend backend;
+	gl::set_backend(&backend);
+	uint64_t ticks = 0, hash = 0;
+	double elapsed = 0;
+	{
+		Level level{SimConfig::fixed(input->seed(), input->tick_length(), true), input};
+		level.start();
+		auto start = std::chrono::high_resolution_clock::now();
+		while (!level.should_quit()){
+			level.step(input->tick_length());
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		elapsed = std::chrono::duration<double>(end - start).count();
+		ticks = level.ticks();
+		hash = level.last_tick_hash();
+	}
+	gl::set_backend(nullptr);
+	std::cout << "Replayed " << ticks << " ticks in " << elapsed << "s ("
+		<< ticks / elapsed << " ticks/s)\n"
+		<< "Final state hash: " << std::hex << hash << std::dec << "\n"
+		<< "Draw calls: " << backend.stats().draw_calls
+		<< ", bytes uploaded: " << backend.stats().bytes_uploaded << "\n";
+	return 0;
+}
 void tile_demo(SDL_Window *win){
 	std::string res_path = util::get_resource_path();
+	//The atlas image is decoded in the background while the rest of the demo is
+	//set up and uploaded a bit at a time each frame. There's only the one image
+	//to decode so a single worker is all the loader needs
+	ThreadPool pool{1};
+	TextureLoader loader{pool};
+	TextureAtlas atlas{res_path + "tiles_spritesheet.xml", loader};
+	namespace tile_ids = sprites::tiles_spritesheet;
+	//The generated ids are indices into the document they were made from
+	if (atlas.source_hash() != tile_ids::SOURCE_HASH){
+		std::cerr << "Warning: tiles_spritesheet.xml has changed since its sprite ids were generated\n";
+	}
 	GLint shader = util::load_program({std::make_tuple(GL_VERTEX_SHADER, res_path + "vtiles.glsl"),
 		std::make_tuple(GL_FRAGMENT_SHADER, res_path + "ftiles.glsl")});
 	assert(shader != -1);
@@ -106,17 +210,14 @@ void tile_demo(SDL_Window *win){
 	glUniformBlockBinding(shader, viewing_block, 0);
 	viewing.bind_base(0);
 
-	TextureAtlas atlas{res_path + "tiles_spritesheet.xml"};
-
 	auto tile_uvs = std::make_shared<InterleavedBuffer<Layout::PACKED, glm::vec2>>(atlas.size() * 4,
 		GL_UNIFORM_BUFFER, GL_STATIC_DRAW);
 	tile_uvs->map(GL_WRITE_ONLY);
+	//The uvs are in id order so a tile's SpriteId is its index in the buffer
 	int i = 0;
-	std::unordered_map<std::string, int> tile_ids;
 	for (auto it = atlas.cbegin(); it != atlas.cend(); ++it){
-		tile_ids[it->first] = i;
 		for (int j = 0; j < 4; ++j){
-			tile_uvs->write<0>(4 * i + j) = it->second[j];
+			tile_uvs->write<0>(4 * i + j) = (*it)[j];
 		}
 		++i;
 	}
@@ -141,19 +242,19 @@ void tile_demo(SDL_Window *win){
 			pos.x = w * -1.6f;
 			pos.y -= 3.2f;
 		}
-		int tile_id = -1;
+		SpriteId tile_id = INVALID_SPRITE;
 		switch (*iter){
 			case 'x':
-				tile_id = tile_ids["grass.png"];
+				tile_id = tile_ids::GRASS;
 				break;
 			case 'o':
-				tile_id = tile_ids["dirt.png"];
+				tile_id = tile_ids::DIRT;
 				break;
 		}
 		++iter;
-		if (tile_id > -1){
+		if (tile_id != INVALID_SPRITE){
 			tiles.push_back(std::make_tuple(glm::translate(pos)
-				* glm::scale(glm::vec3{1.6f, 1.6f, 1}), tile_id));
+				* glm::scale(glm::vec3{1.6f, 1.6f, 1}), static_cast<int>(tile_id.index)));
 		}
 		pos.x += 3.2f;
 	}
@@ -167,45 +268,46 @@ void tile_demo(SDL_Window *win){
 				quit = true;
 			}
 			else if (e.type == SDL_KEYDOWN){
-				int tile_id = 0;
+				SpriteId tile_id = tile_ids::BOX;
 				switch (e.key.keysym.sym){
 					case SDLK_1:
-						tile_id = tile_ids["fence.png"];
+						tile_id = tile_ids::FENCE;
 						break;
 					case SDLK_2:
-						tile_id = tile_ids["torch.png"];
+						tile_id = tile_ids::TORCH;
 						break;
 					case SDLK_3:
-						tile_id = tile_ids["bridge.png"];
+						tile_id = tile_ids::BRIDGE;
 						break;
 					case SDLK_4:
-						tile_id = tile_ids["dirt.png"];
+						tile_id = tile_ids::DIRT;
 						break;
 					case SDLK_5:
-						tile_id = tile_ids["castle.png"];
+						tile_id = tile_ids::CASTLE;
 						break;
 					case SDLK_6:
-						tile_id = tile_ids["grass.png"];
+						tile_id = tile_ids::GRASS;
 						break;
 					case SDLK_7:
-						tile_id = tile_ids["lock_blue.png"];
+						tile_id = tile_ids::LOCK_BLUE;
 						break;
 					case SDLK_8:
-						tile_id = tile_ids["boxCoin.png"];
+						tile_id = tile_ids::BOX_COIN;
 						break;
 					case SDLK_9:
-						tile_id = tile_ids["window.png"];
+						tile_id = tile_ids::WINDOW;
 						break;
 					default:
-						tile_id = tile_ids["box.png"];
+						tile_id = tile_ids::BOX;
 						break;
 				}
 				auto &buffer = tiles.buffer();
 				buffer.map(GL_WRITE_ONLY);
-				buffer.write<1>(0) = tile_id;
+				buffer.write<1>(0) = tile_id.index;
 				buffer.unmap();
 			}
 		}
+		loader.update(4 * 1024 * 1024);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		tiles.render();
 
@@ -0,0 +1,92 @@
+#include <cstddef>
+#include <iostream>
+#include <string>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "mapped_file.h"
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string &fname) : bytes(nullptr), length(0), mapped(false),
+	file(INVALID_HANDLE_VALUE), mapping(nullptr)
+{
+	file = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE){
+		return;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)){
+		return;
+	}
+	length = static_cast<size_t>(size.QuadPart);
+	//Empty files can't be mapped but there's nothing to read anyway
+	if (length == 0){
+		mapped = true;
+		return;
+	}
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping){
+		return;
+	}
+	bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	mapped = bytes != nullptr;
+}
+MappedFile::~MappedFile(){
+	if (bytes){
+		UnmapViewOfFile(bytes);
+	}
+	if (mapping){
+		CloseHandle(mapping);
+	}
+	if (file != INVALID_HANDLE_VALUE){
+		CloseHandle(file);
+	}
+}
+#else
+MappedFile::MappedFile(const std::string &fname) : bytes(nullptr), length(0), mapped(false) {
+	const int fd = open(fname.c_str(), O_RDONLY);
+	if (fd == -1){
+		return;
+	}
+	struct stat info;
+	if (fstat(fd, &info) == 0){
+		length = static_cast<size_t>(info.st_size);
+		if (length == 0){
+			mapped = true;
+		}
+		else {
+			void *p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED){
+				//Mapped files are read front to back so let the kernel read ahead
+				madvise(p, length, MADV_SEQUENTIAL);
+				bytes = static_cast<const char*>(p);
+				mapped = true;
+			}
+		}
+	}
+	//The mapping keeps the file's contents available after it's closed
+	close(fd);
+}
+MappedFile::~MappedFile(){
+	if (bytes){
+		munmap(const_cast<char*>(bytes), length);
+	}
+}
+#endif
+bool MappedFile::good() const {
+	return mapped;
+}
+const char* MappedFile::data() const {
+	return bytes;
+}
+size_t MappedFile::size() const {
+	return length;
+}
+
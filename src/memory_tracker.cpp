@@ -0,0 +1,190 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include "memory_tracker.h"
+
+namespace {
+	//Each set of counters gets its own cache line so threads allocating
+	//under different tags don't contend
+	struct alignas(64) Counters {
+		std::atomic<uint64_t> allocs, frees, live, peak, total;
+	};
+	//These are zero initialized before any code runs, so they're safe to use
+	//from allocations made during static initialization
+	Counters host_counters[static_cast<size_t>(memtrack::Tag::COUNT)];
+	Counters gpu_counters[static_cast<size_t>(memtrack::Gpu::COUNT)];
+	std::atomic<uint64_t> host_live, host_peak;
+	thread_local memtrack::Tag current = memtrack::Tag::OTHER;
+
+	void raise_peak(std::atomic<uint64_t> &peak, uint64_t live){
+		uint64_t p = peak.load(std::memory_order_relaxed);
+		while (live > p && !peak.compare_exchange_weak(p, live, std::memory_order_relaxed)){}
+	}
+	void add(Counters &c, size_t bytes){
+		c.allocs.fetch_add(1, std::memory_order_relaxed);
+		c.total.fetch_add(bytes, std::memory_order_relaxed);
+		raise_peak(c.peak, c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+	}
+	void remove(Counters &c, size_t bytes){
+		c.frees.fetch_add(1, std::memory_order_relaxed);
+		c.live.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+	memtrack::Stats read(const Counters &c){
+		return memtrack::Stats{c.allocs.load(), c.frees.load(), c.live.load(), c.peak.load(), c.total.load()};
+	}
+	void dump_row(std::ostream &os, const char *name, const memtrack::Stats &s){
+		os << std::setw(10) << name << std::setw(12) << s.allocs << std::setw(12) << s.frees
+			<< std::setw(14) << s.live << std::setw(14) << s.peak << std::setw(16) << s.total << "\n";
+	}
+}
+
+const char* memtrack::name(Tag tag){
+	switch (tag){
+		case Tag::ASSETS:
+			return "assets";
+		case Tag::ECS:
+			return "ecs";
+		case Tag::RENDER:
+			return "render";
+		case Tag::EVENTS:
+			return "events";
+		default:
+			return "other";
+	}
+}
+const char* memtrack::name(Gpu kind){
+	switch (kind){
+		case Gpu::BUFFER:
+			return "buffers";
+		default:
+			return "textures";
+	}
+}
+memtrack::Scope::Scope(Tag tag) : prev(current){
+	current = tag;
+}
+memtrack::Scope::~Scope(){
+	current = prev;
+}
+memtrack::Tag memtrack::current_tag(){
+	return current;
+}
+void memtrack::host_alloc(Tag tag, size_t bytes){
+	add(host_counters[static_cast<size_t>(tag)], bytes);
+	raise_peak(host_peak, host_live.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+void memtrack::host_free(Tag tag, size_t bytes){
+	remove(host_counters[static_cast<size_t>(tag)], bytes);
+	host_live.fetch_sub(bytes, std::memory_order_relaxed);
+}
+void memtrack::gpu_alloc(Gpu kind, size_t bytes){
+	add(gpu_counters[static_cast<size_t>(kind)], bytes);
+}
+void memtrack::gpu_free(Gpu kind, size_t bytes){
+	remove(gpu_counters[static_cast<size_t>(kind)], bytes);
+}
+memtrack::Stats memtrack::host(Tag tag){
+	return read(host_counters[static_cast<size_t>(tag)]);
+}
+memtrack::Stats memtrack::gpu(Gpu kind){
+	return read(gpu_counters[static_cast<size_t>(kind)]);
+}
+uint64_t memtrack::host_high_water(){
+	return host_peak.load();
+}
+void memtrack::reset_peaks(){
+	for (Counters &c : host_counters){
+		c.peak = c.live.load();
+	}
+	for (Counters &c : gpu_counters){
+		c.peak = c.live.load();
+	}
+	host_peak = host_live.load();
+}
+void memtrack::dump(std::ostream &os){
+	os << std::setw(10) << "memory" << std::setw(12) << "allocs" << std::setw(12) << "frees"
+		<< std::setw(14) << "live bytes" << std::setw(14) << "peak bytes" << std::setw(16) << "total bytes" << "\n";
+	if (TRACKING_HOST){
+		for (size_t i = 0; i < static_cast<size_t>(Tag::COUNT); ++i){
+			dump_row(os, name(static_cast<Tag>(i)), host(static_cast<Tag>(i)));
+		}
+		os << "Host high water mark: " << host_high_water() << " bytes\n";
+	}
+	else {
+		os << "Host allocations not tracked, rebuild with ASTEROIDS_MEMORY_TRACKING on\n";
+	}
+	for (size_t i = 0; i < static_cast<size_t>(Gpu::COUNT); ++i){
+		dump_row(os, name(static_cast<Gpu>(i)), gpu(static_cast<Gpu>(i)));
+	}
+}
+
+#ifdef ASTEROIDS_MEMORY_TRACKING
+namespace {
+	//Stored in front of each allocation so the free is attributed to the same
+	//tag, padded to keep the pointer handed out aligned like malloc's
+	struct alignas(alignof(std::max_align_t)) Header {
+		size_t size;
+		memtrack::Tag tag;
+	};
+	void* tracked_alloc(size_t n){
+		Header *h = static_cast<Header*>(std::malloc(n + sizeof(Header)));
+		if (!h){
+			return nullptr;
+		}
+		h->size = n;
+		h->tag = current;
+		memtrack::host_alloc(h->tag, n);
+		return h + 1;
+	}
+	void tracked_free(void *p){
+		if (!p){
+			return;
+		}
+		Header *h = static_cast<Header*>(p) - 1;
+		memtrack::host_free(h->tag, h->size);
+		std::free(h);
+	}
+}
+
+void* operator new(size_t n){
+	void *p = tracked_alloc(n);
+	if (!p){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+void* operator new[](size_t n){
+	return operator new(n);
+}
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+	return tracked_alloc(n);
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+	return tracked_alloc(n);
+}
+void operator delete(void *p) noexcept {
+	tracked_free(p);
+}
+void operator delete[](void *p) noexcept {
+	tracked_free(p);
+}
+void operator delete(void *p, const std::nothrow_t&) noexcept {
+	tracked_free(p);
+}
+void operator delete[](void *p, const std::nothrow_t&) noexcept {
+	tracked_free(p);
+}
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t) noexcept {
+	tracked_free(p);
+}
+void operator delete[](void *p, size_t) noexcept {
+	tracked_free(p);
+}
+#endif
+#endif
+
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <glm/glm.hpp>
+#include "gl_core_3_3.h"
+#include "hash.h"
+#include "util.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "obj_parser.h"
+#include "mapped_file.h"
+#include "interleavedbuffer.h"
+#include "mesh_cache.h"
+
+namespace {
+	//The layout of MeshVertex that caches must match to be uploaded as is
+	const uint32_t N_ATTRIBS = 3;
+	const mesh_cache::Attrib ATTRIBS[N_ATTRIBS] = {
+		{offsetof(MeshVertex, pos), 3, GL_FLOAT},
+		{offsetof(MeshVertex, normal), 3, GL_FLOAT},
+		{offsetof(MeshVertex, uv), 3, GL_FLOAT}
+	};
+
+	inline uint64_t align_up(uint64_t x){
+		return (x + mesh_cache::ALIGN - 1) / mesh_cache::ALIGN * mesh_cache::ALIGN;
+	}
+	void write_padding(std::ofstream &out, uint64_t to){
+		static const char zeros[mesh_cache::ALIGN] = {0};
+		const uint64_t pos = static_cast<uint64_t>(out.tellp());
+		out.write(zeros, to - pos);
+	}
+}
+
+mesh_cache::Bounds mesh_cache::compute_bounds(const MeshVertex *vertices, size_t n){
+	Bounds b{glm::vec3{0}, glm::vec3{0}, glm::vec3{0}, 0};
+	if (n == 0){
+		return b;
+	}
+	b.min = vertices[0].pos;
+	b.max = vertices[0].pos;
+	for (size_t i = 1; i < n; ++i){
+		b.min = glm::min(b.min, vertices[i].pos);
+		b.max = glm::max(b.max, vertices[i].pos);
+	}
+	b.center = (b.min + b.max) * 0.5f;
+	for (size_t i = 0; i < n; ++i){
+		b.radius = std::max(b.radius, glm::length(vertices[i].pos - b.center));
+	}
+	return b;
+}
+bool mesh_cache::write(const std::string &file, const MeshData &mesh, uint64_t source_hash){
+	TRACE_SCOPE("mesh_cache::write");
+	//Value initializing zeroes the padding too so the file contents are deterministic
+	Header header = Header();
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.source_hash = source_hash;
+	header.vertex_count = static_cast<uint32_t>(mesh.vertices.size());
+	header.index_count = static_cast<uint32_t>(mesh.indices.size());
+	header.vertex_stride = sizeof(MeshVertex);
+	header.index_size = sizeof(uint32_t);
+	header.attrib_count = N_ATTRIBS;
+	std::memcpy(header.attribs, ATTRIBS, sizeof(ATTRIBS));
+	header.bounds = compute_bounds(mesh.vertices.data(), mesh.vertices.size());
+	header.vertex_offset = align_up(sizeof(Header));
+	header.index_offset = align_up(header.vertex_offset
+		+ uint64_t{header.vertex_count} * header.vertex_stride);
+
+	//Write to a temporary file and move it into place once it's complete so
+	//a reader never maps a partly written cache
+	const std::string tmp = file + ".tmp";
+	std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+	if (!out.is_open()){
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+	write_padding(out, header.vertex_offset);
+	out.write(reinterpret_cast<const char*>(mesh.vertices.data()),
+		mesh.vertices.size() * sizeof(MeshVertex));
+	write_padding(out, header.index_offset);
+	out.write(reinterpret_cast<const char*>(mesh.indices.data()),
+		mesh.indices.size() * sizeof(uint32_t));
+	out.close();
+	if (!out){
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return util::replace_file(tmp, file);
+}
+bool mesh_cache::cook(const std::string &model, const std::string &file){
+	MappedFile source{model};
+	if (!source.good()){
+		std::cerr << "Failed to find obj file: " << model << "\n";
+		return false;
+	}
+	MeshData mesh;
+	if (!util::parse_obj(source.data(), source.size(), mesh)){
+		std::cerr << "Failed to parse obj file: " << model << "\n";
+		return false;
+	}
+	if (!write(file, mesh, util::fnv1a(source.data(), source.size()))){
+		std::cerr << "Failed to write mesh cache: " << file << "\n";
+		return false;
+	}
+	return true;
+}
+
+mesh_cache::CachedMesh::CachedMesh(const std::string &fname) : file(fname), header(), valid(false) {
+	if (!file.good() || file.size() < sizeof(Header)){
+		return;
+	}
+	std::memcpy(&header, file.data(), sizeof(Header));
+	if (header.magic != MAGIC || header.version != VERSION
+		|| header.vertex_stride != sizeof(MeshVertex) || header.index_size != sizeof(uint32_t)
+		|| header.attrib_count != N_ATTRIBS
+		|| std::memcmp(header.attribs, ATTRIBS, sizeof(ATTRIBS)) != 0
+		|| header.vertex_offset % ALIGN != 0 || header.index_offset % ALIGN != 0)
+	{
+		return;
+	}
+	//Make sure the arrays actually fit in the file before anyone reads them, the
+	//offsets are checked first so the sizes are compared to the space after them
+	//instead of adding to offsets that could wrap around
+	const uint64_t vertex_bytes = uint64_t{header.vertex_count} * header.vertex_stride;
+	const uint64_t index_bytes = uint64_t{header.index_count} * header.index_size;
+	if (header.vertex_offset < sizeof(Header) || header.vertex_offset > header.index_offset
+		|| header.index_offset > file.size()
+		|| vertex_bytes > header.index_offset - header.vertex_offset
+		|| index_bytes > file.size() - header.index_offset)
+	{
+		return;
+	}
+	//The indices go straight to the GPU, so make sure they're all in range like
+	//they are when parsing the model. A bad cache is rejected and cooked again
+	const uint32_t *idx = indices();
+	for (uint32_t i = 0; i < header.index_count; ++i){
+		if (idx[i] >= header.vertex_count){
+			return;
+		}
+	}
+	valid = true;
+}
+bool mesh_cache::CachedMesh::good() const {
+	return valid;
+}
+const mesh_cache::Header& mesh_cache::CachedMesh::info() const {
+	return header;
+}
+const MeshVertex* mesh_cache::CachedMesh::vertices() const {
+	return reinterpret_cast<const MeshVertex*>(file.data() + header.vertex_offset);
+}
+const uint32_t* mesh_cache::CachedMesh::indices() const {
+	return reinterpret_cast<const uint32_t*>(file.data() + header.index_offset);
+}
+
+bool mesh_cache::load(const std::string &model,
+	InterleavedBuffer<Layout::PACKED, glm::vec3, glm::vec3, glm::vec3> &vbo,
+	InterleavedBuffer<Layout::PACKED, GLuint> &ebo, size_t &n_elems, Bounds *bounds)
+{
+	TRACE_SCOPE("mesh_cache::load");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	assert(vbo.stride() == sizeof(MeshVertex) && ebo.stride() == sizeof(uint32_t));
+	const std::string cache = util::cache_path(model, EXTENSION);
+	MappedFile source{model};
+	const uint64_t hash = source.good() ? util::fnv1a(source.data(), source.size()) : 0;
+	{
+		const CachedMesh cached{cache};
+		if (cached.good() && (!source.good() || cached.info().source_hash == hash)){
+			const Header &h = cached.info();
+			vbo.upload(cached.vertices(), h.vertex_count);
+			ebo.upload(cached.indices(), h.index_count);
+			n_elems = h.index_count;
+			if (bounds){
+				*bounds = h.bounds;
+			}
+			return true;
+		}
+	}
+	if (!source.good()){
+		std::cerr << "Failed to find obj file: " << model << "\n";
+		return false;
+	}
+	MeshData mesh;
+	if (!util::parse_obj(source.data(), source.size(), mesh)){
+		std::cerr << "Failed to parse obj file: " << model << "\n";
+		return false;
+	}
+	//Failing to write the cache isn't fatal, we'll just parse the model again next time
+	if (!write(cache, mesh, hash)){
+		std::cerr << "Warning: failed to write mesh cache " << cache << "\n";
+	}
+	vbo.upload(mesh.vertices.data(), mesh.vertices.size());
+	ebo.upload(mesh.indices.data(), mesh.indices.size());
+	n_elems = mesh.indices.size();
+	if (bounds){
+		*bounds = compute_bounds(mesh.vertices.data(), mesh.vertices.size());
+	}
+	return true;
+}
+
@@ -4,21 +4,24 @@
 #include <string>
 #include <glm/glm.hpp>
 #include "util.h"
+#include "gl_backend.h"
 #include "layout_offset.h"
 #include "interleavedbuffer.h"
+#include "mesh_cache.h"
 #include "model.h"
 
 Model::Model(const std::string &file) : vao(0), vbo(0, GL_ARRAY_BUFFER, GL_STATIC_DRAW),
-	ebo(0, GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW), n_elems(0)
+	ebo(0, GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW), n_elems(0),
+	bounding{glm::vec3{0}, glm::vec3{0}, glm::vec3{0}, 0}
 {
-	glGenVertexArrays(1, &vao);
+	gl::backend().gen_vertex_arrays(1, &vao);
 	load(file);
 }
 Model::~Model(){
-	glDeleteVertexArrays(1, &vao);
+	gl::backend().delete_vertex_arrays(1, &vao);
 }
 Model::Model(Model &&m): vao(m.vao), vbo(std::move(m.vbo)),
-	ebo(std::move(m.ebo)), n_elems(m.n_elems)
+	ebo(std::move(m.ebo)), n_elems(m.n_elems), bounding(m.bounding)
 {
 	m.dump_model();
 }
@@ -28,30 +31,34 @@ Model& Model::operator=(Model &&m){
 		vbo = std::move(m.vbo);
 		ebo = std::move(m.ebo);
 		n_elems = m.n_elems;
+		bounding = m.bounding;
 		m.dump_model();
 	}
 	return *this;
 }
 void Model::bind(){
-	glBindVertexArray(vao);
+	gl::backend().bind_vertex_array(vao);
 }
 size_t Model::elems(){
 	return n_elems;
 }
+const mesh_cache::Bounds& Model::bounds() const {
+	return bounding;
+}
 void Model::load(const std::string &file){
-	glBindVertexArray(vao);
-	if (!util::load_obj(file, vbo, ebo, n_elems)){
+	gl::backend().bind_vertex_array(vao);
+	if (!mesh_cache::load(file, vbo, ebo, n_elems, &bounding)){
 		std::cerr << "Model " << file << " failed to load\n";
 		return;
 	}
 	vbo.bind();
 	ebo.bind();
 	for (int i = 0; i < 2; ++i){
-		glEnableVertexAttribArray(i);
-		glVertexAttribPointer(i, 3, GL_FLOAT, GL_FALSE, vbo.stride(), (void*)vbo.offset(i));
+		gl::backend().enable_vertex_attrib_array(i);
+		gl::backend().vertex_attrib_pointer(i, 3, GL_FLOAT, GL_FALSE, vbo.stride(), (void*)vbo.offset(i));
 	}
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, vbo.stride(), (void*)(vbo.offset(2)));
+	gl::backend().enable_vertex_attrib_array(2);
+	gl::backend().vertex_attrib_pointer(2, 2, GL_FLOAT, GL_FALSE, vbo.stride(), (void*)(vbo.offset(2)));
 }
 void Model::dump_model(){
 	vao = 0;
@@ -0,0 +1,70 @@
+#include <cassert>
+#include <cstddef>
+#include "cpu_features.h"
+#include "movement_kernel.h"
+
+using IntegrateFn = void (*)(float*, const float*, size_t, float, const kernel::Bounds*);
+
+static IntegrateFn variant(kernel::Isa isa){
+	switch (isa){
+		case kernel::Isa::SSE2:
+			return kernel::detail::integrate_sse2;
+		case kernel::Isa::AVX2:
+			return kernel::detail::integrate_avx2;
+		case kernel::Isa::AVX512:
+			return kernel::detail::integrate_avx512;
+		default:
+			return kernel::detail::integrate_scalar;
+	}
+}
+void kernel::integrate(float *pos, const float *vel, size_t n, float dt, const Bounds *wrap){
+	static const IntegrateFn best = variant(best_isa());
+	best(pos, vel, 2 * n, dt, wrap);
+}
+void kernel::integrate(Isa isa, float *pos, const float *vel, size_t n, float dt, const Bounds *wrap){
+	assert(supported(isa));
+	variant(isa)(pos, vel, 2 * n, dt, wrap);
+}
+bool kernel::supported(Isa isa){
+	//The SIMD variants are only built with their instruction sets enabled
+	//when targetting x86, see src/CMakeLists.txt
+	switch (isa){
+		case Isa::SCALAR:
+			return true;
+#ifdef ASTEROIDS_X86_KERNELS
+		case Isa::SSE2:
+			return cpu_features().sse2;
+		case Isa::AVX2:
+			return cpu_features().avx2;
+		case Isa::AVX512:
+			return cpu_features().avx512f;
+#endif
+		default:
+			return false;
+	}
+}
+kernel::Isa kernel::best_isa(){
+	if (supported(Isa::AVX512)){
+		return Isa::AVX512;
+	}
+	if (supported(Isa::AVX2)){
+		return Isa::AVX2;
+	}
+	if (supported(Isa::SSE2)){
+		return Isa::SSE2;
+	}
+	return Isa::SCALAR;
+}
+const char* kernel::isa_name(Isa isa){
+	switch (isa){
+		case Isa::SSE2:
+			return "SSE2";
+		case Isa::AVX2:
+			return "AVX2";
+		case Isa::AVX512:
+			return "AVX-512";
+		default:
+			return "scalar";
+	}
+}
+
@@ -0,0 +1,333 @@
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "trace.h"
+#include "memory_tracker.h"
+#include "mapped_file.h"
+#include "obj_parser.h"
+
+namespace {
+	//The powers of 10 that are exact in a double, scaling by one of these
+	//gives the correctly rounded result for mantissas of up to 2^53
+	const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+	inline bool is_space(char c){
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+	inline bool is_digit(char c){
+		return c >= '0' && c <= '9';
+	}
+	inline const char* skip_space(const char *p, const char *end){
+		while (p < end && is_space(*p)){
+			++p;
+		}
+		return p;
+	}
+	/*
+	 * Get the character i past p, reading past the end of the text as the
+	 * end of a line so the last line doesn't need a trailing newline
+	 */
+	inline char peek(const char *p, const char *end, size_t i){
+		return p + i < end ? p[i] : '\n';
+	}
+	inline const char* next_line(const char *p, const char *end){
+		const char *nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		return nl ? nl + 1 : end;
+	}
+	/*
+	 * Parse a decimal float starting at p, returns the end of the number or
+	 * p if there wasn't one. Digits past the 19th significant one are dropped
+	 */
+	const char* parse_float(const char *p, const char *end, float &out){
+		const char *start = p;
+		bool neg = false;
+		if (p < end && (*p == '-' || *p == '+')){
+			neg = *p == '-';
+			++p;
+		}
+		uint64_t mantissa = 0;
+		int exponent = 0, digits = 0;
+		bool any = false;
+		for (; p < end && is_digit(*p); ++p, any = true){
+			if (digits < 19){
+				mantissa = mantissa * 10 + (*p - '0');
+				digits += mantissa != 0;
+			}
+			else {
+				++exponent;
+			}
+		}
+		if (p < end && *p == '.'){
+			for (++p; p < end && is_digit(*p); ++p, any = true){
+				if (digits < 19){
+					mantissa = mantissa * 10 + (*p - '0');
+					digits += mantissa != 0;
+					--exponent;
+				}
+			}
+		}
+		if (!any){
+			return start;
+		}
+		if (p + 1 < end && (*p == 'e' || *p == 'E')){
+			const char *e = p + 1;
+			bool neg_exp = false;
+			if (*e == '-' || *e == '+'){
+				neg_exp = *e == '-';
+				++e;
+			}
+			if (e < end && is_digit(*e)){
+				int exp = 0;
+				for (; e < end && is_digit(*e); ++e){
+					exp = exp < 10000 ? exp * 10 + (*e - '0') : exp;
+				}
+				exponent += neg_exp ? -exp : exp;
+				p = e;
+			}
+		}
+		double value = static_cast<double>(mantissa);
+		if (exponent < 0){
+			value = exponent >= -22 ? value / POW10[-exponent] : value * std::pow(10.0, exponent);
+		}
+		else if (exponent > 0){
+			value = exponent <= 22 ? value * POW10[exponent] : value * std::pow(10.0, exponent);
+		}
+		out = static_cast<float>(neg ? -value : value);
+		return p;
+	}
+	/*
+	 * Parse a signed decimal integer starting at p, returns the end of the
+	 * number or p if there wasn't one
+	 */
+	const char* parse_int(const char *p, const char *end, int64_t &out){
+		const char *start = p;
+		bool neg = false;
+		if (p < end && (*p == '-' || *p == '+')){
+			neg = *p == '-';
+			++p;
+		}
+		const char *digits = p;
+		int64_t value = 0;
+		for (; p < end && is_digit(*p); ++p){
+			value = value < (int64_t{1} << 40) ? value * 10 + (*p - '0') : value;
+		}
+		if (p == digits){
+			return start;
+		}
+		out = neg ? -value : value;
+		return p;
+	}
+	/*
+	 * Turn a 1 based or negative relative OBJ index into a 0 based one,
+	 * returns -1 if it's out of range
+	 */
+	inline int32_t resolve(int64_t i, size_t count){
+		const int64_t n = static_cast<int64_t>(count);
+		const int64_t r = i > 0 ? i - 1 : n + i;
+		return i != 0 && r >= 0 && r < n ? static_cast<int32_t>(r) : -1;
+	}
+	/*
+	 * Open addressed hash table mapping the position, uv and normal indices
+	 * of a face vertex to the index of the merged vertex
+	 */
+	class VertexTable {
+		struct Slot {
+			//v is -1 for an empty slot
+			int32_t v, vt, vn;
+			uint32_t index;
+		};
+		std::vector<Slot> slots;
+		size_t count;
+
+	public:
+		VertexTable() : slots(1024, Slot{-1, -1, -1, 0}), count(0) {}
+		/*
+		 * Find the vertex's index, if it's not in the table it's added with
+		 * index next and inserted is set
+		 */
+		uint32_t find(int32_t v, int32_t vt, int32_t vn, uint32_t next, bool &inserted){
+			if (2 * (count + 1) > slots.size()){
+				grow();
+			}
+			const size_t mask = slots.size() - 1;
+			for (size_t i = hash(v, vt, vn) & mask;; i = (i + 1) & mask){
+				Slot &s = slots[i];
+				if (s.v == -1){
+					s = Slot{v, vt, vn, next};
+					++count;
+					inserted = true;
+					return next;
+				}
+				if (s.v == v && s.vt == vt && s.vn == vn){
+					inserted = false;
+					return s.index;
+				}
+			}
+		}
+
+	private:
+		static size_t hash(int32_t v, int32_t vt, int32_t vn){
+			uint64_t h = static_cast<uint32_t>(v) * 0x9e3779b97f4a7c15ull
+				^ static_cast<uint32_t>(vt) * 0xc2b2ae3d27d4eb4full
+				^ static_cast<uint32_t>(vn) * 0x165667b19e3779f9ull;
+			return static_cast<size_t>(h ^ (h >> 29));
+		}
+		void grow(){
+			std::vector<Slot> old(2 * slots.size(), Slot{-1, -1, -1, 0});
+			old.swap(slots);
+			const size_t mask = slots.size() - 1;
+			for (const Slot &s : old){
+				if (s.v == -1){
+					continue;
+				}
+				size_t i = hash(s.v, s.vt, s.vn) & mask;
+				while (slots[i].v != -1){
+					i = (i + 1) & mask;
+				}
+				slots[i] = s;
+			}
+		}
+	};
+}
+
+bool util::parse_obj(const char *text, size_t len, MeshData &mesh){
+	TRACE_SCOPE("util::parse_obj");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	mesh.vertices.clear();
+	mesh.indices.clear();
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> uvs;
+	//Vertices that had no normal in the file and need one computed
+	std::vector<uint32_t> missing_normals;
+	VertexTable table;
+
+	const char *p = text, *end = text + len;
+	for (size_t line = 1; p < end; ++line, p = next_line(p, end)){
+		p = skip_space(p, end);
+		//Everything but vertex data and faces (comments, groups, materials, etc.) is skipped
+		if (p >= end){
+			continue;
+		}
+		const char c1 = peek(p, end, 1), c2 = peek(p, end, 2);
+		if (p[0] == 'v' && (is_space(c1) || ((c1 == 't' || c1 == 'n') && is_space(c2)))){
+			const char type = is_space(c1) ? 'v' : c1;
+			float f[3] = {0, 0, 0};
+			//The second uv coordinate is optional
+			const int n = type == 't' ? 2 : 3, required = type == 't' ? 1 : 3;
+			const char *q = type == 'v' ? p + 1 : p + 2;
+			for (int i = 0; i < n; ++i){
+				q = skip_space(q, end);
+				const char *r = parse_float(q, end, f[i]);
+				if (r == q && i < required){
+					std::cerr << "OBJ error on line " << line << ": expected a number\n";
+					return false;
+				}
+				q = r;
+			}
+			if (type == 'v'){
+				positions.push_back(glm::vec3{f[0], f[1], f[2]});
+			}
+			else if (type == 't'){
+				uvs.push_back(glm::vec2{f[0], f[1]});
+			}
+			else {
+				normals.push_back(glm::vec3{f[0], f[1], f[2]});
+			}
+		}
+		else if (p[0] == 'f' && is_space(c1)){
+			//Triangulate the face as a fan around its first vertex
+			uint32_t first = 0, prev = 0;
+			int k = 0;
+			for (const char *q = skip_space(p + 1, end); q < end && *q != '\n' && *q != '#';
+				q = skip_space(q, end), ++k)
+			{
+				int64_t idx[3] = {0, 0, 0};
+				const char *r = parse_int(q, end, idx[0]);
+				//The uv and normal are optional: v, v/vt, v//vn or v/vt/vn, an empty
+				//index is treated the same as a missing one
+				if (r != q && r < end && *r == '/'){
+					r = parse_int(r + 1, end, idx[1]);
+					if (r < end && *r == '/'){
+						r = parse_int(r + 1, end, idx[2]);
+					}
+				}
+				const int32_t v = resolve(idx[0], positions.size());
+				const int32_t vt = idx[1] ? resolve(idx[1], uvs.size()) : -1;
+				const int32_t vn = idx[2] ? resolve(idx[2], normals.size()) : -1;
+				if (r == q || (r < end && !is_space(*r) && *r != '\n')
+					|| v < 0 || (idx[1] && vt < 0) || (idx[2] && vn < 0))
+				{
+					std::cerr << "OBJ error on line " << line << ": invalid face vertex\n";
+					return false;
+				}
+				bool inserted = false;
+				const uint32_t index = table.find(v, vt, vn, static_cast<uint32_t>(mesh.vertices.size()), inserted);
+				if (inserted){
+					mesh.vertices.push_back(MeshVertex{positions[v], vn < 0 ? glm::vec3{0} : normals[vn],
+						vt < 0 ? glm::vec3{0} : glm::vec3{uvs[vt], 0}});
+					if (vn < 0){
+						missing_normals.push_back(index);
+					}
+				}
+				if (k == 0){
+					first = index;
+				}
+				else if (k >= 2){
+					mesh.indices.push_back(first);
+					mesh.indices.push_back(prev);
+					mesh.indices.push_back(index);
+				}
+				prev = index;
+				q = r;
+			}
+			if (k < 3){
+				std::cerr << "OBJ error on line " << line << ": face with fewer than 3 vertices\n";
+				return false;
+			}
+		}
+	}
+	//Sum up the area weighted normals of the faces then normalize them for the
+	//vertices that didn't come with one
+	if (!missing_normals.empty()){
+		std::vector<bool> missing(mesh.vertices.size(), false);
+		for (uint32_t i : missing_normals){
+			missing[i] = true;
+		}
+		for (size_t i = 0; i < mesh.indices.size(); i += 3){
+			MeshVertex *tri[3] = {&mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]],
+				&mesh.vertices[mesh.indices[i + 2]]};
+			const glm::vec3 n = glm::cross(tri[1]->pos - tri[0]->pos, tri[2]->pos - tri[0]->pos);
+			for (int j = 0; j < 3; ++j){
+				if (missing[mesh.indices[i + j]]){
+					tri[j]->normal += n;
+				}
+			}
+		}
+		for (uint32_t i : missing_normals){
+			glm::vec3 &n = mesh.vertices[i].normal;
+			//Huge faces can overflow the sum to infinity, which would normalize to NaN
+			const float len = glm::length(n);
+			n = std::isfinite(len) && len > 0 ? n / len : glm::vec3{0, 0, 1};
+		}
+	}
+	return true;
+}
+bool util::read_obj(const std::string &file, MeshData &mesh){
+	MappedFile text{file};
+	if (!text.good()){
+		std::cout << "Failed to find obj file: " << file << std::endl;
+		return false;
+	}
+	if (!parse_obj(text.data(), text.size(), mesh)){
+		std::cout << "Failed to parse obj file: " << file << std::endl;
+		return false;
+	}
+	return true;
+}
+
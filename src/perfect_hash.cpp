@@ -0,0 +1,118 @@
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "hash.h"
+#include "perfect_hash.h"
+
+namespace {
+	//Average number of keys in a bucket, larger buckets make smaller seed
+	//tables but take longer to find seeds for
+	const size_t BUCKET_SIZE = 4;
+	const uint32_t MAX_SEED = 1 << 24;
+
+	//Finish the FNV hash so all of its bits affect the low ones we take mod n
+	inline uint64_t mix(uint64_t h){
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return h;
+	}
+	inline size_t bucket_of(uint64_t h, size_t n_seeds){
+		return mix(h) % n_seeds;
+	}
+	inline size_t slot_of(uint64_t h, uint32_t seed, size_t n_slots){
+		return mix(h ^ (seed * 0x9e3779b97f4a7c15ull)) % n_slots;
+	}
+}
+
+bool perfect_hash::build(const std::vector<std::string> &keys, std::vector<uint32_t> &seeds,
+	std::vector<uint32_t> &slots)
+{
+	std::unordered_map<std::string, uint32_t> unique;
+	for (size_t i = 0; i < keys.size(); ++i){
+		unique[keys[i]] = static_cast<uint32_t>(i);
+	}
+	//Hashes and key indices, sorted by index so the tables built don't depend
+	//on the map's iteration order
+	std::vector<std::pair<uint64_t, uint32_t>> hashed;
+	hashed.reserve(unique.size());
+	for (const auto &k : unique){
+		hashed.push_back(std::make_pair(util::fnv1a(k.first.data(), k.first.size()), k.second));
+	}
+	std::sort(hashed.begin(), hashed.end(),
+		[](const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b){
+			return a.second < b.second;
+		});
+	const size_t n = hashed.size();
+	seeds.assign(std::max((n + BUCKET_SIZE - 1) / BUCKET_SIZE, size_t{1}), 0);
+	slots.assign(n, 0);
+	{
+		//Keys with the same hash always land in the same slot, no seed can separate them
+		std::vector<uint64_t> sorted(n);
+		for (size_t i = 0; i < n; ++i){
+			sorted[i] = hashed[i].first;
+		}
+		std::sort(sorted.begin(), sorted.end());
+		if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()){
+			return false;
+		}
+	}
+	std::vector<std::vector<size_t>> buckets(seeds.size());
+	for (size_t i = 0; i < n; ++i){
+		buckets[bucket_of(hashed[i].first, seeds.size())].push_back(i);
+	}
+	//Place the largest buckets first while there are the most free slots
+	std::vector<size_t> order(buckets.size());
+	for (size_t i = 0; i < order.size(); ++i){
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b){
+		return buckets[a].size() > buckets[b].size();
+	});
+	std::vector<bool> taken(n, false);
+	std::vector<size_t> placed;
+	for (size_t b : order){
+		const std::vector<size_t> &bucket = buckets[b];
+		if (bucket.empty()){
+			break;
+		}
+		uint32_t seed = 1;
+		for (; seed < MAX_SEED; ++seed){
+			placed.clear();
+			for (size_t k : bucket){
+				const size_t s = slot_of(hashed[k].first, seed, n);
+				if (taken[s] || std::find(placed.begin(), placed.end(), s) != placed.end()){
+					break;
+				}
+				placed.push_back(s);
+			}
+			if (placed.size() == bucket.size()){
+				break;
+			}
+		}
+		if (seed == MAX_SEED){
+			return false;
+		}
+		seeds[b] = seed;
+		for (size_t i = 0; i < bucket.size(); ++i){
+			taken[placed[i]] = true;
+			slots[placed[i]] = hashed[bucket[i]].second;
+		}
+	}
+	return true;
+}
+size_t perfect_hash::slot(const char *key, size_t len, const uint32_t *seeds, size_t n_seeds,
+	size_t n_slots)
+{
+	assert(n_seeds > 0 && n_slots > 0);
+	const uint64_t h = util::fnv1a(key, len);
+	return slot_of(h, seeds[bucket_of(h, n_seeds)], n_slots);
+}
+
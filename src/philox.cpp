@@ -0,0 +1,52 @@
+#include <array>
+#include <cstdint>
+#include "philox.h"
+
+static const uint32_t MUL_0 = 0xD2511F53;
+static const uint32_t MUL_1 = 0xCD9E8D57;
+static const uint32_t WEYL_0 = 0x9E3779B9;
+static const uint32_t WEYL_1 = 0xBB67AE85;
+
+Philox::Philox(uint64_t seed, uint32_t stream) : seed(seed), stream(stream), counter(0), used(4) {}
+Philox::Block Philox::generate(uint64_t seed, uint32_t stream, uint64_t counter){
+	Block c{{static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), stream, 0}};
+	uint32_t k0 = static_cast<uint32_t>(seed);
+	uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+	for (int i = 0; i < 10; ++i){
+		const uint64_t p0 = static_cast<uint64_t>(MUL_0) * c[0];
+		const uint64_t p1 = static_cast<uint64_t>(MUL_1) * c[2];
+		c = Block{{static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k0, static_cast<uint32_t>(p1),
+			static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k1, static_cast<uint32_t>(p0)}};
+		k0 += WEYL_0;
+		k1 += WEYL_1;
+	}
+	return c;
+}
+uint32_t Philox::next(){
+	if (used == 4){
+		block = generate(seed, stream, counter++);
+		used = 0;
+	}
+	return block[used++];
+}
+float Philox::uniform(){
+	//The top 24 bits fit exactly in a float's mantissa
+	return (next() >> 8) * (1.f / 16777216.f);
+}
+float Philox::uniform(float a, float b){
+	return a + (b - a) * uniform();
+}
+uint32_t Philox::below(uint32_t n){
+	//Reject values from the incomplete range at the top so every result is equally likely
+	const uint32_t limit = UINT32_MAX - UINT32_MAX % n;
+	uint32_t x = next();
+	while (x >= limit){
+		x = next();
+	}
+	return x % n;
+}
+void Philox::seek(uint64_t block_counter){
+	counter = block_counter;
+	used = 4;
+}
+
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include <glm/glm.hpp>
+#include "physics.h"
+
+//Penetration allowed before position correction kicks in and the fraction corrected each step
+static const float SLOP = 0.005f;
+static const float BAUMGARTE = 0.2f;
+//Closing speed below which contacts don't bounce, keeps resting contacts from jittering
+static const float BOUNCE_THRESHOLD = 0.05f;
+
+static glm::vec2 edge_normal(const glm::vec2 &a, const glm::vec2 &b){
+	const glm::vec2 e = b - a;
+	return glm::normalize(glm::vec2{e.y, -e.x});
+}
+static void collide_circles(float ra, const glm::vec2 &pa, float rb, const glm::vec2 &pb,
+	glm::vec2 &normal, float &separation)
+{
+	const glm::vec2 d = pb - pa;
+	const float dist = glm::length(d);
+	normal = dist > 1e-6f ? d / dist : glm::vec2{1.f, 0.f};
+	separation = dist - ra - rb;
+}
+/*
+ * Polygon vs. circle, the normal points from the polygon to the circle
+ */
+static void collide_polygon_circle(const physics::Shape &poly, const glm::vec2 &pp, float r,
+	const glm::vec2 &pc, glm::vec2 &normal, float &separation)
+{
+	const glm::vec2 c = pc - pp;
+	float best = -std::numeric_limits<float>::max();
+	uint32_t face = 0;
+	for (uint32_t i = 0; i < poly.count; ++i){
+		const glm::vec2 &v1 = poly.vertices[i];
+		const glm::vec2 &v2 = poly.vertices[(i + 1) % poly.count];
+		const float s = glm::dot(edge_normal(v1, v2), c - v1);
+		if (s > best){
+			best = s;
+			face = i;
+		}
+	}
+	const glm::vec2 &v1 = poly.vertices[face];
+	const glm::vec2 &v2 = poly.vertices[(face + 1) % poly.count];
+	//The center is inside the polygon or in front of the closest face
+	normal = edge_normal(v1, v2);
+	separation = best - r;
+	if (best <= 0){
+		return;
+	}
+	//Otherwise it may be closest to one of the face's vertices
+	if (glm::dot(c - v1, v2 - v1) <= 0){
+		collide_circles(0, v1, r, c, normal, separation);
+	}
+	else if (glm::dot(c - v2, v1 - v2) <= 0){
+		collide_circles(0, v2, r, c, normal, separation);
+	}
+}
+/*
+ * Find the face of a with the largest separation from b, returns the separation
+ */
+static float max_face_separation(const physics::Shape &a, const glm::vec2 &pa,
+	const physics::Shape &b, const glm::vec2 &pb, glm::vec2 &normal)
+{
+	const glm::vec2 offset = pb - pa;
+	float best = -std::numeric_limits<float>::max();
+	for (uint32_t i = 0; i < a.count; ++i){
+		const glm::vec2 &v = a.vertices[i];
+		const glm::vec2 n = edge_normal(v, a.vertices[(i + 1) % a.count]);
+		float s = std::numeric_limits<float>::max();
+		for (uint32_t j = 0; j < b.count; ++j){
+			s = std::min(s, glm::dot(n, b.vertices[j] + offset - v));
+		}
+		if (s > best){
+			best = s;
+			normal = n;
+		}
+	}
+	return best;
+}
+
+bool physics::time_of_impact(const glm::vec2 &pa, float ra, const glm::vec2 &da,
+	const glm::vec2 &pb, float rb, const glm::vec2 &db, float &t)
+{
+	//Solve |p + d t| = r for the relative motion of b to a
+	const glm::vec2 p = pb - pa;
+	const glm::vec2 d = db - da;
+	const float r = ra + rb;
+	const float c = glm::dot(p, p) - r * r;
+	if (c <= 0){
+		t = 0;
+		return true;
+	}
+	const float a = glm::dot(d, d);
+	const float b = glm::dot(p, d);
+	//Moving apart or not moving relative to each other
+	if (b >= 0 || a <= 0){
+		return false;
+	}
+	const float disc = b * b - a * c;
+	if (disc < 0){
+		return false;
+	}
+	t = (-b - std::sqrt(disc)) / a;
+	return t <= 1;
+}
+void physics::collide(const Shape &a, const glm::vec2 &pa, const Shape &b, const glm::vec2 &pb,
+	glm::vec2 &normal, float &separation)
+{
+	if (a.count == 0 && b.count == 0){
+		collide_circles(a.radius, pa, b.radius, pb, normal, separation);
+	}
+	else if (b.count == 0){
+		collide_polygon_circle(a, pa, b.radius, pb, normal, separation);
+	}
+	else if (a.count == 0){
+		collide_polygon_circle(b, pb, a.radius, pa, normal, separation);
+		normal = -normal;
+	}
+	else {
+		glm::vec2 na, nb;
+		const float sa = max_face_separation(a, pa, b, pb, na);
+		const float sb = max_face_separation(b, pb, a, pa, nb);
+		if (sa >= sb){
+			normal = na;
+			separation = sa;
+		}
+		else {
+			normal = -nb;
+			separation = sb;
+		}
+	}
+}
+void physics::solve(Contact *contacts, size_t n, glm::vec2 *velocities, const float *inv_mass,
+	float dt, int iterations)
+{
+	//Work out the bounce for each contact from the velocities going in, only
+	//contacts that will actually close during the step bounce
+	for (size_t i = 0; i < n; ++i){
+		Contact &c = contacts[i];
+		const float vn = glm::dot(velocities[c.b] - velocities[c.a], c.normal);
+		const bool hits = vn < -BOUNCE_THRESHOLD && -vn * dt >= c.separation;
+		c.bounce = hits ? -c.bounce * vn : 0.f;
+		c.impulse = 0;
+	}
+	for (int it = 0; it < iterations; ++it){
+		for (size_t i = 0; i < n; ++i){
+			Contact &c = contacts[i];
+			const float wa = inv_mass[c.a], wb = inv_mass[c.b];
+			if (wa + wb == 0){
+				continue;
+			}
+			//Speculative contacts may close the gap this step, overlapping ones must
+			//separate and push a bit further to correct the overlap
+			float target = -c.separation / dt;
+			if (c.separation < 0){
+				target = std::max(BAUMGARTE * (-c.separation - SLOP) / dt, 0.f);
+			}
+			if (c.bounce > 0){
+				target = std::max(target, c.bounce);
+			}
+			const float vn = glm::dot(velocities[c.b] - velocities[c.a], c.normal);
+			const float total = std::max(c.impulse + (target - vn) / (wa + wb), 0.f);
+			const float delta = total - c.impulse;
+			c.impulse = total;
+			if (wa > 0){
+				velocities[c.a] -= delta * wa * c.normal;
+			}
+			if (wb > 0){
+				velocities[c.b] += delta * wb * c.normal;
+			}
+		}
+	}
+}
+
+void physics::UnionFind::reset(size_t n){
+	parent.resize(n);
+	for (size_t i = 0; i < n; ++i){
+		parent[i] = i;
+	}
+}
+uint32_t physics::UnionFind::find(uint32_t i){
+	while (parent[i] != i){
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+void physics::UnionFind::join(uint32_t a, uint32_t b){
+	a = find(a);
+	b = find(b);
+	//Keep the smaller index as the root so the islands come out the same every run
+	if (a < b){
+		parent[b] = a;
+	}
+	else if (b < a){
+		parent[a] = b;
+	}
+}
+
@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "movement_kernel.h"
+#include "projectile_pool.h"
+
+ProjectilePool::ProjectilePool(size_t capacity, float lifetime) : mask(0), head(0), count(0),
+	lifetime(lifetime), clock(0)
+{
+	size_t n = 1;
+	while (n < capacity){
+		n *= 2;
+	}
+	mask = n - 1;
+	pos.resize(n);
+	vel.resize(n);
+	expiry.resize(n);
+}
+void ProjectilePool::fire(const glm::vec2 &p, const glm::vec2 &v){
+	if (count == capacity()){
+		head = (head + 1) & mask;
+		--count;
+	}
+	const size_t s = slot(count++);
+	pos[s] = p;
+	vel[s] = v;
+	expiry[s] = clock + lifetime;
+}
+void ProjectilePool::advance(float dt, const kernel::Bounds *wrap){
+	//The live projectiles are at most two runs of slots, the one from the head
+	//to the end of the arrays and the one wrapped back around to the start
+	const size_t first = std::min(count, capacity() - head);
+	kernel::integrate(&pos[head].x, &vel[head].x, first, dt, wrap);
+	kernel::integrate(&pos[0].x, &vel[0].x, count - first, dt, wrap);
+	clock += dt;
+	while (count > 0 && expiry[head] <= clock){
+		head = (head + 1) & mask;
+		--count;
+	}
+}
+void ProjectilePool::kill(size_t i){
+	expiry[slot(i)] = clock;
+}
+bool ProjectilePool::alive(size_t i) const {
+	return expiry[slot(i)] > clock;
+}
+size_t ProjectilePool::size() const {
+	return count;
+}
+size_t ProjectilePool::capacity() const {
+	return mask + 1;
+}
+void ProjectilePool::clear(){
+	head = 0;
+	count = 0;
+}
+const glm::vec2* ProjectilePool::positions() const {
+	return pos.data();
+}
+const glm::vec2* ProjectilePool::velocities() const {
+	return vel.data();
+}
+
@@ -0,0 +1,35 @@
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "movement_kernel.h"
+#include "raycast_kernel.h"
+
+using RayCirclesFn = int32_t (*)(const glm::vec2&, const glm::vec2&, const float*, const float*,
+	const float*, size_t, float&);
+
+static RayCirclesFn variant(kernel::Isa isa){
+	switch (isa){
+		case kernel::Isa::SSE2:
+			return kernel::detail::ray_circles_sse2;
+		case kernel::Isa::AVX2:
+			return kernel::detail::ray_circles_avx2;
+		case kernel::Isa::AVX512:
+			return kernel::detail::ray_circles_avx512;
+		default:
+			return kernel::detail::ray_circles_scalar;
+	}
+}
+int32_t kernel::ray_circles(const glm::vec2 &o, const glm::vec2 &d, const float *cx, const float *cy,
+	const float *r, size_t n, float &t)
+{
+	static const RayCirclesFn best = variant(best_isa());
+	return best(o, d, cx, cy, r, n, t);
+}
+int32_t kernel::ray_circles(Isa isa, const glm::vec2 &o, const glm::vec2 &d, const float *cx,
+	const float *cy, const float *r, size_t n, float &t)
+{
+	assert(supported(isa));
+	return variant(isa)(o, d, cx, cy, r, n, t);
+}
+
@@ -0,0 +1,17 @@
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include "sim_config.h"
+
+SimConfig::SimConfig() : seed(static_cast<uint64_t>(std::time(0))), deterministic(false),
+	headless(false), tick(1.0 / 60.0), asteroids(29), field(5.f)
+{}
+SimConfig SimConfig::fixed(uint64_t seed, double tick, bool headless){
+	SimConfig config;
+	config.seed = seed;
+	config.deterministic = true;
+	config.headless = headless;
+	config.tick = tick;
+	return config;
+}
+
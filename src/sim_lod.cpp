@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "components/position.h"
+#include "components/kinematics.h"
+#include "sim_lod.h"
+
+SimLod::SimLod(const std::vector<LodBucket> &buckets, uint32_t rebucket_interval)
+	: buckets(buckets), starts(buckets.size() + 1, 0),
+	rebucket_interval(std::max(rebucket_interval, 1u)), tick(0)
+{}
+void SimLod::update(Kinematics &pool, const glm::vec2 &focus, float dt, std::vector<Range> &ranges){
+	//Entities may have been added or removed since the last rebucket, so rebucket
+	//if the pool's size changed as well
+	if (tick % rebucket_interval == 0 || starts.back() != pool.size()){
+		rebucket(pool, focus);
+	}
+	ranges.clear();
+	for (size_t b = 0; b < buckets.size(); ++b){
+		const size_t begin = starts[b], end = starts[b + 1];
+		const uint32_t period = std::max(buckets[b].period, 1u);
+		if (begin == end){
+			continue;
+		}
+		//Update one of the bucket's period slices, evenly sized so each tick does the same work
+		const size_t slice = tick % period;
+		const size_t n = end - begin;
+		const size_t s_begin = begin + n * slice / period;
+		const size_t s_end = begin + n * (slice + 1) / period;
+		if (s_begin != s_end){
+			ranges.push_back(Range{s_begin, s_end, dt * period});
+		}
+	}
+	++tick;
+}
+size_t SimLod::bucket_size(size_t b) const {
+	return starts.at(b + 1) - starts.at(b);
+}
+uint32_t SimLod::period(const Kinematics &pool, size_t i) const {
+	if (buckets.empty()){
+		return 1;
+	}
+	if (starts.back() != pool.size()){
+		uint32_t longest = 1;
+		for (const LodBucket &b : buckets){
+			longest = std::max(longest, b.period);
+		}
+		return longest;
+	}
+	size_t b = 0;
+	while (b + 1 < buckets.size() && i >= starts[b + 1]){
+		++b;
+	}
+	return std::max(buckets[b].period, 1u);
+}
+std::vector<uint64_t> SimLod::state() const {
+	std::vector<uint64_t> s{tick};
+	s.insert(s.end(), starts.begin(), starts.end());
+	return s;
+}
+bool SimLod::can_restore(const uint64_t *state, size_t n, size_t pool_size) const {
+	if (n != starts.size() + 1 || state[1] != 0 || state[n - 1] != pool_size){
+		return false;
+	}
+	for (size_t i = 2; i < n; ++i){
+		if (state[i] < state[i - 1]){
+			return false;
+		}
+	}
+	return true;
+}
+bool SimLod::restore(const uint64_t *state, size_t n, size_t pool_size){
+	if (!can_restore(state, n, pool_size)){
+		return false;
+	}
+	tick = state[0];
+	starts.assign(state + 1, state + n);
+	return true;
+}
+void SimLod::rebucket(Kinematics &pool, const glm::vec2 &focus){
+	const Position *pos = pool.data<Position>();
+	assigned.resize(pool.size());
+	for (size_t i = 0; i < pool.size(); ++i){
+		const glm::vec2 d = pos[i].pos - focus;
+		const float dist2 = glm::dot(d, d);
+		size_t b = 0;
+		while (b + 1 < buckets.size() && dist2 >= buckets[b].radius * buckets[b].radius){
+			++b;
+		}
+		assigned[i] = static_cast<uint8_t>(b);
+	}
+	//Partition the pool one bucket at a time, moving the entities in bucket b to
+	//the front of what's left. Swaps are applied to assigned as well to track them
+	size_t front = 0;
+	for (size_t b = 0; b < buckets.size(); ++b){
+		starts[b] = front;
+		for (size_t i = front; i < pool.size(); ++i){
+			if (assigned[i] == b){
+				pool.swap(front, i);
+				std::swap(assigned[front], assigned[i]);
+				++front;
+			}
+		}
+	}
+	starts[buckets.size()] = pool.size();
+}
+
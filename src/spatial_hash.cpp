@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "thread_pool.h"
+#include "spatial_hash.h"
+
+//Circles handled per task when computing cells and finding pairs
+static const size_t GRAIN = 8192;
+
+SpatialHash::SpatialHash(float min_cell) : min_cell(min_cell), cell(min_cell), shift(0), mask(0) {}
+void SpatialHash::build(const glm::vec2 *pos, const float *radius, size_t n, ThreadPool &pool){
+	float max_radius = 0;
+	for (size_t i = 0; i < n; ++i){
+		max_radius = std::max(max_radius, radius[i]);
+	}
+	cell = std::max(min_cell, 2 * max_radius);
+	//Use at least twice as many buckets as circles to keep different cells from sharing
+	//buckets, laid out as a square grid that the cells are wrapped onto
+	shift = 2;
+	while ((1u << (2 * shift)) < 2 * n){
+		++shift;
+	}
+	mask = (1u << shift) - 1;
+	const uint32_t n_buckets = 1u << (2 * shift);
+
+	buckets.resize(n);
+	pool.parallel_for(0, n, GRAIN, [&](size_t begin, size_t end){
+		for (size_t i = begin; i < end; ++i){
+			buckets[i] = bucket(cell_coord(pos[i].x), cell_coord(pos[i].y));
+		}
+	});
+	//Counting sort the circles by bucket, after the prefix sum starts[b + 1]
+	//is the end of bucket b and is moved back to its start as we scatter
+	starts.assign(n_buckets + 1, 0);
+	for (size_t i = 0; i < n; ++i){
+		++starts[buckets[i] + 1];
+	}
+	for (size_t b = 1; b < starts.size(); ++b){
+		starts[b] += starts[b - 1];
+	}
+	entries.resize(n);
+	for (size_t i = n; i-- > 0;){
+		const uint32_t b = buckets[i];
+		entries[--starts[b + 1]] = Entry{pos[i], radius[i], static_cast<uint32_t>(i),
+			cell_coord(pos[i].x), cell_coord(pos[i].y)};
+	}
+	//Scattering moved each end back to its bucket's start, shift them into place
+	for (size_t b = 0; b < n_buckets; ++b){
+		starts[b] = starts[b + 1];
+	}
+	starts[n_buckets] = n;
+}
+void SpatialHash::pairs(ThreadPool &pool, std::vector<Pair> &out) const {
+	out.clear();
+	if (entries.empty()){
+		return;
+	}
+	const size_t chunks = (entries.size() + GRAIN - 1) / GRAIN;
+	chunk_pairs.resize(std::max(chunks, chunk_pairs.size()));
+	pool.parallel_for(0, entries.size(), GRAIN, [this](size_t begin, size_t end){
+		std::vector<Pair> &found = chunk_pairs[begin / GRAIN];
+		found.clear();
+		find_pairs(begin, end, found);
+	});
+	for (size_t c = 0; c < chunks; ++c){
+		out.insert(out.end(), chunk_pairs[c].begin(), chunk_pairs[c].end());
+	}
+}
+size_t SpatialHash::size() const {
+	return entries.size();
+}
+float SpatialHash::cell_size() const {
+	return cell;
+}
+int32_t SpatialHash::cell_coord(float x) const {
+	return static_cast<int32_t>(std::floor(x / cell));
+}
+uint32_t SpatialHash::bucket(int32_t x, int32_t y) const {
+	return (static_cast<uint32_t>(x) & mask) | ((static_cast<uint32_t>(y) & mask) << shift);
+}
+bool SpatialHash::overlaps(const glm::vec2 &a, float ra, const glm::vec2 &b, float rb){
+	const glm::vec2 d = a - b;
+	return glm::dot(d, d) < (ra + rb) * (ra + rb);
+}
+void SpatialHash::find_pairs(size_t begin, size_t end, std::vector<Pair> &out) const {
+	//Only half the neighbouring cells are checked so each pair of cells is only visited
+	//once, pairs in the same cell are kept from the earlier entry
+	static const int32_t neighbours[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+	for (size_t i = begin; i < end; ++i){
+		const Entry &e = entries[i];
+		const uint32_t own = bucket(e.cx, e.cy);
+		for (uint32_t j = i + 1; j < starts[own + 1]; ++j){
+			const Entry &o = entries[j];
+			if (o.cx == e.cx && o.cy == e.cy && overlaps(e.pos, e.radius, o.pos, o.radius)){
+				out.push_back(Pair{std::min(e.index, o.index), std::max(e.index, o.index)});
+			}
+		}
+		for (const auto &n : neighbours){
+			const int32_t x = e.cx + n[0], y = e.cy + n[1];
+			const uint32_t b = bucket(x, y);
+			for (uint32_t j = starts[b]; j < starts[b + 1]; ++j){
+				const Entry &o = entries[j];
+				if (o.cx == x && o.cy == y && overlaps(e.pos, e.radius, o.pos, o.radius)){
+					out.push_back(Pair{std::min(e.index, o.index), std::max(e.index, o.index)});
+				}
+			}
+		}
+	}
+}
+
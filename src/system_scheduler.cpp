@@ -0,0 +1,64 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include <entityx/entityx.h>
+#include "thread_pool.h"
+#include "task_graph.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "system_scheduler.h"
+
+SystemAccess::SystemAccess() : main_thread(false) {}
+SystemAccess& SystemAccess::pin_main_thread(){
+	main_thread = true;
+	return *this;
+}
+bool SystemAccess::pinned() const {
+	return main_thread;
+}
+bool SystemAccess::conflicts(const SystemAccess &other) const {
+	return (writes & (other.reads | other.writes)).any()
+		|| (other.writes & (reads | writes)).any();
+}
+
+SystemScheduler::SystemScheduler(ThreadPool &pool, entityx::ptr<entityx::EntityManager> entities,
+	entityx::ptr<entityx::EventManager> events)
+	: pool(pool), entities(entities), events(events)
+{}
+void SystemScheduler::add(entityx::ptr<entityx::BaseSystem> system, const SystemAccess &access,
+	const std::string &name)
+{
+	nodes.push_back(Node{name, trace::intern(name), system, access, 0});
+}
+void SystemScheduler::update(double dt){
+	//Build the dependency graph, each system waits on the earlier ones it conflicts with
+	TaskGraph graph;
+	for (size_t i = 0; i < nodes.size(); ++i){
+		Node &node = nodes[i];
+		graph.add([this, &node, dt](){
+			TRACE_SCOPE(node.trace_name);
+			//Systems tag anything that's not ECS data themselves, eg. render buffers
+			memtrack::Scope mem_tag{memtrack::Tag::ECS};
+			auto start = std::chrono::high_resolution_clock::now();
+			node.system->update(entities, events, dt);
+			auto end = std::chrono::high_resolution_clock::now();
+			node.time = std::chrono::duration<double>(end - start).count();
+		}, node.access.pinned());
+		for (size_t j = 0; j < i; ++j){
+			if (node.access.conflicts(nodes[j].access)){
+				graph.precede(j, i);
+			}
+		}
+	}
+	graph.run(pool);
+}
+size_t SystemScheduler::size() const {
+	return nodes.size();
+}
+const std::string& SystemScheduler::name(size_t i) const {
+	return nodes.at(i).name;
+}
+double SystemScheduler::time(size_t i) const {
+	return nodes.at(i).time;
+}
+
@@ -1,35 +1,67 @@
-#include <random>
-#include <ctime>
+#include <cstdint>
 #include <vector>
+#include <memory>
+#include <tuple>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <entityx/entityx.h>
 #include "util.h"
 #include "renderbatch.h"
+#include "system_scheduler.h"
+#include "memory_tracker.h"
+#include "thread_pool.h"
+#include "philox.h"
+#include "sim_config.h"
 #include "components/position.h"
 #include "components/velocity.h"
 #include "components/appearance.h"
+#include "components/kinematics.h"
 #include "systems/asteroid_system.h"
 
-AsteroidSystem::AsteroidSystem(size_t n)
-	: render_batch(n, std::make_shared<Model>(util::get_resource_path() + "suzanne.obj")){
+//Asteroids transformed per task
+static const size_t GRAIN = 4096;
+
+AsteroidSystem::AsteroidSystem(ThreadPool &pool, size_t n, const std::shared_ptr<Kinematics> &kinematics,
+	uint64_t seed)
+	: render_batch(n, std::make_shared<Model>(util::get_resource_path() + "suzanne.obj")),
+	pool(pool), kinematics(kinematics),
+	seed(seed)
+{
 	//Everything's just gonna use the same program
 	render_batch.set_attrib_indices(std::array<int, 2>{3, 7});
 }
+SystemAccess AsteroidSystem::access(){
+	return SystemAccess{}.read<Asteroid, Position>().pin_main_thread();
+}
 void AsteroidSystem::update(entityx::ptr<entityx::EntityManager> es,
 	entityx::ptr<entityx::EventManager> events, double dt){
-	std::vector<std::tuple<glm::mat4, int>> updates;
-	std::mt19937 gen{std::time(0)};
-	std::uniform_int_distribution<int> color{0, 2};
-	size_t i = 0;
+	memtrack::Scope mem_tag{memtrack::Tag::RENDER};
+	//Find the asteroids then build their transforms and colors in parallel
+	visible.clear();
+	updates.clear();
 	for (auto entity : es->entities_with_components<Asteroid>()){
-		entityx::ptr<Position> pos = entity.component<Position>();
-		updates.push_back(std::make_tuple(glm::translate(glm::vec3{pos->pos.x, pos->pos.y, 1.f})
-			* glm::scale(glm::vec3{0.5f, 0.5f, 0.5f}), color(gen)));
-		++i;
+		if (!kinematics->has(entity.id())){
+			continue;
+		}
+		visible.push_back(entity.id());
+		updates.push_back(std::make_tuple(glm::mat4{}, 0));
 	}
-	if (i > render_batch.batch_size()){
-		render_batch.resize(i);
+	//Each task writes only its own slots so the output is in the same order
+	//no matter how the work was split
+	pool.parallel_for(0, visible.size(), GRAIN, [this](size_t begin, size_t end){
+		for (size_t i = begin; i < end; ++i){
+			const Position &pos = kinematics->get<Position>(visible[i]);
+			std::get<0>(updates[i]) = glm::translate(glm::vec3{pos.pos.x, pos.pos.y, 1.f})
+				* glm::scale(glm::vec3{0.5f, 0.5f, 0.5f});
+			//The color is a pure function of the entity so it stays the same every
+			//frame without storing it or using up a random stream
+			const Philox::Block r = Philox::generate(seed, static_cast<uint32_t>(RandomStream::ASTEROID_COLOR),
+				visible[i].index());
+			std::get<1>(updates[i]) = static_cast<int>(r[0] % 3);
+		}
+	});
+	if (updates.size() > render_batch.batch_size()){
+		render_batch.resize(updates.size());
 	}
 	render_batch.update(updates);
 	render_batch.render();
@@ -0,0 +1,46 @@
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <entityx/entityx.h>
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "system_scheduler.h"
+#include "memory_tracker.h"
+#include "events/collision_event.h"
+#include "components/position.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+#include "systems/collision_system.h"
+
+CollisionSystem::CollisionSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics,
+	const std::shared_ptr<Colliders> &colliders)
+	: pool(pool), kinematics(kinematics), colliders(colliders)
+{}
+SystemAccess CollisionSystem::access(){
+	return SystemAccess{}.read<Position, Collidable>().pin_main_thread();
+}
+void CollisionSystem::update(entityx::ptr<entityx::EntityManager>,
+	entityx::ptr<entityx::EventManager> events, double){
+	ids.clear();
+	positions.clear();
+	radii.clear();
+	const Collidable *shapes = colliders->data<Collidable>();
+	for (size_t i = 0; i < colliders->size(); ++i){
+		entityx::Entity::Id id = colliders->id(i);
+		if (kinematics->has(id)){
+			ids.push_back(id);
+			positions.push_back(kinematics->get<Position>(id).pos);
+			radii.push_back(shapes[i].radius);
+		}
+	}
+	hash.build(positions.data(), radii.data(), positions.size(), pool);
+	hash.pairs(pool, pairs);
+	memtrack::Scope mem_tag{memtrack::Tag::EVENTS};
+	for (const auto &p : pairs){
+		events->emit<CollisionEvent>(ids[p.a], ids[p.b]);
+	}
+}
+size_t CollisionSystem::collisions() const {
+	return pairs.size();
+}
+
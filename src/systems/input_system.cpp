@@ -1,19 +1,35 @@
+#include <memory>
 #include <SDL.h>
 #include <entityx/entityx.h>
+#include "components/velocity.h"
 #include "components/controllable.h"
+#include "components/kinematics.h"
 #include "events/input_event.h"
+#include "system_scheduler.h"
+#include "memory_tracker.h"
+#include "input_source.h"
 #include "systems/input_system.h"
 
+InputSystem::InputSystem(const std::shared_ptr<Kinematics> &kinematics,
+	const std::shared_ptr<InputSource> &source, const uint64_t &tick)
+	: kinematics(kinematics), source(source), tick(tick)
+{}
+SystemAccess InputSystem::access(){
+	return SystemAccess{}.read<Controllable>().write<Velocity>().pin_main_thread();
+}
 void InputSystem::update(entityx::ptr<entityx::EntityManager> es,
-	entityx::ptr<entityx::EventManager> events, double dt)
+	entityx::ptr<entityx::EventManager> events, double)
 {
 	SDL_Event e;
-	while (SDL_PollEvent(&e)){
-		events->emit<InputEvent>(e);
+	while (source->poll(tick, e)){
+		{
+			memtrack::Scope mem_tag{memtrack::Tag::EVENTS};
+			events->emit<InputEvent>(e);
+		}
 		for (auto entity : es->entities_with_components<Controllable>()){
 			entityx::ptr<Controllable> cont = entity.component<Controllable>();
-			if (cont->enabled){
-				cont->control(entity, e);
+			if (cont->enabled && kinematics->has(entity.id())){
+				cont->control(kinematics->get<Velocity>(entity.id()), e);
 			}
 		}
 	}
@@ -1,16 +1,65 @@
+#include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <entityx/entityx.h>
+#include "movement_kernel.h"
+#include "thread_pool.h"
+#include "sim_lod.h"
+#include "system_scheduler.h"
 #include "components/position.h"
 #include "components/velocity.h"
+#include "components/kinematics.h"
 #include "systems/movement_system.h"
 
-void MovementSystem::update(entityx::ptr<entityx::EntityManager> es,
-	entityx::ptr<entityx::EventManager> events, double dt){
-	for (auto entity : es->entities_with_components<Position, Velocity>()){
-		entityx::ptr<Position> pos = entity.component<Position>();
-		entityx::ptr<Velocity> vel = entity.component<Velocity>();
-		pos->pos += vel->vel * static_cast<float>(dt);
+//The kernel treats the packed components as streams of xy floats
+static_assert(sizeof(Position) == sizeof(glm::vec2) && sizeof(Velocity) == sizeof(glm::vec2),
+	"Position and Velocity must be packed vec2s for the movement kernel");
+//Entities integrated per task, large enough that the task overhead is small
+//next to the kernel but small enough to balance well on many cores
+static const size_t GRAIN = 16384;
+
+MovementSystem::MovementSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics)
+	: pool(pool), kinematics(kinematics), wrap(false), bounds{glm::vec2{0, 0}, glm::vec2{0, 0}},
+	lod_focus(0, 0)
+{}
+MovementSystem::MovementSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics,
+	const kernel::Bounds &bounds)
+	: pool(pool), kinematics(kinematics), wrap(true), bounds(bounds), lod_focus(0, 0)
+{}
+std::shared_ptr<const SimLod> MovementSystem::enable_lod(const std::vector<LodBucket> &buckets,
+	const glm::vec2 &focus, uint32_t rebucket_interval)
+{
+	lod = std::make_shared<SimLod>(buckets, rebucket_interval);
+	lod_focus = focus;
+	return lod;
+}
+const std::shared_ptr<SimLod>& MovementSystem::sim_lod() const {
+	return lod;
+}
+SystemAccess MovementSystem::access(){
+	//Velocity is written too since the LOD buckets reorder the whole pool
+	return SystemAccess{}.write<Position, Velocity>();
+}
+void MovementSystem::update(entityx::ptr<entityx::EntityManager>,
+	entityx::ptr<entityx::EventManager>, double dt){
+	//Positions and velocities are packed in the same order so we can just walk the arrays,
+	//each entity is independent so the ranges can be integrated in any order
+	float *pos = reinterpret_cast<float*>(kinematics->data<Position>());
+	const float *vel = reinterpret_cast<const float*>(kinematics->data<Velocity>());
+	const kernel::Bounds *b = wrap ? &bounds : nullptr;
+	const float step = static_cast<float>(dt);
+	if (!lod){
+		pool.parallel_for(0, kinematics->size(), GRAIN, [=](size_t begin, size_t end){
+			kernel::integrate(pos + 2 * begin, vel + 2 * begin, end - begin, step, b);
+		});
+		return;
+	}
+	lod->update(*kinematics, lod_focus, step, ranges);
+	for (const auto &r : ranges){
+		const float range_step = r.dt;
+		pool.parallel_for(r.begin, r.end, GRAIN, [=](size_t begin, size_t end){
+			kernel::integrate(pos + 2 * begin, vel + 2 * begin, end - begin, range_step, b);
+		});
 	}
 }
-
@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <entityx/entityx.h>
+#include "physics.h"
+#include "sim_lod.h"
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "system_scheduler.h"
+#include "components/position.h"
+#include "components/velocity.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+#include "components/rigid_body.h"
+#include "systems/physics_system.h"
+
+//Pairs checked and islands solved per task
+static const size_t PAIR_GRAIN = 4096;
+static const size_t ISLAND_GRAIN = 64;
+
+PhysicsSystem::PhysicsSystem(ThreadPool &pool, const std::shared_ptr<Kinematics> &kinematics,
+	const std::shared_ptr<Colliders> &colliders, const std::shared_ptr<Bodies> &bodies, int iterations)
+	: pool(pool), kinematics(kinematics), colliders(colliders), bodies(bodies), iterations(iterations)
+{}
+SystemAccess PhysicsSystem::access(){
+	return SystemAccess{}.read<Position, Collidable, RigidBody>().write<Velocity>();
+}
+void PhysicsSystem::set_lod(const std::shared_ptr<const SimLod> &l){
+	lod = l;
+}
+void PhysicsSystem::update(entityx::ptr<entityx::EntityManager>,
+	entityx::ptr<entityx::EventManager>, double dt){
+	const float step = static_cast<float>(dt);
+	if (step <= 0){
+		return;
+	}
+	gather(step);
+	find_contacts(step);
+	build_islands();
+	//Each island only writes the velocities of its own dynamic bodies
+	pool.parallel_for(0, island_count(), ISLAND_GRAIN, [this, step](size_t begin, size_t end){
+		for (size_t i = begin; i < end; ++i){
+			physics::solve(&sorted[island_starts[i]], island_starts[i + 1] - island_starts[i],
+				velocities.data(), inv_mass.data(), step, iterations);
+		}
+	});
+	for (size_t i = 0; i < ids.size(); ++i){
+		if (inv_mass[i] > 0){
+			kinematics->get<Velocity>(ids[i]).vel = velocities[i];
+		}
+	}
+}
+size_t PhysicsSystem::contact_count() const {
+	return contacts.size();
+}
+size_t PhysicsSystem::island_count() const {
+	return island_starts.empty() ? 0 : island_starts.size() - 1;
+}
+void PhysicsSystem::gather(float dt){
+	ids.clear();
+	positions.clear();
+	velocities.clear();
+	swept_centers.clear();
+	radii.clear();
+	swept_radii.clear();
+	steps.clear();
+	inv_mass.clear();
+	restitution.clear();
+	shapes.clear();
+	const RigidBody *body = bodies->data<RigidBody>();
+	for (size_t i = 0; i < bodies->size(); ++i){
+		const entityx::Entity::Id id = bodies->id(i);
+		if (!kinematics->has(id) || !colliders->has(id)){
+			continue;
+		}
+		const glm::vec2 p = kinematics->get<Position>(id).pos;
+		const glm::vec2 v = kinematics->get<Velocity>(id).vel;
+		const float r = colliders->get<Collidable>(id).radius;
+		ids.push_back(id);
+		positions.push_back(p);
+		velocities.push_back(v);
+		radii.push_back(r);
+		//The bounds of the circle swept over the step, bodies in slower LOD buckets
+		//move several ticks worth at once
+		const float step = lod ? dt * lod->period(*kinematics, kinematics->index(id)) : dt;
+		steps.push_back(step);
+		swept_centers.push_back(p + 0.5f * step * v);
+		swept_radii.push_back(r + 0.5f * step * glm::length(v));
+		inv_mass.push_back(body[i].inv_mass);
+		restitution.push_back(body[i].restitution);
+		shapes.push_back(physics::Shape{r, body[i].vertex_count, body[i].vertices});
+	}
+}
+void PhysicsSystem::find_contacts(float dt){
+	hash.build(swept_centers.data(), swept_radii.data(), swept_centers.size(), pool);
+	hash.pairs(pool, pairs);
+	//Narrowphase each pair into its slot, pairs that don't touch during the step are
+	//marked with an invalid body and dropped after
+	contacts.resize(pairs.size());
+	pool.parallel_for(0, pairs.size(), PAIR_GRAIN, [this, dt](size_t begin, size_t end){
+		for (size_t i = begin; i < end; ++i){
+			const uint32_t a = pairs[i].a, b = pairs[i].b;
+			physics::Contact &c = contacts[i];
+			c.a = UINT32_MAX;
+			if (inv_mass[a] == 0 && inv_mass[b] == 0){
+				continue;
+			}
+			const glm::vec2 da = steps[a] * velocities[a], db = steps[b] * velocities[b];
+			float t = 0;
+			if (!physics::time_of_impact(positions[a], radii[a], da, positions[b], radii[b], db, t)){
+				continue;
+			}
+			//Find the normal where the bounds first touch, the gap along it is the distance
+			//the bodies close before touching plus whatever's left between the actual shapes
+			glm::vec2 normal;
+			float separation = 0;
+			physics::collide(shapes[a], positions[a] + t * da, shapes[b], positions[b] + t * db,
+				normal, separation);
+			//The solver lets the gap close over one tick, scale it down so bodies that
+			//move several ticks at once still can't close more than the gap
+			const float closing = -glm::dot(db - da, normal) * t;
+			float gap = separation + std::max(closing, 0.f);
+			if (gap > 0){
+				gap *= dt / std::max(steps[a], steps[b]);
+			}
+			c = physics::Contact{a, b, normal, gap, std::max(restitution[a], restitution[b]), 0};
+		}
+	});
+	contacts.erase(std::remove_if(contacts.begin(), contacts.end(),
+		[](const physics::Contact &c){ return c.a == UINT32_MAX; }), contacts.end());
+}
+void PhysicsSystem::build_islands(){
+	//Static bodies don't join islands since solving never changes them
+	islands.reset(ids.size());
+	for (const auto &c : contacts){
+		if (inv_mass[c.a] > 0 && inv_mass[c.b] > 0){
+			islands.join(c.a, c.b);
+		}
+	}
+	//Number the islands in the order they first appear and counting sort the contacts
+	//by island, keeping the pair order within each island
+	island_of.assign(ids.size(), UINT32_MAX);
+	contact_island.resize(contacts.size());
+	uint32_t n_islands = 0;
+	for (size_t i = 0; i < contacts.size(); ++i){
+		const physics::Contact &c = contacts[i];
+		const uint32_t root = islands.find(inv_mass[c.a] > 0 ? c.a : c.b);
+		if (island_of[root] == UINT32_MAX){
+			island_of[root] = n_islands++;
+		}
+		contact_island[i] = island_of[root];
+	}
+	island_starts.assign(n_islands + 1, 0);
+	for (uint32_t isl : contact_island){
+		++island_starts[isl + 1];
+	}
+	for (size_t i = 1; i < island_starts.size(); ++i){
+		island_starts[i] += island_starts[i - 1];
+	}
+	island_next.assign(island_starts.begin(), island_starts.end() - 1);
+	sorted.resize(contacts.size());
+	for (size_t i = 0; i < contacts.size(); ++i){
+		sorted[island_next[contact_island[i]]++] = contacts[i];
+	}
+}
+
@@ -0,0 +1,179 @@
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <entityx/entityx.h>
+#include "util.h"
+#include "renderbatch.h"
+#include "spatial_hash.h"
+#include "thread_pool.h"
+#include "entity_pool.h"
+#include "projectile_pool.h"
+#include "movement_kernel.h"
+#include "raycast_kernel.h"
+#include "system_scheduler.h"
+#include "memory_tracker.h"
+#include "components/position.h"
+#include "components/velocity.h"
+#include "components/appearance.h"
+#include "components/controllable.h"
+#include "components/kinematics.h"
+#include "components/collidable.h"
+#include "systems/projectile_system.h"
+
+//Bullets fired per tick by each shooter, spread over a fan either side of their heading
+static const int FAN = 16;
+static const float SPREAD = 0.25f;
+static const float SPEED = 8.f;
+static const float LIFETIME = 1.5f;
+//Bullets hit tested and transformed per task
+static const size_t GRAIN = 2048;
+//With only a few asteroids it's faster to test every bullet against all of them
+//than to look up the ones nearby
+static const size_t BROADPHASE_TARGETS = 64;
+
+ProjectileSystem::ProjectileSystem(ThreadPool &pool, EntityPool &entity_pool,
+	const std::shared_ptr<Kinematics> &kinematics, const std::shared_ptr<Colliders> &colliders,
+	size_t capacity, const kernel::Bounds &bounds)
+	: bullets(capacity, LIFETIME),
+	render_batch(bullets.capacity(), std::make_shared<Model>(util::get_resource_path() + "cube.obj")),
+	pool(pool), entity_pool(entity_pool), kinematics(kinematics), colliders(colliders), bounds(bounds),
+	//The last slot is for the thread running the system, which isn't a worker
+	near_targets(pool.size() + 1)
+{
+	render_batch.set_attrib_indices(std::array<int, 2>{3, 7});
+}
+SystemAccess ProjectileSystem::access(){
+	return SystemAccess{}.read<Controllable, Asteroid, Position, Velocity, Collidable>().pin_main_thread();
+}
+void ProjectileSystem::update(entityx::ptr<entityx::EntityManager> es,
+	entityx::ptr<entityx::EventManager>, double dt){
+	const float step = static_cast<float>(dt);
+	fire(es);
+	hit_test(es, step);
+	bullets.advance(step, &bounds);
+	render();
+}
+ProjectilePool& ProjectileSystem::projectiles(){
+	return bullets;
+}
+void ProjectileSystem::fire(entityx::ptr<entityx::EntityManager> &es){
+	for (auto entity : es->entities_with_components<Controllable>()){
+		entityx::ptr<Controllable> cont = entity.component<Controllable>();
+		if (!cont->enabled || !cont->firing || !kinematics->has(entity.id())){
+			continue;
+		}
+		//Shoot the way we're moving or straight up if we're sitting still
+		const glm::vec2 p = kinematics->get<Position>(entity.id()).pos;
+		const glm::vec2 v = kinematics->get<Velocity>(entity.id()).vel;
+		const float speed = std::sqrt(v.x * v.x + v.y * v.y);
+		const glm::vec2 aim = speed > 0 ? v / speed : glm::vec2{0.f, 1.f};
+		const glm::vec2 side{aim.y, -aim.x};
+		//The fan is made by offsetting sideways from the heading instead of rotating it
+		//so there's no trig, which keeps replays the same across platforms
+		for (int i = 0; i < FAN; ++i){
+			const float s = SPREAD * (2.f * i / (FAN - 1) - 1.f);
+			const glm::vec2 dir = aim + s * side;
+			bullets.fire(p, v + SPEED * dir / std::sqrt(dir.x * dir.x + dir.y * dir.y));
+		}
+	}
+}
+void ProjectileSystem::hit_test(entityx::ptr<entityx::EntityManager> &es, float dt){
+	targets.clear();
+	target_pos.clear();
+	target_x.clear();
+	target_y.clear();
+	target_r.clear();
+	const Collidable *shapes = colliders->data<Collidable>();
+	for (size_t i = 0; i < colliders->size(); ++i){
+		const entityx::Entity::Id id = colliders->id(i);
+		if (!kinematics->has(id)){
+			continue;
+		}
+		entityx::Entity e = es->get(id);
+		if (!e.component<Asteroid>() || e.component<Controllable>()){
+			continue;
+		}
+		const glm::vec2 p = kinematics->get<Position>(id).pos;
+		targets.push_back(id);
+		target_pos.push_back(p);
+		target_x.push_back(p.x);
+		target_y.push_back(p.y);
+		target_r.push_back(shapes[i].radius);
+	}
+	hits.assign(bullets.size(), -1);
+	if (targets.empty() || bullets.size() == 0){
+		return;
+	}
+	//Asteroids aren't moved during the step since bullets are much faster
+	const bool broadphase = targets.size() > BROADPHASE_TARGETS;
+	if (broadphase){
+		hash.build(target_pos.data(), target_r.data(), targets.size(), pool);
+	}
+	pool.parallel_for(0, bullets.size(), GRAIN, [this, dt, broadphase](size_t begin, size_t end){
+		NearTargets &near = near_targets[pool.thread_index()];
+		const glm::vec2 *pos = bullets.positions();
+		const glm::vec2 *vel = bullets.velocities();
+		for (size_t i = begin; i < end; ++i){
+			if (!bullets.alive(i)){
+				continue;
+			}
+			const size_t s = bullets.slot(i);
+			const glm::vec2 d = dt * vel[s];
+			float t = 0;
+			if (!broadphase){
+				hits[i] = kernel::ray_circles(pos[s], d, target_x.data(), target_y.data(),
+					target_r.data(), targets.size(), t);
+				continue;
+			}
+			//Bound the bullet's path by a circle to find the nearby asteroids and
+			//gather them up to test against the path in one batch
+			near.ids.clear();
+			near.x.clear();
+			near.y.clear();
+			near.r.clear();
+			hash.query(pos[s] + 0.5f * d, 0.5f * std::sqrt(d.x * d.x + d.y * d.y),
+				[&](uint32_t c){
+					near.ids.push_back(c);
+					near.x.push_back(target_x[c]);
+					near.y.push_back(target_y[c]);
+					near.r.push_back(target_r[c]);
+				});
+			const int32_t hit = kernel::ray_circles(pos[s], d, near.x.data(), near.y.data(), near.r.data(),
+				near.ids.size(), t);
+			hits[i] = hit < 0 ? -1 : near.ids[hit];
+		}
+	});
+	for (size_t i = 0; i < hits.size(); ++i){
+		if (hits[i] >= 0){
+			bullets.kill(i);
+			entity_pool.despawn(targets[hits[i]]);
+		}
+	}
+}
+void ProjectileSystem::render(){
+	memtrack::Scope mem_tag{memtrack::Tag::RENDER};
+	//Killed bullets waiting to be reclaimed are drawn collapsed to a point so the
+	//batch can be filled in parallel without compacting it
+	updates.resize(bullets.size());
+	pool.parallel_for(0, bullets.size(), GRAIN, [this](size_t begin, size_t end){
+		const glm::vec2 *pos = bullets.positions();
+		for (size_t i = begin; i < end; ++i){
+			glm::mat4 m{0.f};
+			if (bullets.alive(i)){
+				const glm::vec2 &p = pos[bullets.slot(i)];
+				m = glm::translate(glm::vec3{p.x, p.y, 1.f}) * glm::scale(glm::vec3{0.04f, 0.04f, 0.04f});
+			}
+			updates[i] = std::make_tuple(m, 1);
+		}
+	});
+	render_batch.resize(updates.size());
+	if (!updates.empty()){
+		render_batch.update(updates);
+		render_batch.render();
+	}
+}
+
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "thread_pool.h"
+#include "task_graph.h"
+
+size_t TaskGraph::add(const std::function<void()> &fn, bool main_thread){
+	tasks.push_back(Task{fn, std::vector<size_t>{}, 0, main_thread});
+	return tasks.size() - 1;
+}
+void TaskGraph::precede(size_t before, size_t after){
+	assert(before < tasks.size() && after < tasks.size() && before != after);
+	tasks[before].successors.push_back(after);
+	++tasks[after].dependencies;
+}
+void TaskGraph::run(ThreadPool &pool){
+	const size_t n = tasks.size();
+	std::unique_ptr<std::atomic<size_t>[]> remaining(new std::atomic<size_t>[n]);
+	for (size_t i = 0; i < n; ++i){
+		remaining[i] = tasks[i].dependencies;
+	}
+	//Pinned tasks ready to run on this thread and the number of tasks finished
+	std::mutex main_mutex;
+	std::condition_variable main_wake;
+	std::deque<size_t> main_ready;
+	size_t done = 0;
+
+	std::function<void(size_t)> dispatch;
+	std::function<void(size_t)> execute = [&](size_t i){
+		tasks[i].fn();
+		for (size_t s : tasks[i].successors){
+			if (--remaining[s] == 0){
+				dispatch(s);
+			}
+		}
+		//Notify while holding the lock, once done reaches n run can return and
+		//destroy the condition variable
+		std::lock_guard<std::mutex> lock(main_mutex);
+		++done;
+		main_wake.notify_one();
+	};
+	dispatch = [&](size_t i){
+		if (tasks[i].main_thread){
+			std::lock_guard<std::mutex> lock(main_mutex);
+			main_ready.push_back(i);
+			main_wake.notify_one();
+		}
+		else {
+			pool.submit([&execute, i](){ execute(i); });
+		}
+	};
+	for (size_t i = 0; i < n; ++i){
+		if (tasks[i].dependencies == 0){
+			dispatch(i);
+		}
+	}
+	std::unique_lock<std::mutex> lock(main_mutex);
+	while (done < n){
+		if (!main_ready.empty()){
+			size_t i = main_ready.front();
+			main_ready.pop_front();
+			lock.unlock();
+			execute(i);
+			lock.lock();
+		}
+		else {
+			lock.unlock();
+			bool helped = pool.run_one();
+			lock.lock();
+			if (!helped){
+				main_wake.wait(lock, [&](){ return done == n || !main_ready.empty(); });
+			}
+		}
+	}
+}
+void TaskGraph::clear(){
+	tasks.clear();
+}
+size_t TaskGraph::size() const {
+	return tasks.size();
+}
+
@@ -1,38 +1,66 @@
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <string>
-#include <unordered_map>
+#include <vector>
 #include <array>
-#include <utility>
-#include <initializer_list>
 #include <SDL.h>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
-#include <tinyxml2.h>
 #include "gl_core_3_3.h"
 #include "util.h"
+#include "memory_tracker.h"
+#include "atlas_descriptor.h"
+#include "atlas_cache.h"
+#include "texture_loader.h"
 #include "texture_atlas.h"
 
-TextureAtlas::TextureAtlas(const std::string &file){
-	load(file);
+TextureAtlas::TextureAtlas(const std::string &file) : texture(0), width(0), height(0), bytes(0),
+	loader(nullptr), cached(atlas_cache::load(file))
+{
+	load(file, nullptr);
+}
+TextureAtlas::TextureAtlas(const std::string &file, TextureLoader &loader)
+	: texture(0), width(0), height(0), bytes(0), loader(&loader), cached(atlas_cache::load(file))
+{
+	load(file, &loader);
 }
 TextureAtlas::~TextureAtlas(){
+	if (loader){
+		loader->cancel(texture);
+	}
 	glDeleteTextures(1, &texture);
+	memtrack::gpu_free(memtrack::Gpu::TEXTURE, bytes);
 }
 void TextureAtlas::bind(){
 	glBindTexture(GL_TEXTURE_2D, texture);
 }
 std::array<glm::vec2, 4> TextureAtlas::uvs(const std::string &name) const {
-	auto f = images.find(name);
-	if (f == images.end()){
+	const SpriteId i = id(name);
+	if (i == INVALID_SPRITE){
 		std::array<glm::vec2, 4> arr;
 		arr.fill(glm::vec2{-1, -1});
 		return arr;
 	}
-	return f->second;
+	return images[i.index];
+}
+const std::array<glm::vec2, 4>& TextureAtlas::uvs(SpriteId id) const {
+	assert(id.index < images.size());
+	return images[id.index];
+}
+SpriteId TextureAtlas::id(const std::string &name) const {
+	const size_t i = cached.good() ? cached.find(name) : cached.size();
+	return i < images.size() ? SpriteId{static_cast<uint32_t>(i)} : INVALID_SPRITE;
+}
+std::string TextureAtlas::name(SpriteId id) const {
+	assert(id.index < images.size());
+	return cached.name(id.index);
 }
 bool TextureAtlas::has_image(const std::string &name) const {
-	return images.find(name) != images.end();
+	return id(name) != INVALID_SPRITE;
+}
+uint64_t TextureAtlas::source_hash() const {
+	return cached.info().source_hash;
 }
 TextureAtlas::const_iterator TextureAtlas::cbegin() const {
 	return images.cbegin();
@@ -43,119 +71,35 @@ TextureAtlas::const_iterator TextureAtlas::cend() const {
 size_t TextureAtlas::size() const {
 	return images.size();
 }
-void TextureAtlas::load(const std::string &file){
-	using namespace tinyxml2;
-	XMLDocument doc;
-	XMLError err = doc.LoadFile(file.c_str());
-	if (err != XML_SUCCESS){
-		std::cerr << "TextureAtlas error loading " << file << " - "
-			<< get_xml_error(err) << std::endl;
-		assert(err == XML_SUCCESS);
+void TextureAtlas::load(const std::string &file, TextureLoader *loader){
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	if (!cached.good()){
+		assert(false);
+		return;
 	}
-	XMLNode *n = doc.FirstChildElement("TextureAtlas");
-	if (n != nullptr){
-		XMLElement *e = n->ToElement();
-		if (!e->Attribute("imagePath")){
-			std::cerr << "TextureAtlas error: loading unsupported format" << std::endl;
-			assert(false);
-		}
-		std::string img_file = e->Attribute("imagePath");
-		img_file = file.substr(0, file.rfind(util::PATH_SEP) + 1) + img_file;
-		texture = util::load_texture(img_file, &width, &height);
-		load(n);
-		//Warn the user if there are any TextureAtlas elements following this one
-		//since they'll be ignored
-		if (n->NextSiblingElement("TextureAtlas")){
-			std::cerr << "TextureAtlas warning: Ignoring other TextureAtlas definitions"
-				<< " in " << file << std::endl;
-		}
+	const std::string image = file.substr(0, file.rfind(util::PATH_SEP) + 1) + cached.image();
+	if (loader){
+		const TextureLoader::Info info = loader->load(image);
+		texture = info.texture;
+		width = info.width;
+		height = info.height;
+		bytes = info.bytes;
 	}
 	else {
-		std::cerr << "TextureAtlas error: " << file << " had no xml data\n";
-		assert(false);
+		texture = util::load_texture(image, &width, &height, &bytes);
 	}
-}
-void TextureAtlas::load(tinyxml2::XMLNode *node){
-	using namespace tinyxml2;
-	//Iterate over all the subtextures in the xml document and load their positions
-	for (XMLNode *i = node->FirstChild(); i != nullptr; i = i->NextSibling()){
-		//Support both the attribute format used by Kenny.NL and TexturePacker's
-		//generic XML output
-		XMLElement *e = i->ToElement();
-		SDL_Rect r;
-		std::string name;
-		//The texture packer generic XML format
-		if (e->Attribute("n") && e->Attribute("x") && e->Attribute("y")
-			&& e->Attribute("w") && e->Attribute("h"))
-		{
-			name = e->Attribute("n");
-			r = SDL_Rect{e->IntAttribute("x"), e->IntAttribute("y"),
-				e->IntAttribute("w"), e->IntAttribute("h")};
-		}
-		//The format used by Kenny.NL
-		else if (e->Attribute("name") && e->Attribute("x") && e->Attribute("y")
-			&& e->Attribute("width") && e->Attribute("height"))
-		{
-			name = e->Attribute("name");
-			r = SDL_Rect{e->IntAttribute("x"), e->IntAttribute("y"),
-				e->IntAttribute("width"), e->IntAttribute("height")};
+	memtrack::gpu_alloc(memtrack::Gpu::TEXTURE, bytes);
+	//The cooked uvs are only good if the image is still the size it was when cooked
+	const bool cooked_uvs = width == cached.info().image_width && height == cached.info().image_height;
+	const glm::vec2 dim{width, height};
+	images.resize(cached.size());
+	for (size_t i = 0; i < cached.size(); ++i){
+		if (cooked_uvs){
+			std::copy(cached.uvs(i), cached.uvs(i) + 4, images[i].begin());
 		}
 		else {
-			std::cerr << "TextureAtlas error: loading unsupported format" << std::endl;
-			assert(false);
+			images[i] = cached.atlas_sprite(i).uvs(dim);
 		}
-		glm::vec2 dim{width, height};
-		std::array<glm::vec2, 4> arr;
-		arr[0] = glm::vec2{r.x, dim.y - r.y - r.h} / dim;
-		arr[1] = glm::vec2{r.x + r.w, dim.y - r.y - r.h} / dim;
-		arr[2] = glm::vec2{r.x, dim.y - r.y} / dim;
-		arr[3] = glm::vec2{r.x + r.w, dim.y - r.y} / dim;
-		images[name] = arr;
-	}
-}
-std::string get_xml_error(const tinyxml2::XMLError &error){
-	using namespace tinyxml2;
-	switch (error){
-		case XML_NO_ATTRIBUTE:
-			return "XML_NO_ATTRIBUTE";
-		case XML_WRONG_ATTRIBUTE_TYPE:
-			return "XML_WRONG_ATTRIBUTE_TYPE";
-		case XML_ERROR_FILE_NOT_FOUND:
-			return "XML_ERROR_FILE_NOT_FOUND";
-		case XML_ERROR_FILE_COULD_NOT_BE_OPENED:
-			return "XML_ERROR_FILE_COULD_NOT_BE_OPENED";
-		case XML_ERROR_FILE_READ_ERROR:
-			return "XML_ERROR_FILE_READ_ERROR";
-		case XML_ERROR_ELEMENT_MISMATCH:
-			return "XML_ERROR_ELEMENT_MISMATCH";
-		case XML_ERROR_PARSING_ELEMENT:
-			return "XML_ERROR_PARSING_ELEMENT";
-		case XML_ERROR_PARSING_ATTRIBUTE:
-			return "XML_ERROR_PARSING_ATTRIBUTE";
-		case XML_ERROR_IDENTIFYING_TAG:
-			return "XML_ERROR_IDENTIFYING_TAG";
-		case XML_ERROR_PARSING_TEXT:
-			return "XML_ERROR_PARSING_TEXT";
-		case XML_ERROR_PARSING_CDATA:
-			return "XML_ERROR_PARSING_CDATA";
-		case XML_ERROR_PARSING_COMMENT:
-			return "XML_ERROR_PARSING_COMMENT";
-		case XML_ERROR_PARSING_DECLARATION:
-			return "XML_ERROR_PARSING_DECLARATION";
-		case XML_ERROR_PARSING_UNKNOWN:
-			return "XML_ERROR_PARSING_UNKNOWN";
-		case XML_ERROR_EMPTY_DOCUMENT:
-			return "XML_ERROR_EMPTY_DOCUMENT";
-		case XML_ERROR_MISMATCHED_ELEMENT:
-			return "XML_ERROR_MISMATCHED_ELEMENT";
-		case XML_ERROR_PARSING:
-			return "XML_ERROR_PARSING";
-		case XML_CAN_NOT_CONVERT_TEXT:
-			return "XML_CAN_NOT_CONVERT_TEXT";
-		case XML_NO_TEXT_NODE:
-			return "XML_NO_TEXT_NODE";
-		default:
-			return "XML_SUCCESS";
 	}
 }
 
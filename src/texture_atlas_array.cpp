@@ -1,3 +1,4 @@
+#include <cassert>
 #include <iostream>
 #include <string>
 #include <unordered_map>
@@ -5,22 +6,31 @@
 #include <vector>
 #include <SDL.h>
 #include <glm/glm.hpp>
-#include <tinyxml2.h>
 #include "gl_core_3_3.h"
 #include "util.h"
-#include "texture_atlas.h"
+#include "memory_tracker.h"
+#include "atlas_descriptor.h"
+#include "atlas_cache.h"
+#include "texture_loader.h"
 #include "texture_atlas_array.h"
 
-TextureAtlasArray::TextureAtlasArray(const std::vector<std::string> &files){
+TextureAtlasArray::TextureAtlasArray(const std::vector<std::string> &files)
+	: texture(0), width(0), height(0), bytes(0), loader(nullptr)
+{
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
 	//Track all the image files we need to load into the array
 	std::vector<std::string> img_files;
 	for (size_t i = 0; i < files.size(); ++i){
 		img_files.push_back(load(files.at(i), i));
 	}
-	texture = util::load_texture_array(img_files, &width, &height);
+	texture = util::load_texture_array(img_files, &width, &height, &bytes);
+	memtrack::gpu_alloc(memtrack::Gpu::TEXTURE, bytes);
 	scale_uvs();
 }
-TextureAtlasArray::TextureAtlasArray(const std::initializer_list<std::string> &files){
+TextureAtlasArray::TextureAtlasArray(const std::initializer_list<std::string> &files)
+	: texture(0), width(0), height(0), bytes(0), loader(nullptr)
+{
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
 	//Track all the image files we need to load into the array
 	std::vector<std::string> img_files;
 	size_t i = 0;
@@ -28,11 +38,32 @@ TextureAtlasArray::TextureAtlasArray(const std::initializer_list<std::string> &f
 		img_files.push_back(load(f, i));
 		++i;
 	}
-	texture = util::load_texture_array(img_files, &width, &height);
+	texture = util::load_texture_array(img_files, &width, &height, &bytes);
+	memtrack::gpu_alloc(memtrack::Gpu::TEXTURE, bytes);
+	scale_uvs();
+}
+TextureAtlasArray::TextureAtlasArray(const std::vector<std::string> &files, TextureLoader &loader)
+	: texture(0), width(0), height(0), bytes(0), loader(&loader)
+{
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	std::vector<std::string> img_files;
+	for (size_t i = 0; i < files.size(); ++i){
+		img_files.push_back(load(files.at(i), i));
+	}
+	const TextureLoader::Info info = loader.load_array(img_files);
+	texture = info.texture;
+	width = info.width;
+	height = info.height;
+	bytes = info.bytes;
+	memtrack::gpu_alloc(memtrack::Gpu::TEXTURE, bytes);
 	scale_uvs();
 }
 TextureAtlasArray::~TextureAtlasArray(){
+	if (loader){
+		loader->cancel(texture);
+	}
 	glDeleteTextures(1, &texture);
+	memtrack::gpu_free(memtrack::Gpu::TEXTURE, bytes);
 }
 void TextureAtlasArray::bind(){
 	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
@@ -59,77 +90,24 @@ size_t TextureAtlasArray::size() const {
 	return images.size();
 }
 std::string TextureAtlasArray::load(const std::string &file, int img){
-	using namespace tinyxml2;
-	XMLDocument doc;
-	XMLError err = doc.LoadFile(file.c_str());
-	if (err != XML_SUCCESS){
-		std::cerr << "TextureAtlas error loading " << file << " - "
-			<< get_xml_error(err) << std::endl;
-		assert(err == XML_SUCCESS);
-	}
-	XMLNode *n = doc.FirstChildElement("TextureAtlas");
-	if (n != nullptr){
-		XMLElement *e = n->ToElement();
-		if (!e->Attribute("imagePath")){
-			std::cerr << "TextureAtlas error: loading unsupported format" << std::endl;
-			assert(false);
-		}
-		std::string img_file = e->Attribute("imagePath");
-		img_file = file.substr(0, file.rfind(util::PATH_SEP) + 1) + img_file;
-		load(n, img);
-		//Warn the user if there are any TextureAtlas elements following this one
-		//since they'll be ignored
-		if (n->NextSiblingElement("TextureAtlas")){
-			std::cerr << "TextureAtlas warning: Ignoring other TextureAtlas definitions"
-				<< " in " << file << std::endl;
-		}
-		//Return the image we need to load for this array entry
-		return img_file;
-	}
-	else {
-		std::cerr << "TextureAtlas error: " << file << " had no xml data\n";
+	const atlas_cache::CachedAtlas atlas = atlas_cache::load(file);
+	if (!atlas.good()){
 		assert(false);
+		return "";
 	}
-	return "";
-}
-void TextureAtlasArray::load(tinyxml2::XMLNode *node, int img){
-	using namespace tinyxml2;
-	//Iterate over all the subtextures in the xml document and load their positions
-	for (XMLNode *i = node->FirstChild(); i != nullptr; i = i->NextSibling()){
-		//Support both the attribute format used by Kenny.NL and TexturePacker's
-		//generic XML output
-		XMLElement *e = i->ToElement();
-		SDL_Rect r;
-		std::string name;
-		//The texture packer generic XML format
-		if (e->Attribute("n") && e->Attribute("x") && e->Attribute("y")
-			&& e->Attribute("w") && e->Attribute("h"))
-		{
-			name = e->Attribute("n");
-			r = SDL_Rect{e->IntAttribute("x"), e->IntAttribute("y"),
-				e->IntAttribute("w"), e->IntAttribute("h")};
-		}
-		//The format used by Kenny.NL
-		else if (e->Attribute("name") && e->Attribute("x") && e->Attribute("y")
-			&& e->Attribute("width") && e->Attribute("height"))
-		{
-			name = e->Attribute("name");
-			r = SDL_Rect{e->IntAttribute("x"), e->IntAttribute("y"),
-				e->IntAttribute("width"), e->IntAttribute("height")};
-		}
-		else {
-			std::cerr << "TextureAtlas error: loading unsupported format" << std::endl;
-			assert(false);
-		}
-		//We do the scaling & y orientation change to normalized uv coords late
-		//since at this point we don't know the image dimensions
+	//We do the scaling & y orientation change to normalized uv coords late
+	//since at this point we don't know the image dimensions
+	images.reserve(images.size() + atlas.size());
+	for (size_t i = 0; i < atlas.size(); ++i){
+		const std::array<glm::vec2, 4> corners = atlas.atlas_sprite(i).corners();
 		std::array<glm::vec3, 4> arr;
-		arr[0] = glm::vec3{r.x, r.y + r.h, img};
-		arr[1] = glm::vec3{r.x + r.w, r.y + r.h, img};
-		arr[2] = glm::vec3{r.x, r.y, img};
-		arr[3] = glm::vec3{r.x + r.w, r.y, img};
-		images[name] = arr;
+		for (int j = 0; j < 4; ++j){
+			arr[j] = glm::vec3{corners[j], img};
+		}
+		images[atlas.name(i)] = arr;
 	}
+	//Return the image we need to load for this array entry
+	return file.substr(0, file.rfind(util::PATH_SEP) + 1) + atlas.image();
 }
 void TextureAtlasArray::scale_uvs(){
 	glm::vec3 dim{width, height, 1};
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "stb_image.h"
+#include "gl_core_3_3.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "thread_pool.h"
+#include "util.h"
+#include "ktx.h"
+#include "texture_loader.h"
+
+TextureLoader::TextureLoader(ThreadPool &pool, size_t ring_size) : pool(pool), pbos(ring_size, 0),
+	next_pbo(0), decoding(0), next_request(0)
+{
+	assert(ring_size > 0);
+	glGenBuffers(pbos.size(), pbos.data());
+}
+TextureLoader::~TextureLoader(){
+	pool.wait(decoding);
+	for (Image &img : decoded){
+		stbi_image_free(img.pixels);
+	}
+	for (Image &img : staged){
+		stbi_image_free(img.pixels);
+	}
+	glDeleteBuffers(pbos.size(), pbos.data());
+}
+TextureLoader::Info TextureLoader::load(const std::string &file){
+	return request(GL_TEXTURE_2D, std::vector<std::string>{file});
+}
+TextureLoader::Info TextureLoader::load_array(const std::vector<std::string> &files){
+	return request(GL_TEXTURE_2D_ARRAY, files);
+}
+bool TextureLoader::update(size_t budget){
+	TRACE_SCOPE("TextureLoader::update");
+	//Mipmaps are made a frame after the last upload so the copies out of the
+	//pixel buffers have had a chance to finish
+	for (const std::pair<GLuint, GLenum> &m : mips){
+		glBindTexture(m.second, m.first);
+		glTexParameteri(m.second, GL_TEXTURE_MAX_LEVEL, 1000);
+		glGenerateMipmap(m.second);
+	}
+	mips.clear();
+	{
+		std::lock_guard<std::mutex> lock{decoded_mutex};
+		staged.insert(staged.end(), decoded.begin(), decoded.end());
+		decoded.clear();
+	}
+	size_t sent = 0;
+	while (!staged.empty() && (sent == 0 || sent < budget)){
+		Image img = staged.front();
+		staged.pop_front();
+		auto p = pending.find(img.texture);
+		//The texture was cancelled, maybe with its name reused by a later request
+		if (p == pending.end() || p->second.request != img.request){
+			stbi_image_free(img.pixels);
+			continue;
+		}
+		if (img.pixels){
+			upload(img);
+			sent += static_cast<size_t>(img.width) * img.height * img.channels;
+			stbi_image_free(img.pixels);
+		}
+		if (--p->second.layers_left == 0){
+			mips.push_back(std::make_pair(img.texture, p->second.target));
+			pending.erase(p);
+		}
+	}
+	return !done();
+}
+void TextureLoader::cancel(GLuint texture){
+	if (pending.erase(texture) == 0){
+		//Its images are all uploaded, but it may still be waiting on mipmaps
+		mips.erase(std::remove_if(mips.begin(), mips.end(),
+			[texture](const std::pair<GLuint, GLenum> &m){ return m.first == texture; }),
+			mips.end());
+		return;
+	}
+	auto cancelled = [texture](const Image &img){
+		if (img.texture == texture){
+			stbi_image_free(img.pixels);
+			return true;
+		}
+		return false;
+	};
+	staged.erase(std::remove_if(staged.begin(), staged.end(), cancelled), staged.end());
+	std::lock_guard<std::mutex> lock{decoded_mutex};
+	decoded.erase(std::remove_if(decoded.begin(), decoded.end(), cancelled), decoded.end());
+}
+bool TextureLoader::done(){
+	std::lock_guard<std::mutex> lock{decoded_mutex};
+	return decoding == 0 && decoded.empty() && staged.empty() && mips.empty();
+}
+void TextureLoader::finish(){
+	TRACE_SCOPE("TextureLoader::finish");
+	while (update()){
+		if (!pool.run_one()){
+			std::this_thread::yield();
+		}
+	}
+}
+TextureLoader::Info TextureLoader::request(GLenum target, const std::vector<std::string> &files){
+	TRACE_SCOPE("TextureLoader::request");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	assert(!files.empty());
+	Info info{0, 0, 0, files.size(), 0};
+	//KTX files are already in their final form with their mips, there's
+	//no decoding to move off this thread so they're just loaded here
+	if (ktx::is_ktx(files.front())){
+		info.texture = ktx::load(files, target, &info.width, &info.height, &info.bytes);
+		return info;
+	}
+	int x = 0, y = 0, n = 0;
+	for (size_t i = 0; i < files.size(); ++i){
+		int ix, iy, in;
+		if (!stbi_info(files[i].c_str(), &ix, &iy, &in)){
+			std::cerr << "Failed to load image " << files[i] << ": "
+				<< stbi_failure_reason() << std::endl;
+			return info;
+		}
+		if (i == 0){
+			x = ix;
+			y = iy;
+			n = in;
+		}
+		else if (x != ix || y != iy || n != in){
+			std::cerr << "TextureLoader error: Attempt to create array of incompatible images\n";
+			return info;
+		}
+	}
+	const GLenum format = util::image_format(n);
+	info.width = x;
+	info.height = y;
+	info.bytes = util::mip_chain_bytes(x, y, files.size(), n);
+
+	glGenTextures(1, &info.texture);
+	glBindTexture(target, info.texture);
+	if (target == GL_TEXTURE_2D){
+		glTexImage2D(target, 0, format, x, y, 0, format, GL_UNSIGNED_BYTE, nullptr);
+	}
+	else {
+		glTexImage3D(target, 0, format, x, y, files.size(), 0, format, GL_UNSIGNED_BYTE, nullptr);
+	}
+	//Only sample the base level until the mipmaps are made
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+	const uint64_t req = next_request++;
+	pending[info.texture] = Pending{req, target, files.size()};
+
+	decoding += files.size();
+	for (size_t i = 0; i < files.size(); ++i){
+		Image img{info.texture, req, target, format, x, y, n, static_cast<int>(i), files[i], nullptr};
+		pool.submit([this, img](){
+			decode(img);
+		});
+	}
+	return info;
+}
+void TextureLoader::decode(Image img){
+	TRACE_SCOPE("TextureLoader::decode");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	int x, y, n;
+	img.pixels = stbi_load(img.file.c_str(), &x, &y, &n, 0);
+	if (!img.pixels){
+		std::cerr << "Failed to load image " << img.file << ": "
+			<< stbi_failure_reason() << std::endl;
+	}
+	//The file could have changed since we read its header
+	else if (x != img.width || y != img.height || n != img.channels){
+		std::cerr << "TextureLoader error: " << img.file << " changed while loading\n";
+		stbi_image_free(img.pixels);
+		img.pixels = nullptr;
+	}
+	else {
+		util::flip_rows(img.pixels, static_cast<size_t>(x) * n, y);
+	}
+	{
+		std::lock_guard<std::mutex> lock{decoded_mutex};
+		decoded.push_back(img);
+	}
+	--decoding;
+}
+void TextureLoader::upload(Image &img){
+	TRACE_SCOPE("TextureLoader::upload");
+	const size_t size = static_cast<size_t>(img.width) * img.height * img.channels;
+	const GLuint pbo = pbos[next_pbo];
+	next_pbo = (next_pbo + 1) % pbos.size();
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+	//Orphan the buffer's old storage so we don't wait on a copy that may still be reading from it
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	void *dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (dst){
+		std::memcpy(dst, img.pixels, size);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+	}
+	else {
+		//Fall back to uploading straight from the pixels
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	const void *src = dst ? nullptr : img.pixels;
+	//Decoded rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(img.target, img.texture);
+	if (img.target == GL_TEXTURE_2D){
+		glTexSubImage2D(img.target, 0, 0, 0, img.width, img.height, img.format, GL_UNSIGNED_BYTE, src);
+	}
+	else {
+		glTexSubImage3D(img.target, 0, 0, 0, img.layer, img.width, img.height, 1, img.format,
+			GL_UNSIGNED_BYTE, src);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
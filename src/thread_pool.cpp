@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "thread_pool.h"
+#include "trace.h"
+#include "memory_tracker.h"
+
+//The pool and worker index of the current thread, if it's a worker
+static thread_local const ThreadPool *current_pool = nullptr;
+static thread_local size_t current_index = 0;
+
+ThreadPool::ThreadPool(size_t workers) : pending(0), next_queue(0), quit(false) {
+	//With no workers we still need a queue to hold tasks until someone calls run_one
+	for (size_t i = 0; i < workers || i == 0; ++i){
+		queues.emplace_back(new Queue);
+	}
+	for (size_t i = 0; i < workers; ++i){
+		threads.emplace_back(&ThreadPool::worker, this, i);
+	}
+}
+ThreadPool::~ThreadPool(){
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		quit = true;
+	}
+	wake.notify_all();
+	for (auto &t : threads){
+		t.join();
+	}
+}
+void ThreadPool::submit(Task task){
+	size_t index = thread_index();
+	if (index >= queues.size()){
+		index = next_queue++ % queues.size();
+	}
+	//Count the task before it's visible, otherwise a worker could take it and
+	//decrement pending first, wrapping it around so the pool looks busy or idle
+	//when it isn't. A worker that sees the count early just checks the queues again
+	++pending;
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	//Take the sleep lock so a worker can't miss the wake between checking pending and waiting
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+	}
+	wake.notify_one();
+}
+bool ThreadPool::run_one(){
+	Task task;
+	if (take(thread_index(), task)){
+		task();
+		return true;
+	}
+	return false;
+}
+void ThreadPool::parallel_for(size_t begin, size_t end, size_t grain,
+	const std::function<void(size_t, size_t)> &fn)
+{
+	if (begin >= end){
+		return;
+	}
+	grain = grain > 0 ? grain : 1;
+	const size_t chunks = (end - begin + grain - 1) / grain;
+	if (chunks == 1 || threads.empty()){
+		for (size_t i = begin; i < end; i += grain){
+			fn(i, std::min(i + grain, end));
+		}
+		return;
+	}
+	//Queue all but the first chunk and work on the first one ourself, the chunks
+	//allocate under the same memory tag as the caller
+	std::atomic<size_t> remaining(chunks - 1);
+	const memtrack::Tag tag = memtrack::current_tag();
+	for (size_t c = 1; c < chunks; ++c){
+		const size_t b = begin + c * grain;
+		const size_t e = std::min(b + grain, end);
+		submit([&fn, &remaining, b, e, tag](){
+			TRACE_SCOPE("parallel_for");
+			memtrack::Scope mem_tag{tag};
+			fn(b, e);
+			--remaining;
+		});
+	}
+	{
+		TRACE_SCOPE("parallel_for");
+		fn(begin, std::min(begin + grain, end));
+	}
+	wait(remaining);
+}
+void ThreadPool::wait(const std::atomic<size_t> &counter){
+	while (counter > 0){
+		if (!run_one()){
+			std::this_thread::yield();
+		}
+	}
+}
+size_t ThreadPool::size() const {
+	return threads.size();
+}
+size_t ThreadPool::thread_index() const {
+	return current_pool == this ? current_index : threads.size();
+}
+size_t ThreadPool::default_workers(){
+	size_t hw = std::thread::hardware_concurrency();
+	return hw > 1 ? hw - 1 : 0;
+}
+void ThreadPool::worker(size_t index){
+	current_pool = this;
+	current_index = index;
+	TRACE_THREAD_NAME("worker " + std::to_string(index));
+	while (true){
+		Task task;
+		if (take(index, task)){
+			task();
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake.wait(lock, [this](){ return quit || pending > 0; });
+		if (quit){
+			return;
+		}
+	}
+}
+bool ThreadPool::take(size_t index, Task &task){
+	if (pending == 0){
+		return false;
+	}
+	//Our own work is taken LIFO since it's most likely to still be in cache
+	if (index < queues.size()){
+		Queue &q = *queues[index];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.tasks.empty()){
+			task = std::move(q.tasks.back());
+			q.tasks.pop_back();
+			--pending;
+			return true;
+		}
+	}
+	//Steal the oldest work from the other queues
+	for (size_t i = 1; i <= queues.size(); ++i){
+		Queue &q = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.tasks.empty()){
+			task = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			--pending;
+			return true;
+		}
+	}
+	return false;
+}
+
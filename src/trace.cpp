@@ -0,0 +1,188 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "trace.h"
+
+namespace {
+	//Events each thread can hold between flushes, must be a power of 2
+	const uint64_t RING_SIZE = 1 << 16;
+
+	struct Event {
+		const char *name;
+		uint64_t start, end;
+	};
+	/*
+	 * A single producer single consumer ring of events. The owning thread
+	 * pushes events and the flushing thread drains them, when the ring is
+	 * full new events are dropped instead of overwriting ones the flush
+	 * may be reading
+	 */
+	struct Ring {
+		std::vector<Event> events;
+		std::atomic<uint64_t> head, tail, dropped;
+		uint32_t tid;
+		std::string name;
+		//If a thread is recording into the ring
+		bool owned;
+
+		Ring() : events(RING_SIZE), head(0), tail(0), dropped(0), tid(0), owned(false) {}
+		void push(const Event &e){
+			const uint64_t h = head.load(std::memory_order_relaxed);
+			if (h - tail.load(std::memory_order_acquire) >= RING_SIZE){
+				dropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+			events[h & (RING_SIZE - 1)] = e;
+			head.store(h + 1, std::memory_order_release);
+		}
+	};
+	/*
+	 * Every thread's ring, rings are kept after their thread exits so its
+	 * events can still be flushed and are then reused by new threads
+	 */
+	struct Registry {
+		std::mutex mutex;
+		std::vector<std::unique_ptr<Ring>> rings;
+		uint32_t next_tid = 0;
+		std::unordered_set<std::string> names;
+		std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+		std::atomic<uint32_t> every{0};
+		std::atomic<uint64_t> frame{0};
+	};
+	Registry& registry(){
+		static Registry reg;
+		return reg;
+	}
+	/*
+	 * A thread's name and the ring it records into. The ring is only taken once
+	 * the thread records an event, so threads that never record while tracing
+	 * is on don't cost one, and it's given back when the thread exits
+	 */
+	struct ThreadState {
+		Ring *ring = nullptr;
+		std::string name;
+
+		~ThreadState(){
+			if (ring){
+				std::lock_guard<std::mutex> lock(registry().mutex);
+				ring->owned = false;
+			}
+		}
+	};
+	ThreadState& thread_state(){
+		static thread_local ThreadState state;
+		return state;
+	}
+	Ring& thread_ring(){
+		ThreadState &state = thread_state();
+		if (!state.ring){
+			Registry &reg = registry();
+			std::lock_guard<std::mutex> lock(reg.mutex);
+			//Reuse the ring of a thread that's exited once its events have been flushed
+			for (auto &r : reg.rings){
+				if (!r->owned && r->head.load(std::memory_order_relaxed) == r->tail.load(std::memory_order_relaxed)){
+					state.ring = r.get();
+					break;
+				}
+			}
+			if (!state.ring){
+				reg.rings.emplace_back(new Ring);
+				state.ring = reg.rings.back().get();
+			}
+			state.ring->owned = true;
+			state.ring->tid = reg.next_tid++;
+			state.ring->name = state.name;
+		}
+		return *state.ring;
+	}
+	void write_string(std::ostream &os, const std::string &str){
+		os << '"';
+		for (char c : str){
+			if (c == '"' || c == '\\'){
+				os << '\\';
+			}
+			os << c;
+		}
+		os << '"';
+	}
+}
+
+std::atomic<bool> trace::detail::recording{false};
+
+void trace::enable(uint32_t every_n_frames){
+	registry().every = every_n_frames;
+	detail::recording = every_n_frames > 0;
+}
+void trace::disable(){
+	registry().every = 0;
+	detail::recording = false;
+}
+void trace::begin_frame(){
+	Registry &reg = registry();
+	const uint32_t every = reg.every.load(std::memory_order_relaxed);
+	const uint64_t frame = reg.frame.fetch_add(1, std::memory_order_relaxed);
+	detail::recording.store(every > 0 && frame % every == 0, std::memory_order_relaxed);
+}
+void trace::set_thread_name(const std::string &name){
+	ThreadState &state = thread_state();
+	std::lock_guard<std::mutex> lock(registry().mutex);
+	state.name = name;
+	if (state.ring){
+		state.ring->name = name;
+	}
+}
+const char* trace::intern(const std::string &name){
+	Registry &reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	return reg.names.insert(name).first->c_str();
+}
+uint64_t trace::now(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - registry().epoch).count();
+}
+void trace::record(const char *name, uint64_t start, uint64_t end){
+	thread_ring().push(Event{name, start, end});
+}
+bool trace::flush(const std::string &file){
+	std::ofstream out(file);
+	if (!out){
+		return false;
+	}
+	Registry &reg = registry();
+	std::lock_guard<std::mutex> lock(reg.mutex);
+	//Times are written in microseconds with the nanoseconds after the decimal point
+	out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+	bool first = true;
+	uint64_t dropped = 0;
+	for (auto &r : reg.rings){
+		Ring &ring = *r;
+		if (!ring.name.empty()){
+			out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+				<< ring.tid << ",\"args\":{\"name\":";
+			write_string(out, ring.name);
+			out << "}}";
+			first = false;
+		}
+		const uint64_t h = ring.head.load(std::memory_order_acquire);
+		for (uint64_t t = ring.tail.load(std::memory_order_relaxed); t < h; ++t){
+			const Event &e = ring.events[t & (RING_SIZE - 1)];
+			out << (first ? "" : ",\n") << "{\"name\":";
+			write_string(out, e.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.tid
+				<< ",\"ts\":" << e.start / 1000.0 << ",\"dur\":" << (e.end - e.start) / 1000.0 << "}";
+			first = false;
+		}
+		ring.tail.store(h, std::memory_order_release);
+		dropped += ring.dropped.exchange(0, std::memory_order_relaxed);
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+	return static_cast<bool>(out);
+}
+
@@ -1,7 +1,7 @@
 #include <vector>
-#include <regex>
-#include <array>
-#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <iomanip>
 #include <fstream>
@@ -10,10 +10,43 @@
 #include <glm/glm.hpp>
 #include <SDL.h>
 #define STB_IMAGE_IMPLEMENTATION
+//Images are decoded on worker threads, so stbi_failure_reason has to be per
+//thread to report the right error
+#define STBI_THREAD_LOCAL thread_local
 #include "stb_image.h"
 #include "gl_core_3_3.h"
+#include "trace.h"
+#include "memory_tracker.h"
+#include "obj_parser.h"
+#include "mapped_file.h"
+#include "ktx.h"
 #include "util.h"
 
+namespace {
+	/*
+	 * Decode an image that's expected to be x by y with n channels and flip it
+	 * for OpenGL, returns null if it couldn't be read or has a different size
+	 */
+	unsigned char* decode_layer(const std::string &file, int x, int y, int n){
+		TRACE_SCOPE("util::decode_layer");
+		int ix, iy, in;
+		unsigned char *img = stbi_load(file.c_str(), &ix, &iy, &in, 0);
+		if (!img){
+			std::cerr << "Failed to load image " << file << ": "
+				<< stbi_failure_reason() << std::endl;
+			return nullptr;
+		}
+		//The file could have changed since we read its header
+		if (x != ix || y != iy || n != in){
+			std::cerr << "load_texture_array error: " << file << " changed while loading\n";
+			stbi_image_free(img);
+			return nullptr;
+		}
+		util::flip_rows(img, static_cast<size_t>(x) * n, y);
+		return img;
+	}
+}
+
 std::string util::get_resource_path(const std::string &sub_dir){
 	static std::string base_res;
 	if (base_res.empty()){
@@ -44,6 +77,28 @@ std::string util::read_file(const std::string &fName){
 	return std::string((std::istreambuf_iterator<char>(file)),
 		std::istreambuf_iterator<char>());
 }
+std::string util::cache_path(const std::string &file, const std::string &ext){
+	const size_t dot = file.find_last_of('.');
+	const size_t slash = file.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)){
+		return file + ext;
+	}
+	return file.substr(0, dot) + ext;
+}
+bool util::replace_file(const std::string &tmp, const std::string &file){
+	if (std::rename(tmp.c_str(), file.c_str()) == 0){
+		return true;
+	}
+#ifdef _WIN32
+	//Windows won't rename over an existing file
+	std::remove(file.c_str());
+	if (std::rename(tmp.c_str(), file.c_str()) == 0){
+		return true;
+	}
+#endif
+	std::remove(tmp.c_str());
+	return false;
+}
 GLint util::load_shader(GLenum type, const std::string &file){
 	GLuint shader = glCreateShader(type);
 	std::string src = read_file(file);
@@ -81,6 +136,8 @@ GLint util::load_shader(GLenum type, const std::string &file){
 	return shader;
 }
 GLint util::load_program(const std::vector<std::tuple<GLenum, std::string>> &shaders){
+	TRACE_SCOPE("util::load_program");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
 	std::vector<GLuint> glshaders;
 	for (const std::tuple<GLenum, std::string> &s : shaders){
 		GLint h = load_shader(std::get<0>(s), std::get<1>(s));
@@ -119,14 +176,64 @@ GLint util::load_program(const std::vector<std::tuple<GLenum, std::string>> &sha
 	}
 	return program;
 }
-//Swap rows of n bytes pointed to by a with those pointed to by b
-//for use in doing the y-flip for images so OpenGL has them right-side up
-void swap_row(unsigned char *a, unsigned char *b, size_t n){
-	for (size_t i = 0; i < n; ++i){
-		std::swap(a[i], b[i]);
+void util::flip_rows(unsigned char *img, size_t row_bytes, size_t rows){
+	std::vector<unsigned char> tmp(row_bytes);
+	for (size_t i = 0; i < rows / 2; ++i){
+		unsigned char *a = img + i * row_bytes;
+		unsigned char *b = img + (rows - i - 1) * row_bytes;
+		std::memcpy(tmp.data(), a, row_bytes);
+		std::memcpy(a, b, row_bytes);
+		std::memcpy(b, tmp.data(), row_bytes);
 	}
 }
-GLuint util::load_texture(const std::string &file, size_t *width, size_t *height){
+size_t util::mip_chain_bytes(size_t w, size_t h, size_t layers, size_t n){
+	size_t bytes = 0;
+	while (true){
+		bytes += w * h * layers * n;
+		if (w == 1 && h == 1){
+			return bytes;
+		}
+		w = std::max(w / 2, size_t{1});
+		h = std::max(h / 2, size_t{1});
+	}
+}
+GLenum util::image_format(int channels){
+	switch (channels){
+		case 1:
+			return GL_RED;
+		case 2:
+			return GL_RG;
+		case 3:
+			return GL_RGB;
+		default:
+			return GL_RGBA;
+	}
+}
+bool util::image_size(const std::string &file, size_t &width, size_t &height){
+	if (ktx::is_ktx(file)){
+		MappedFile mapped{file};
+		ktx::Image img;
+		if (!mapped.good() || !ktx::parse(mapped.data(), mapped.size(), img)){
+			return false;
+		}
+		width = img.width;
+		height = img.height;
+		return true;
+	}
+	int x, y, n;
+	if (!stbi_info(file.c_str(), &x, &y, &n)){
+		return false;
+	}
+	width = x;
+	height = y;
+	return true;
+}
+GLuint util::load_texture(const std::string &file, size_t *width, size_t *height, size_t *bytes){
+	TRACE_SCOPE("util::load_texture");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	if (ktx::is_ktx(file)){
+		return ktx::load(std::vector<std::string>{file}, GL_TEXTURE_2D, width, height, bytes);
+	}
 	int x, y, n;
 	unsigned char *img = stbi_load(file.c_str(), &x, &y, &n, 0);
 	if (!img){
@@ -140,24 +247,11 @@ GLuint util::load_texture(const std::string &file, size_t *width, size_t *height
 	if (height){
 		*height = y;
 	}
-	GLenum format;
-	switch (n){
-		case 1:
-			format = GL_RED;
-			break;
-		case 2:
-			format = GL_RG;
-			break;
-		case 3:
-			format = GL_RGB;
-			break;
-		case 4:
-			format = GL_RGBA;
-			break;
-	}
-	for (int i = 0; i < y / 2; ++i){
-		swap_row(&img[i * x * n], &img[(y - i - 1) * x * n], x * n);
+	if (bytes){
+		*bytes = mip_chain_bytes(x, y, 1, n);
 	}
+	const GLenum format = image_format(n);
+	flip_rows(img, static_cast<size_t>(x) * n, y);
 
 	GLuint tex;
 	glGenTextures(1, &tex);
@@ -167,64 +261,65 @@ GLuint util::load_texture(const std::string &file, size_t *width, size_t *height
 	stbi_image_free(img);
 	return tex;
 }
-GLuint util::load_texture_array(const std::vector<std::string> &files, size_t *w, size_t *h){
+GLuint util::load_texture_array(const std::vector<std::string> &files, size_t *w, size_t *h,
+	size_t *bytes)
+{
+	TRACE_SCOPE("util::load_texture_array");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
 	assert(!files.empty());
-	int x, y, n;
-	std::vector<unsigned char*> images;
-	//We need to load the first image to get the dimensions and format we're loading
-	images.push_back(stbi_load(files.front().c_str(), &x, &y, &n, 0));
-	if (w){
-		*w = x;
-	}
-	if (h){
-		*h = y;
+	if (ktx::is_ktx(files.front())){
+		return ktx::load(files, GL_TEXTURE_2D_ARRAY, w, h, bytes);
 	}
-	for (auto it = ++files.begin(); it != files.end(); ++it){
+	//Read the headers to size the array and check the images are compatible
+	//before decoding anything
+	int x = 0, y = 0, n = 0;
+	for (size_t i = 0; i < files.size(); ++i){
 		int ix, iy, in;
-		images.push_back(stbi_load(it->c_str(), &ix, &iy, &in, 0));
-		if (x != ix || y != iy || n != in){
+		if (!stbi_info(files[i].c_str(), &ix, &iy, &in)){
+			std::cerr << "Failed to load image " << files[i] << ": "
+				<< stbi_failure_reason() << std::endl;
+			return 0;
+		}
+		if (i == 0){
+			x = ix;
+			y = iy;
+			n = in;
+		}
+		else if (x != ix || y != iy || n != in){
 			std::cerr << "load_texture_array error: Attempt to create array of incompatible images\n";
-			for (auto i : images){
-				stbi_image_free(i);
-			}
 			return 0;
 		}
 	}
-	//Perform y-swap on each loaded image
-	for (auto img : images){
-		for (int i = 0; i < y / 2; ++i){
-			swap_row(&img[i * x * n], &img[(y - i - 1) * x * n], x * n);
-		}
+	if (w){
+		*w = x;
 	}
-	GLenum format;
-	switch (n){
-		case 1:
-			format = GL_RED;
-			break;
-		case 2:
-			format = GL_RG;
-			break;
-		case 3:
-			format = GL_RGB;
-			break;
-		case 4:
-			format = GL_RGBA;
-			break;
+	if (h){
+		*h = y;
+	}
+	if (bytes){
+		*bytes = mip_chain_bytes(x, y, files.size(), n);
 	}
+	const GLenum format = image_format(n);
 
 	GLuint tex;
 	glGenTextures(1, &tex);
 	glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
-	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, x, y, images.size(), 0, format, GL_UNSIGNED_BYTE, NULL);
-	//Upload all the textures in the array
-	for (size_t i = 0; i < images.size(); ++i){
-		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, x, y, 1, format, GL_UNSIGNED_BYTE, images.at(i));
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, x, y, files.size(), 0, format, GL_UNSIGNED_BYTE, NULL);
+	//Decoded rows are tightly packed
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	//Layers are decoded and uploaded one at a time so only one is held in memory
+	for (size_t i = 0; i < files.size(); ++i){
+		unsigned char *layer = decode_layer(files[i], x, y, n);
+		if (!layer){
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			glDeleteTextures(1, &tex);
+			return 0;
+		}
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, x, y, 1, format, GL_UNSIGNED_BYTE, layer);
+		stbi_image_free(layer);
 	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 	glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
-	//Clean up all the image data
-	for (auto i : images){
-		stbi_image_free(i);
-	}
 	return tex;
 }
 bool util::log_glerror(const std::string &msg){
@@ -321,109 +416,18 @@ void util::gldebug_callback(GLenum src, GLenum type, GLuint id, GLenum severity,
 }
 bool util::load_obj(const std::string &fname,
 	InterleavedBuffer<Layout::PACKED, glm::vec3, glm::vec3, glm::vec3> &vbo,
-	InterleavedBuffer<Layout::PACKED, GLushort> &ebo, size_t &n_elems)
+	InterleavedBuffer<Layout::PACKED, GLuint> &ebo, size_t &n_elems)
 {
-	std::ifstream file(fname);
-	if (!file.is_open()){
-		std::cout << "Failed to find obj file: " << fname << std::endl;
+	TRACE_SCOPE("util::load_obj");
+	memtrack::Scope mem_tag{memtrack::Tag::ASSETS};
+	MeshData mesh;
+	if (!read_obj(fname, mesh)){
 		return false;
 	}
-	//Temporary storage for the data we read in
-	std::vector<glm::vec3> tmp_pos, tmp_norm;
-	std::vector<glm::vec2> tmp_uv;
-	//A map to associate a unique vertex with its index
-	std::map<std::string, GLushort> vert_indices;
-	//The final ordered packed vertices and indices
-	std::vector<glm::vec3> vert_data;
-	std::vector<GLushort> indices;
-
-	std::string line;
-	while (std::getline(file, line)){
-		if (line.empty()){
-			continue;
-		}
-		//Parse vertex info: positions, uv coords and normals
-		else if (line.at(0) == 'v'){
-			//positions
-			if (line.at(1) == ' '){
-				tmp_pos.push_back(capture_vec3(line));
-			}
-			else if (line.at(1) == 't'){
-				tmp_uv.push_back(capture_vec2(line));
-			}
-			else if (line.at(1) == 'n'){
-				tmp_norm.push_back(capture_vec3(line));
-			}
-		}
-		//Parse faces
-		else if (line.at(0) == 'f'){
-			std::vector<std::string> face = capture_faces(line);
-			//Triangulate quad faces
-			if (face.size() == 4){
-				face.push_back(face.at(0));
-				face.push_back(face.at(2));
-			}
-			for (std::string &v : face){
-				auto fnd = vert_indices.find(v);
-				//If we find the vertex already in the list re-use the index
-				//If not we create a new vertex and index
-				if (fnd != vert_indices.end()){
-					indices.push_back(fnd->second);
-				}
-				else {
-					std::array<unsigned int, 3> vertex = capture_vertex(v);
-					//Pack the position, normal and uv into the vertex data, note that obj data is
-					//1-indexed so we subtract 1
-					vert_data.push_back(tmp_pos[vertex[0] - 1]);
-					vert_data.push_back(tmp_norm[vertex[2] - 1]);
-					vert_data.push_back(glm::vec3(tmp_uv[vertex[1] - 1], 0));
-					//Store the new index, also subract 1 b/c size 1 => idx 0
-					//and divide by 3 b/c there are 3 components per vertex
-					indices.push_back((vert_data.size() - 1) / 3);
-					vert_indices[v] = indices.back();
-				}
-			}
-		}
-	}
-	vbo.reserve(vert_data.size() / 3);
-	vbo.map(GL_WRITE_ONLY);
-	for (size_t i = 0; i < vert_data.size() / 3; ++i){
-		vbo.write<0>(i) = vert_data[3 * i];
-		vbo.write<1>(i) = vert_data[3 * i + 1];
-		vbo.write<2>(i) = vert_data[3 * i + 2];
-	}
-	vbo.unmap();
-	n_elems = indices.size();
-	ebo.reserve(n_elems);
-	ebo.map(GL_WRITE_ONLY);
-	for (size_t i = 0; i < indices.size(); ++i){
-		ebo.write<0>(i) = indices[i];
-	}
-	ebo.unmap();
+	//MeshVertex has the same layout as the vbo's blocks so the data can go straight up
+	vbo.upload(mesh.vertices.data(), mesh.vertices.size());
+	n_elems = mesh.indices.size();
+	ebo.upload(mesh.indices.data(), n_elems);
 	return true;
 }
-glm::vec2 util::capture_vec2(const std::string &str){
-	glm::vec2 vec;
-	sscanf(str.c_str(), "%*s %f %f", &vec.x, &vec.y);
-	return vec;
-}
-glm::vec3 util::capture_vec3(const std::string &str){
-	glm::vec3 vec;
-	sscanf(str.c_str(), "%*s %f %f %f", &vec.x, &vec.y, &vec.z);
-	return vec;
-}
-std::vector<std::string> util::capture_faces(const std::string &str){
-	std::regex match_vert("([0-9]+)/([0-9]+)/([0-9]+)");
-	std::vector<std::string> faces;
-	std::transform(std::sregex_iterator{str.begin(), str.end(), match_vert},
-		std::sregex_iterator{}, std::back_inserter(faces),
-		[](const std::smatch &m){
-			return m.str();
-		});
-	return faces;
-}
-std::array<unsigned int, 3> util::capture_vertex(const std::string &str){
-	std::array<unsigned int, 3> vertex;
-	sscanf(str.c_str(), "%u/%u/%u", &vertex[0], &vertex[1], &vertex[2]);
-	return vertex;
-}
+
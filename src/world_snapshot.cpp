@@ -0,0 +1,97 @@
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "world_snapshot.h"
+
+//Block data is padded out to a multiple of this many bytes
+static const size_t ALIGN = 8;
+
+snapshot::Writer::Writer(const std::string &file, uint64_t tick) : out(file, std::ios::binary) {
+	header = Header{MAGIC, VERSION, 0, 0, tick};
+	//The header is rewritten with the real block count by finish
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	if (!out){
+		std::cerr << "snapshot::Writer: failed to open " << file << " for writing\n";
+	}
+}
+void snapshot::Writer::block(uint32_t tag, const void *data, uint32_t elem_size, uint64_t count){
+	BlockHeader b{tag, elem_size, count};
+	out.write(reinterpret_cast<const char*>(&b), sizeof(b));
+	const size_t bytes = elem_size * count;
+	out.write(static_cast<const char*>(data), bytes);
+	static const char padding[ALIGN] = {0};
+	out.write(padding, (ALIGN - bytes % ALIGN) % ALIGN);
+	++header.blocks;
+}
+bool snapshot::Writer::finish(){
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.flush();
+	return out.good();
+}
+
+snapshot::Reader::Reader(const std::string &file) : loaded(false) {
+	std::memset(&header, 0, sizeof(header));
+	std::ifstream in(file, std::ios::binary | std::ios::ate);
+	if (!in){
+		std::cerr << "snapshot::Reader: failed to open " << file << "\n";
+		return;
+	}
+	const size_t size = in.tellg();
+	in.seekg(0);
+	//The file is read straight into uninitialized storage to skip zeroing it first
+	storage.reset(new uint64_t[(size + ALIGN - 1) / ALIGN]);
+	char *bytes = reinterpret_cast<char*>(storage.get());
+	if (size < sizeof(Header) || !in.read(bytes, size)){
+		std::cerr << "snapshot::Reader: failed to read " << file << "\n";
+		return;
+	}
+	std::memcpy(&header, bytes, sizeof(header));
+	if (header.magic != MAGIC || header.version != VERSION){
+		std::cerr << "snapshot::Reader: " << file << " is not a version " << VERSION << " snapshot\n";
+		return;
+	}
+	size_t offset = sizeof(Header);
+	for (uint32_t i = 0; i < header.blocks; ++i){
+		Block b;
+		if (offset + sizeof(BlockHeader) > size){
+			std::cerr << "snapshot::Reader: " << file << " is truncated\n";
+			return;
+		}
+		std::memcpy(&b.header, bytes + offset, sizeof(BlockHeader));
+		offset += sizeof(BlockHeader);
+		//Check the count against the bytes left before multiplying so a bad count can't overflow
+		if (b.header.elem_size != 0 && b.header.count > (size - offset) / b.header.elem_size){
+			std::cerr << "snapshot::Reader: " << file << " is truncated\n";
+			return;
+		}
+		const size_t len = b.header.elem_size * b.header.count;
+		b.data = bytes + offset;
+		blocks.push_back(b);
+		offset += len + (ALIGN - len % ALIGN) % ALIGN;
+	}
+	loaded = true;
+}
+bool snapshot::Reader::good() const {
+	return loaded;
+}
+uint64_t snapshot::Reader::tick() const {
+	return header.tick;
+}
+const void* snapshot::Reader::block(uint32_t tag, uint32_t elem_size, uint64_t &count) const {
+	for (const auto &b : blocks){
+		if (b.header.tag == tag){
+			if (b.header.elem_size != elem_size){
+				return nullptr;
+			}
+			count = b.header.count;
+			return b.data;
+		}
+	}
+	return nullptr;
+}
+
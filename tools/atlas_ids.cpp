@@ -0,0 +1,128 @@
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include "atlas_cache.h"
+
+/*
+ * Generate a header of SpriteId constants for the sprites in an atlas so code
+ * can refer to them without looking up names at runtime. Sprite names are
+ * turned into constants by dropping the extension and converting camelCase
+ * to UPPER_SNAKE_CASE, eg. boxCoin_disabled.png becomes BOX_COIN_DISABLED.
+ * The atlas is cooked along the way, which checks it can build the perfect
+ * hash TextureAtlas::id uses for any names that are still looked up at
+ * runtime. The cache goes next to the output header so building doesn't
+ * write into the source tree.
+ * The header is always written, even if it's unchanged, so it's newer than the
+ * atlas and the build doesn't run the tool again every time
+ * Usage: atlas_ids atlas.xml out.h [namespace]
+ * The constants are put in sprites::<namespace>, which defaults to the name
+ * of the atlas document
+ */
+
+namespace {
+	std::string file_name(const std::string &file){
+		const size_t slash = file.find_last_of("/\\");
+		return slash == std::string::npos ? file : file.substr(slash + 1);
+	}
+	/*
+	 * Convert a sprite or file name to an UPPER_SNAKE_CASE identifier
+	 */
+	std::string constant_name(const std::string &name){
+		const std::string base = name.find_last_of('.') == std::string::npos
+			? name : name.substr(0, name.find_last_of('.'));
+		std::string id;
+		bool lower = false;
+		for (char c : base){
+			const unsigned char u = static_cast<unsigned char>(c);
+			if (std::isalnum(u)){
+				if (std::isupper(u) && lower){
+					id += '_';
+				}
+				id += static_cast<char>(std::toupper(u));
+				lower = std::islower(u) || std::isdigit(u);
+			}
+			else {
+				if (!id.empty() && id.back() != '_'){
+					id += '_';
+				}
+				lower = false;
+			}
+		}
+		while (!id.empty() && id.back() == '_'){
+			id.pop_back();
+		}
+		if (id.empty() || std::isdigit(static_cast<unsigned char>(id.front()))){
+			id = "SPRITE_" + id;
+		}
+		return id;
+	}
+	std::string namespace_name(const std::string &name){
+		std::string ns = constant_name(name);
+		for (char &c : ns){
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+		return ns;
+	}
+}
+
+int main(int argc, char **argv){
+	if (argc != 3 && argc != 4){
+		std::cerr << "Usage: " << argv[0] << " atlas.xml out.h [namespace]\n";
+		return 1;
+	}
+	const std::string xml = argv[1];
+	const std::string out = argv[2];
+	const std::string ns = argc == 4 ? std::string{argv[3]} : namespace_name(file_name(xml));
+	const size_t out_slash = out.find_last_of("/\\");
+	const std::string out_dir = out_slash == std::string::npos ? "." : out.substr(0, out_slash);
+	const atlas_cache::CachedAtlas atlas = atlas_cache::load(xml, out_dir);
+	if (!atlas.good()){
+		std::cerr << "Failed to load atlas " << xml << "\n";
+		return 1;
+	}
+	//Map each constant to the sprite it names, if the document has the same
+	//name twice the last one is used like TextureAtlas::id does
+	std::map<std::string, std::pair<std::string, size_t>> constants;
+	for (size_t i = 0; i < atlas.size(); ++i){
+		const std::string name = atlas.name(i);
+		const std::string id = constant_name(name);
+		auto c = constants.find(id);
+		if (c != constants.end() && c->second.first != name){
+			std::cerr << "Sprites " << c->second.first << " and " << name
+				<< " both map to the constant " << id << "\n";
+			return 1;
+		}
+		constants[id] = std::make_pair(name, i);
+	}
+	const std::string guard = constant_name(ns) + "_SPRITES_H";
+	std::ostringstream header;
+	header << "//Generated by atlas_ids from " << file_name(xml) << ", don't edit\n"
+		<< "#ifndef " << guard << "\n#define " << guard << "\n\n"
+		<< "#include <cstddef>\n#include <cstdint>\n#include \"sprite_id.h\"\n\n"
+		<< "namespace sprites {\nnamespace " << ns << " {\n"
+		<< "\t//Hash of the document the ids came from, compare with TextureAtlas::source_hash\n"
+		<< "\tconst uint64_t SOURCE_HASH = 0x" << std::hex << atlas.info().source_hash << std::dec << "ull;\n"
+		<< "\tconst size_t COUNT = " << atlas.size() << ";\n\n";
+	for (size_t i = 0; i < atlas.size(); ++i){
+		const std::string name = atlas.name(i);
+		const auto &c = constants[constant_name(name)];
+		//Skip earlier duplicates of a name, the constant goes to the last one
+		if (c.second == i){
+			header << "\tconstexpr SpriteId " << constant_name(name) << "{" << i << "}; //" << name << "\n";
+		}
+	}
+	header << "}\n}\n\n#endif\n\n";
+
+	const std::string text = header.str();
+	std::ofstream file(out, std::ios::binary | std::ios::trunc);
+	if (!file.write(text.data(), text.size())){
+		std::cerr << "Failed to write " << out << "\n";
+		return 1;
+	}
+	std::cout << xml << " -> " << out << ": " << constants.size() << " sprites\n";
+	return 0;
+}
+
@@ -0,0 +1,328 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+#include "stb_image.h"
+#include "util.h"
+
+/*
+ * Pack a directory of PNG sprites into atlas pages for TextureAtlas and
+ * TextureAtlasArray. Every page is the same size and RGBA so the pages can
+ * be loaded together as one texture array, each page gets a TexturePacker
+ * style XML descriptor next to it. Sprites are placed with the MaxRects
+ * algorithm using the best short side fit, picking the best fitting sprite
+ * out of all the remaining ones at each step, and may be turned 90 degrees
+ * clockwise to fit better
+ * Usage: atlas_pack [--size n] [--padding n] [--no-rotate] sprite_dir out_prefix
+ * writes out_prefix_0.png, out_prefix_0.xml, out_prefix_1.png, ...
+ */
+
+namespace {
+	struct Rect {
+		int x, y, w, h;
+	};
+	struct Sprite {
+		std::string name;
+		int w, h;
+		unsigned char *pixels;
+		//Where the sprite was placed
+		int page, x, y;
+		bool rotated;
+	};
+	inline bool contains(const Rect &a, const Rect &b){
+		return b.x >= a.x && b.y >= a.y && b.x + b.w <= a.x + a.w && b.y + b.h <= a.y + a.h;
+	}
+	inline bool overlaps(const Rect &a, const Rect &b){
+		return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+	}
+	/*
+	 * The free space of a page, tracked as the list of maximal free rectangles
+	 */
+	class MaxRects {
+		std::vector<Rect> free;
+
+	public:
+		MaxRects(int w, int h, int padding) : free{Rect{padding, padding, w - padding, h - padding}} {}
+		/*
+		 * Find the best spot for a w x h rect, scored by the smallest leftover
+		 * on the short then long side. Returns false if it doesn't fit anywhere
+		 */
+		bool find(int w, int h, Rect &best, int &short_side, int &long_side) const {
+			bool found = false;
+			for (const Rect &f : free){
+				if (w > f.w || h > f.h){
+					continue;
+				}
+				const int dw = f.w - w, dh = f.h - h;
+				const int s = std::min(dw, dh), l = std::max(dw, dh);
+				if (!found || s < short_side || (s == short_side && l < long_side)){
+					best = Rect{f.x, f.y, w, h};
+					short_side = s;
+					long_side = l;
+					found = true;
+				}
+			}
+			return found;
+		}
+		/*
+		 * Mark a rect as used, splitting the free rects it overlaps
+		 */
+		void place(const Rect &used){
+			std::vector<Rect> next;
+			for (const Rect &f : free){
+				if (!overlaps(f, used)){
+					next.push_back(f);
+					continue;
+				}
+				if (used.x > f.x){
+					next.push_back(Rect{f.x, f.y, used.x - f.x, f.h});
+				}
+				if (used.x + used.w < f.x + f.w){
+					next.push_back(Rect{used.x + used.w, f.y, f.x + f.w - used.x - used.w, f.h});
+				}
+				if (used.y > f.y){
+					next.push_back(Rect{f.x, f.y, f.w, used.y - f.y});
+				}
+				if (used.y + used.h < f.y + f.h){
+					next.push_back(Rect{f.x, used.y + used.h, f.w, f.y + f.h - used.y - used.h});
+				}
+			}
+			//Drop the rects that are inside another, keeping one of any duplicates
+			free.clear();
+			for (size_t i = 0; i < next.size(); ++i){
+				bool redundant = false;
+				for (size_t j = 0; j < next.size() && !redundant; ++j){
+					redundant = i != j && contains(next[j], next[i])
+						&& (!contains(next[i], next[j]) || j < i);
+				}
+				if (!redundant){
+					free.push_back(next[i]);
+				}
+			}
+		}
+	};
+
+	bool ends_with_png(const std::string &s){
+		if (s.size() < 4){
+			return false;
+		}
+		std::string ext = s.substr(s.size() - 4);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		return ext == ".png";
+	}
+	/*
+	 * Get the names of the PNG files in a directory, sorted so the output
+	 * doesn't depend on the order the file system lists them in
+	 */
+	std::vector<std::string> list_pngs(const std::string &dir){
+		std::vector<std::string> files;
+#ifdef _WIN32
+		WIN32_FIND_DATAA data;
+		HANDLE find = FindFirstFileA((dir + "\\*").c_str(), &data);
+		if (find != INVALID_HANDLE_VALUE){
+			do {
+				if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && ends_with_png(data.cFileName)){
+					files.push_back(data.cFileName);
+				}
+			} while (FindNextFileA(find, &data));
+			FindClose(find);
+		}
+#else
+		DIR *d = opendir(dir.c_str());
+		if (d){
+			for (dirent *e = readdir(d); e != nullptr; e = readdir(d)){
+				if (ends_with_png(e->d_name)){
+					files.push_back(e->d_name);
+				}
+			}
+			closedir(d);
+		}
+#endif
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+	std::string xml_escape(const std::string &s){
+		std::string out;
+		for (char c : s){
+			switch (c){
+				case '&':
+					out += "&amp;";
+					break;
+				case '<':
+					out += "&lt;";
+					break;
+				case '>':
+					out += "&gt;";
+					break;
+				case '"':
+					out += "&quot;";
+					break;
+				default:
+					out += c;
+			}
+		}
+		return out;
+	}
+	/*
+	 * Copy a sprite into the page at its placement, turning it clockwise if it's rotated
+	 */
+	void blit(const Sprite &s, std::vector<unsigned char> &page, int page_w){
+		const uint32_t *src = reinterpret_cast<const uint32_t*>(s.pixels);
+		for (int v = 0; v < s.h; ++v){
+			for (int u = 0; u < s.w; ++u){
+				const int x = s.rotated ? s.x + s.h - 1 - v : s.x + u;
+				const int y = s.rotated ? s.y + u : s.y + v;
+				std::memcpy(&page[4 * (static_cast<size_t>(y) * page_w + x)], &src[v * s.w + u], 4);
+			}
+		}
+	}
+	/*
+	 * Pack the sprites into as many size x size pages as needed, returns the
+	 * number of pages used
+	 */
+	int pack(std::vector<Sprite> &sprites, int size, int padding, bool rotate){
+		std::vector<size_t> remaining(sprites.size());
+		for (size_t i = 0; i < sprites.size(); ++i){
+			remaining[i] = i;
+		}
+		int pages = 0;
+		while (!remaining.empty()){
+			MaxRects page{size, size, padding};
+			bool placed_any = false;
+			while (!remaining.empty()){
+				size_t best = 0;
+				Rect best_rect{0, 0, 0, 0};
+				int best_short = std::numeric_limits<int>::max(), best_long = best_short;
+				bool found = false, best_rotated = false;
+				for (size_t i = 0; i < remaining.size(); ++i){
+					const Sprite &s = sprites[remaining[i]];
+					for (int r = 0; r < (rotate && s.w != s.h ? 2 : 1); ++r){
+						const int w = (r ? s.h : s.w) + padding, h = (r ? s.w : s.h) + padding;
+						Rect rect;
+						int short_side = 0, long_side = 0;
+						if (page.find(w, h, rect, short_side, long_side) && (short_side < best_short
+							|| (short_side == best_short && long_side < best_long)))
+						{
+							best = i;
+							best_rect = rect;
+							best_short = short_side;
+							best_long = long_side;
+							best_rotated = r == 1;
+							found = true;
+						}
+					}
+				}
+				if (!found){
+					break;
+				}
+				page.place(best_rect);
+				Sprite &s = sprites[remaining[best]];
+				s.page = pages;
+				s.x = best_rect.x;
+				s.y = best_rect.y;
+				s.rotated = best_rotated;
+				remaining.erase(remaining.begin() + best);
+				placed_any = true;
+			}
+			if (!placed_any){
+				std::cerr << "Error: " << sprites[remaining.front()].name << " doesn't fit on a "
+					<< size << "x" << size << " page\n";
+				return -1;
+			}
+			++pages;
+		}
+		return pages;
+	}
+}
+
+int main(int argc, char **argv){
+	int size = 1024, padding = 2;
+	bool rotate = true;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; ++i){
+		const std::string arg = argv[i];
+		if (arg == "--size" && i + 1 < argc){
+			size = std::atoi(argv[++i]);
+		}
+		else if (arg == "--padding" && i + 1 < argc){
+			padding = std::atoi(argv[++i]);
+		}
+		else if (arg == "--no-rotate"){
+			rotate = false;
+		}
+		else {
+			args.push_back(arg);
+		}
+	}
+	if (args.size() != 2 || size <= 0 || padding < 0){
+		std::cerr << "Usage: " << argv[0] << " [--size n] [--padding n] [--no-rotate] sprite_dir out_prefix\n";
+		return 1;
+	}
+	const std::string dir = args[0] + util::PATH_SEP, prefix = args[1];
+	const std::vector<std::string> files = list_pngs(args[0]);
+	if (files.empty()){
+		std::cerr << "Error: no PNG files found in " << args[0] << "\n";
+		return 1;
+	}
+	std::vector<Sprite> sprites;
+	for (const std::string &f : files){
+		int w, h, n;
+		unsigned char *pixels = stbi_load((dir + f).c_str(), &w, &h, &n, 4);
+		if (!pixels){
+			std::cerr << "Failed to load image " << dir + f << ": " << stbi_failure_reason() << "\n";
+			return 1;
+		}
+		sprites.push_back(Sprite{f, w, h, pixels, -1, 0, 0, false});
+	}
+	const int pages = pack(sprites, size, padding, rotate);
+	if (pages < 0){
+		return 1;
+	}
+	//The base name of the prefix, images are referenced relative to the descriptor
+	const size_t sep = prefix.find_last_of("/\\");
+	const std::string base = sep == std::string::npos ? prefix : prefix.substr(sep + 1);
+	int failed = 0;
+	for (int p = 0; p < pages; ++p){
+		const std::string name = "_" + std::to_string(p);
+		std::vector<unsigned char> image(4 * static_cast<size_t>(size) * size, 0);
+		std::ofstream xml(prefix + name + ".xml");
+		xml << "<TextureAtlas imagePath=\"" << xml_escape(base + name + ".png") << "\">\n";
+		size_t used = 0, count = 0;
+		for (const Sprite &s : sprites){
+			if (s.page != p){
+				continue;
+			}
+			blit(s, image, size);
+			xml << "\t<sprite n=\"" << xml_escape(s.name) << "\" x=\"" << s.x << "\" y=\"" << s.y
+				<< "\" w=\"" << s.w << "\" h=\"" << s.h << "\"" << (s.rotated ? " r=\"y\"" : "") << "/>\n";
+			used += static_cast<size_t>(s.w) * s.h;
+			++count;
+		}
+		xml << "</TextureAtlas>\n";
+		if (!xml || !stbi_write_png((prefix + name + ".png").c_str(), size, size, 4, image.data(), 4 * size)){
+			std::cerr << "Failed to write page " << prefix + name << "\n";
+			++failed;
+			continue;
+		}
+		std::cout << prefix + name << ".png: " << count << " sprites, "
+			<< 100.0 * used / (static_cast<double>(size) * size) << "% used\n";
+	}
+	for (Sprite &s : sprites){
+		stbi_image_free(s.pixels);
+	}
+	return failed == 0 ? 0 : 1;
+}
+
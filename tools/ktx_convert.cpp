@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+#include "stb_image.h"
+#include "gl_core_3_3.h"
+#include "util.h"
+#include "ktx.h"
+
+/*
+ * Convert an image to a KTX file with a full mip chain, optionally compressed
+ * to BC1 (opaque RGB), BC3 (RGBA), BC4 (single channel) or BC5 (two channels).
+ * The image is flipped so its first row is the bottom, like util::load_texture
+ * does for PNGs, so atlas uvs are the same for either file
+ * Usage: ktx_convert [--format rgba8|bc1|bc3|bc4|bc5] [--no-mips] in.png out.ktx
+ */
+
+namespace {
+	struct Format {
+		const char *name;
+		GLenum internal_format, base_format;
+		size_t block_bytes;
+	};
+	const Format FORMATS[] = {
+		{"rgba8", GL_RGBA8, GL_RGBA, 0},
+		{"bc1", ktx::COMPRESSED_RGB_S3TC_DXT1, GL_RGB, 8},
+		{"bc3", ktx::COMPRESSED_RGBA_S3TC_DXT5, GL_RGBA, 16},
+		{"bc4", GL_COMPRESSED_RED_RGTC1, GL_RED, 8},
+		{"bc5", GL_COMPRESSED_RG_RGTC2, GL_RG, 16}
+	};
+
+	/*
+	 * Downsample an RGBA image by half with a box filter, odd rows and
+	 * columns on the edge are folded into the last texel
+	 */
+	std::vector<unsigned char> downsample(const std::vector<unsigned char> &img, size_t w, size_t h,
+		size_t &nw, size_t &nh)
+	{
+		nw = std::max(w / 2, size_t{1});
+		nh = std::max(h / 2, size_t{1});
+		std::vector<unsigned char> out(nw * nh * 4);
+		for (size_t y = 0; y < nh; ++y){
+			const size_t y0 = std::min(2 * y, h - 1), y1 = y + 1 == nh ? h - 1 : std::min(2 * y + 1, h - 1);
+			for (size_t x = 0; x < nw; ++x){
+				const size_t x0 = std::min(2 * x, w - 1), x1 = x + 1 == nw ? w - 1 : std::min(2 * x + 1, w - 1);
+				for (size_t c = 0; c < 4; ++c){
+					unsigned sum = 0, n = 0;
+					for (size_t sy = y0; sy <= y1; ++sy){
+						for (size_t sx = x0; sx <= x1; ++sx, ++n){
+							sum += img[(sy * w + sx) * 4 + c];
+						}
+					}
+					out[(y * nw + x) * 4 + c] = static_cast<unsigned char>((sum + n / 2) / n);
+				}
+			}
+		}
+		return out;
+	}
+	/*
+	 * Compress an RGBA image to the format, blocks hanging off the edge of the
+	 * image repeat its last row and column
+	 */
+	std::vector<unsigned char> compress(const std::vector<unsigned char> &img, size_t w, size_t h,
+		const Format &fmt)
+	{
+		const size_t bw = (w + 3) / 4, bh = (h + 3) / 4;
+		std::vector<unsigned char> out(bw * bh * fmt.block_bytes);
+		unsigned char rgba[16 * 4], channels[16 * 2];
+		for (size_t by = 0; by < bh; ++by){
+			for (size_t bx = 0; bx < bw; ++bx){
+				for (size_t i = 0; i < 16; ++i){
+					const size_t x = std::min(bx * 4 + i % 4, w - 1), y = std::min(by * 4 + i / 4, h - 1);
+					std::memcpy(&rgba[i * 4], &img[(y * w + x) * 4], 4);
+				}
+				unsigned char *dst = &out[(by * bw + bx) * fmt.block_bytes];
+				switch (fmt.internal_format){
+					case GL_COMPRESSED_RED_RGTC1:
+						for (size_t i = 0; i < 16; ++i){
+							channels[i] = rgba[i * 4];
+						}
+						stb_compress_bc4_block(dst, channels);
+						break;
+					case GL_COMPRESSED_RG_RGTC2:
+						for (size_t i = 0; i < 16; ++i){
+							channels[i * 2] = rgba[i * 4];
+							channels[i * 2 + 1] = rgba[i * 4 + 1];
+						}
+						stb_compress_bc5_block(dst, channels);
+						break;
+					default:
+						stb_compress_dxt_block(dst, rgba, fmt.block_bytes == 16, STB_DXT_HIGHQUAL);
+				}
+			}
+		}
+		return out;
+	}
+}
+
+int main(int argc, char **argv){
+	const Format *fmt = &FORMATS[0];
+	bool mips = true;
+	std::vector<std::string> args;
+	for (int i = 1; i < argc; ++i){
+		const std::string arg = argv[i];
+		if (arg == "--format" && i + 1 < argc){
+			const std::string name = argv[++i];
+			fmt = nullptr;
+			for (const Format &f : FORMATS){
+				if (name == f.name){
+					fmt = &f;
+				}
+			}
+			if (!fmt){
+				std::cerr << "Unknown format " << name << "\n";
+				return 1;
+			}
+		}
+		else if (arg == "--no-mips"){
+			mips = false;
+		}
+		else {
+			args.push_back(arg);
+		}
+	}
+	if (args.size() != 2){
+		std::cerr << "Usage: " << argv[0] << " [--format rgba8|bc1|bc3|bc4|bc5] [--no-mips] in.png out.ktx\n";
+		return 1;
+	}
+	int x, y, n;
+	unsigned char *pixels = stbi_load(args[0].c_str(), &x, &y, &n, 4);
+	if (!pixels){
+		std::cerr << "Failed to load image " << args[0] << ": " << stbi_failure_reason() << "\n";
+		return 1;
+	}
+	size_t w = x, h = y;
+	std::vector<unsigned char> level{pixels, pixels + w * h * 4};
+	stbi_image_free(pixels);
+	util::flip_rows(level.data(), w * 4, h);
+
+	//Build every level first since the KTX levels point into their data
+	std::vector<std::vector<unsigned char>> data;
+	ktx::Image img{fmt->block_bytes ? 0u : GLenum{GL_UNSIGNED_BYTE}, fmt->block_bytes ? 0u : GLenum{GL_RGBA},
+		fmt->internal_format, fmt->base_format, w, h, {}};
+	while (true){
+		data.push_back(fmt->block_bytes ? compress(level, w, h, *fmt) : level);
+		img.levels.push_back(ktx::Level{w, h, data.back().size(), nullptr});
+		if (!mips || (w == 1 && h == 1)){
+			break;
+		}
+		level = downsample(level, w, h, w, h);
+	}
+	for (size_t i = 0; i < data.size(); ++i){
+		img.levels[i].data = data[i].data();
+	}
+	if (!ktx::write(args[1], img)){
+		std::cerr << "Failed to write " << args[1] << "\n";
+		return 1;
+	}
+	size_t bytes = 0;
+	for (const ktx::Level &l : img.levels){
+		bytes += l.size;
+	}
+	std::cout << args[1] << ": " << fmt->name << ", " << img.levels.size() << " levels, "
+		<< bytes << " bytes\n";
+	return 0;
+}
+
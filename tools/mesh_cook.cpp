@@ -0,0 +1,37 @@
+#include <iostream>
+#include <string>
+#include "util.h"
+#include "mesh_cache.h"
+
+/*
+ * Build the mesh caches for OBJ models ahead of time so the game doesn't
+ * have to parse them on first load
+ * Usage: mesh_cook model.obj [model.obj...]
+ *        mesh_cook -o out.mesh model.obj
+ */
+int main(int argc, char **argv){
+	if (argc < 2){
+		std::cerr << "Usage: " << argv[0] << " model.obj [model.obj...]\n"
+			<< "       " << argv[0] << " -o out.mesh model.obj\n";
+		return 1;
+	}
+	if (std::string{argv[1]} == "-o"){
+		if (argc != 4){
+			std::cerr << "-o takes an output file and a single model\n";
+			return 1;
+		}
+		return mesh_cache::cook(argv[3], argv[2]) ? 0 : 1;
+	}
+	int failed = 0;
+	for (int i = 1; i < argc; ++i){
+		const std::string cache = util::cache_path(argv[i], mesh_cache::EXTENSION);
+		if (mesh_cache::cook(argv[i], cache)){
+			std::cout << argv[i] << " -> " << cache << "\n";
+		}
+		else {
+			++failed;
+		}
+	}
+	return failed == 0 ? 0 : 1;
+}
+